@@ -29,7 +29,8 @@
 // ********************************************************************
 
 #ifdef G4MULTITHREADED
-#include "G4MTRunManager.hh"
+#include "SchedulingRunManager.hh"
+#include "G4Threading.hh"
 #else
 #include "G4RunManager.hh"
 #endif
@@ -37,10 +38,14 @@
 #include "G4UImanager.hh"
 #include "Randomize.hh"
 
+#include <cstdlib>
+
 // Simulation Files
 #include "DetectorConstruction.hh"
 #include "PhysicsList.hh"
 #include "ActionInitialization.hh"
+#include "CheckpointManager.hh"
+#include "InitTimer.hh"
 
 #ifdef G4VIS_USE
 #include "G4VisExecutive.hh"
@@ -54,13 +59,53 @@
 
 int main(int argc,char** argv)
 {
+	// Usage: AdEPTCubeSat [--threads <n>] [--pin] [--resume] [--shard <index> <count> | --range <first> <count>] [macro]
+	// Sharding applies to the runs started with /AdEPTCubeSat/checkpoint/beamOn
+	G4int numberOfThreads = 0;
+	G4bool pinThreads = false;
+	G4bool resume = false;
+	G4int shardIndex = 0, shardCount = 0;
+	G4long rangeFirst = 0, rangeCount = -1;
+	G4String macroFile;
+	for (G4int i = 1; i < argc; ++i) {
+		G4String arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc) {
+			numberOfThreads = std::atoi(argv[++i]);
+		} else if (arg == "--pin") {
+			pinThreads = true;
+		} else if (arg == "--resume") {
+			resume = true;
+		} else if (arg == "--shard" && i + 2 < argc) {
+			shardIndex = std::atoi(argv[++i]);
+			shardCount = std::atoi(argv[++i]);
+		} else if (arg == "--range" && i + 2 < argc) {
+			rangeFirst = std::atol(argv[++i]);
+			rangeCount = std::atol(argv[++i]);
+		} else if (arg.substr(0, 2) == "--") {
+			G4cerr << "Unknown or incomplete option " << arg << G4endl;
+			return 1;
+		} else {
+			macroFile = arg;
+		}
+	}
+	if (shardCount < 0 || (shardCount > 0 && (shardIndex < 0 || shardIndex >= shardCount)) || rangeFirst < 0) {
+		G4cerr << "Invalid shard or range" << G4endl;
+		return 1;
+	}
+	
+	// Timing of the initialization phases, reported before the first event
+	InitTimer* initTimer = new InitTimer();
+	
   	// Choose the Random engine
   	G4Random::setTheEngine(new CLHEP::RanecuEngine);
      
   	// Construct the default run manager	
 	#ifdef G4MULTITHREADED
-  		G4MTRunManager* runManager = new G4MTRunManager;
-		runManager->SetNumberOfThreads(8);
+  		SchedulingRunManager* runManager = new SchedulingRunManager;
+		// One thread per core unless given; G4FORCENUMBEROFTHREADS still overrides
+		runManager->SetNumberOfThreads(numberOfThreads > 0 ? numberOfThreads : G4Threading::G4GetNumberOfCores());
+		// Bind the worker threads to cores
+		if (pinThreads) runManager->SetPinAffinity(1);
 	#else
   		G4RunManager* runManager = new G4RunManager;
 	#endif
@@ -75,6 +120,11 @@ int main(int argc,char** argv)
 	
 	// Set user action classes
 	runManager->SetUserInitialization(new ActionInitialization(detector)); 
+	
+	// Segmented runs with checkpoints (/AdEPTCubeSat/checkpoint/)
+	CheckpointManager* checkpointManager = new CheckpointManager(resume);
+	if (shardCount > 0) checkpointManager->SetShard(shardIndex, shardCount);
+	else if (rangeCount >= 0) checkpointManager->SetRange(rangeFirst, rangeCount);
   
 	#ifdef G4VIS_USE
   	// Initialize visualization
@@ -87,11 +137,10 @@ int main(int argc,char** argv)
   	// Get the pointer to the User Interface manager
   	G4UImanager* UImanager = G4UImanager::GetUIpointer();
 
-  	if (argc!=1)   // batch mode
+  	if (!macroFile.empty())   // batch mode
     {
     	G4String command = "/control/execute ";
-      	G4String fileName = argv[1];
-      	UImanager->ApplyCommand(command+fileName);
+      	UImanager->ApplyCommand(command+macroFile);
     	}
   	else
     	{  // interactive mode : define UI session
@@ -113,6 +162,8 @@ int main(int argc,char** argv)
 	#ifdef G4VIS_USE
   		delete visManager;
 	#endif
+  	delete initTimer;
+  	delete checkpointManager;
   	delete runManager;
 
   	return 0;
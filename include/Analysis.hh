@@ -8,4 +8,68 @@
 // #include "g4xml.hh"
 #include "g4csv.hh"
 
-#endif
\ No newline at end of file
+#include "ColumnarFile.hh"
+#include "RowWriter.hh"
+
+// Per-event output of the Sensitive Gas Volume. The format is selected at run
+// time with /AdEPTCubeSat/output/format: "csv" writes the Analysis Manager
+// ntuple, "binary" writes a ColumnarWriter file (.aecol) per worker thread.
+// With /AdEPTCubeSat/output/merge the master writes one file per run instead.
+namespace Analysis
+{
+	enum OutputFormat { kCsv = 0, kBinary };
+
+	struct NtupleColumn
+	{
+		const char* name;
+		Columnar::ColumnType type;
+	};
+
+	// Column layout shared by both formats
+	enum ColumnIndex {
+		kEDep = 0, kEDepPositron, kEDepElectron, kEDepTriton, kEDepProton,
+		kTrackLength,
+		kSecondaryElectrons, kSecondaryPhotons, kSecondaryPositrons, kSecondaryTritons, kSecondaryProtons,
+		kEventID,
+		kWeight,
+		kPrimaryEnergy,
+		kNumColumns
+	};
+
+	constexpr NtupleColumn kNtupleColumns[kNumColumns] = {
+		{ "eDep_PVSensitiveGas",			Columnar::kDouble },
+		{ "eDep_PVSensitiveGas_Positron",	Columnar::kDouble },
+		{ "eDep_PVSensitiveGas_Electron",	Columnar::kDouble },
+		{ "eDep_PVSensitiveGas_Triton",		Columnar::kDouble },
+		{ "eDep_PVSensitiveGas_Proton",		Columnar::kDouble },
+		{ "trackLength_PVSensitiveGas",		Columnar::kDouble },
+		{ "Secondary Electrons",			Columnar::kFloat },
+		{ "Secondary Photons",				Columnar::kFloat },
+		{ "Secondary Positrons",			Columnar::kFloat },
+		{ "Secondary Tritons",				Columnar::kFloat },
+		{ "Secondary Protons",				Columnar::kFloat },
+		{ "eventID",						Columnar::kInt },
+		{ "weight",							Columnar::kDouble },
+		{ "primaryEnergy",					Columnar::kDouble }
+	};
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Rows written to the ntuple of the thread-local Analysis Manager
+class AnalysisRowWriter : public RowWriter
+{
+	public:
+		virtual bool Open(const std::string&) { return G4AnalysisManager::Instance()->OpenFile(); }
+		virtual void Fill(const double* row)
+		{
+			G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+			for (G4int i = 0; i < Analysis::kNumColumns; ++i) {
+				analysisManager->FillNtupleDColumn(i, row[i]);
+			}
+			analysisManager->AddNtupleRow();
+		}
+		virtual void Close() { G4AnalysisManager::Instance()->CloseFile(); }
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef AsyncRowWriter_h
+#define AsyncRowWriter_h 1
+
+#include "RowWriter.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Moves the file output of one producing thread to a dedicated writer thread.
+// Rows are collected into blocks which pass through a single-producer/
+// single-consumer ring; the writer thread hands every row to the target
+// writer and returns the emptied block to its ring slot, so after the first
+// few blocks no memory is allocated. When all slots are full the producer
+// waits for the writer (back-pressure) and the waiting time is reported by
+// GetBlockedTime. The ring indices are lock-free; the mutex and the condition
+// variables are only used to sleep while waiting, once per block, so neither
+// a full ring nor an idle writer thread uses any CPU. Close writes the partial
+// block, waits until the ring is empty and closes the target, as does the
+// destructor.
+//
+// Compression is left to the target, e.g. ColumnarWriter.
+
+class AsyncRowWriter : public RowWriter
+{
+	public:
+		// Constructor, takes ownership of the target
+		AsyncRowWriter(RowWriter* target, size_t numColumns, size_t blockRows = 4096, size_t numBlocks = 4);
+		// Destructor
+		virtual ~AsyncRowWriter();
+
+		// Methods
+		virtual bool Open(const std::string& fileName);
+		virtual void Fill(const double* row);
+		virtual void Close();
+
+		virtual double GetBlockedTime() const { return fBlockedTime; }
+
+	private:
+		void Push();
+		void WriterLoop();
+		void Notify(std::condition_variable& condition);
+
+		RowWriter* fTarget;
+		size_t fNumColumns;
+		size_t fBlockRows;
+
+		// Block being filled by the producer
+		std::vector<double> fBlock;
+
+		// Ring of blocks; fHead is only written by the producer, fTail only by the writer
+		std::vector< std::vector<double> > fSlots;
+		std::atomic<size_t> fHead;
+		std::atomic<size_t> fTail;
+		std::atomic<bool> fStop;
+
+		// Wake-ups of a waiting producer (slot freed) or an idle writer (block ready)
+		std::mutex fWaitMutex;
+		std::condition_variable fSlotFreed;
+		std::condition_variable fBlockReady;
+
+		std::thread fWriter;
+		double fBlockedTime;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Emulates a slow output device by sleeping for a fixed time per written row,
+// in sleeps of at least a millisecond.
+// Used to measure how sensitive the event rate is to the output latency.
+
+class ThrottledRowWriter : public RowWriter
+{
+	public:
+		// Constructor, takes ownership of the target
+		ThrottledRowWriter(RowWriter* target, double delayPerRow);
+		// Destructor
+		virtual ~ThrottledRowWriter();
+
+		// Methods
+		virtual bool Open(const std::string& fileName) { return fTarget->Open(fileName); }
+		virtual void Fill(const double* row);
+		virtual void Close() { fTarget->Close(); }
+
+		virtual double GetBlockedTime() const { return fBlockedTime + fTarget->GetBlockedTime(); }
+
+	private:
+		RowWriter* fTarget;
+		double fDelayPerRow;		// Seconds
+		double fPendingDelay;		// Seconds not slept yet
+		double fBlockedTime;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef BatchPolicy_h
+#define BatchPolicy_h 1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Sizes the batches of events handed to the worker threads. The cost of an
+// event varies by orders of magnitude (a low energy gamma missing the gas
+// against a GeV proton shower), so a fixed batch size either lets threads
+// idle at the end of a run or contends for every event. Batches are
+//
+//   min(remaining/(2*threads), targetBatchTime/eventCost)
+//
+// i.e. guided self-scheduling that shrinks towards one event at the end of
+// the run, capped so that a batch takes about targetBatchTime on one thread.
+// The event cost is a running average of the measured batch times; until the
+// first measurement every thread gets a single event.
+//
+// This file only depends on the C++ standard library so that the scheduling
+// benchmark builds without Geant4.
+
+class BatchPolicy
+{
+	public:
+		// Constructor
+		BatchPolicy(double targetBatchTime = 0.2);
+
+		// Methods
+		void SetTargetBatchTime(double seconds) { fTargetBatchTime = seconds; }
+		double GetTargetBatchTime() const { return fTargetBatchTime; }
+
+		void BeginRun(long events, int threads);
+
+		// Events of the next batch with the given number of events left
+		long NextBatch(long remaining) const;
+		// Number of equal tasks a run of the given number of events is split into
+		long NumberOfTasks(long events) const;
+
+		// Wall time of a batch of events processed by one thread
+		void AddSample(double seconds, long events);
+		// Seconds per event on one thread, zero before the first sample
+		double GetEventCost() const { return fSampleEvents > 0. ? fSampleTime/fSampleEvents : 0.; }
+
+	private:
+		double fTargetBatchTime;
+		int fThreads;
+
+		// Decaying sums of the measured batches
+		double fSampleTime;
+		double fSampleEvents;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef CheckpointManager_h
+#define CheckpointManager_h 1
+
+#include "globals.hh"
+#include "GasHistograms.hh"
+
+class G4GenericMessenger;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Master-side driver of long runs in restartable segments. A segmented run
+// of N events is a sequence of Geant4 runs of at most SegmentSize events with
+// consecutive event numbers; since every event is seeded from the master seed
+// and its event number, the segments together equal one run of N events.
+// Segment k writes its output under "<fileName>_s<k>". After each complete
+// segment the accumulated histograms and the position in the run are saved
+// to "<fileName>.ckpt", and the accumulated histograms to "<fileName>_hist.csv".
+//
+// SIGTERM and SIGINT request a stop: the worker threads abort at their next
+// event (see IsStopRequested), the interrupted segment ends normally so that
+// its files are flushed and closed, but it is not counted in the checkpoint.
+// With --resume every segmented run of the job loads its own checkpoint: a
+// run whose checkpoint matches its events and segment size continues after
+// the last complete segment and rewrites the interrupted one, which gives
+// identical events, and a run whose checkpoint is complete is skipped.
+//
+// A process can be limited to a slice of the segmented run, either shard i
+// of n (events [N*i/n, N*(i+1)/n)) or an explicit range of event numbers.
+// Its files are then named "<fileName>_shard<i>" or "<fileName>_first<first>";
+// the shardmerge tool combines the slices into the result of one process.
+
+class CheckpointManager
+{
+	public:
+		// Constructor
+		CheckpointManager(G4bool resume = false);
+		// Destructor
+		~CheckpointManager();
+
+		// Methods
+		// Process numberOfEvents events in checkpointed segments
+		void BeamOn(G4int numberOfEvents);
+
+		// Process only a slice of the events of each segmented run
+		void SetShard(G4int index, G4int count);
+		void SetRange(G4long first, G4long count);
+
+		// Set by the signal handler, polled by the worker threads per event
+		static G4bool IsStopRequested();
+
+	private:
+		// Define commands to control the segmented runs
+		void DefineCommands();
+
+		G4bool SaveCheckpoint(const G4String& fileName) const;
+		G4bool LoadCheckpoint(const G4String& fileName);
+
+		G4GenericMessenger* fMessenger;
+		G4bool fResume;
+		G4int fSegmentSize;
+		G4long fFirstEvent;
+
+		// Slice of this process; a shard count of zero means no sharding
+		G4int fShardIndex;
+		G4int fShardCount;
+		G4long fRangeFirst;
+		G4long fRangeCount;		// Negative for no range
+
+		// Position in the current segmented run
+		G4String fBaseName;
+		G4long fSliceFirst;		// Event number of the first event of this process
+		G4long fTotalEvents;
+		G4int fSegmentsDone;
+		G4long fEventsDone;
+		G4long fSourceRays;
+		G4long fMasterSeed;
+		G4String fEngineName;
+		GasHistograms fHistograms;
+};
+
+#endif
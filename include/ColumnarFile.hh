@@ -0,0 +1,122 @@
+#ifndef ColumnarFile_h
+#define ColumnarFile_h 1
+
+#include "RowWriter.hh"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Self-describing binary columnar file used as an alternative to the CSV
+// ntuple output. Layout (little-endian):
+//
+//   header   "AECOL001", column count, per column: type, name
+//   chunks   per column: codec, byte count, encoded column values
+//   footer   chunk count, per chunk: file offset, rows, bytes; total rows
+//   trailer  footer offset, "AECOLEND"
+//
+// Each chunk holds up to ChunkSize rows stored column by column. A column
+// block is either raw or byte-shuffled and zero-run-length encoded, whichever
+// is smaller. The footer gives random access to every chunk.
+//
+// This file only depends on the C++ standard library so that the reader and
+// the conversion tools build without Geant4.
+
+namespace Columnar
+{
+	enum ColumnType { kFloat = 0, kDouble = 1, kInt = 2 };
+	enum Codec { kRaw = 0, kShuffleZeroRLE = 1 };
+
+	struct Column
+	{
+		std::string name;
+		ColumnType type;
+	};
+
+	struct ChunkInfo
+	{
+		uint64_t offset;
+		uint32_t rows;
+		uint32_t bytes;
+	};
+
+	// Width in bytes of one value of the given type
+	size_t TypeSize(ColumnType type);
+
+	// Block codecs, exposed for the reader and the tools
+	void Encode(const std::vector<unsigned char>& values, size_t width, std::vector<unsigned char>& out);
+	bool Decode(const unsigned char* in, size_t size, size_t width, size_t count, std::vector<unsigned char>& out);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class ColumnarWriter : public RowWriter
+{
+	public:
+		// Constructor
+		ColumnarWriter();
+		// Destructor
+		virtual ~ColumnarWriter();
+
+		// Methods
+		void AddColumn(const std::string& name, Columnar::ColumnType type);
+		void SetChunkSize(size_t rows) { fChunkSize = rows > 0 ? rows : 1; }
+
+		virtual bool Open(const std::string& fileName);
+		// One value per column in the order the columns were added
+		virtual void Fill(const double* row);
+		virtual void Close();
+
+		bool IsOpen() const { return fFile != 0; }
+		uint64_t GetNumberOfRows() const { return fTotalRows; }
+
+	private:
+		void FlushChunk();
+
+		std::vector<Columnar::Column> fColumns;
+		std::vector< std::vector<unsigned char> > fBuffers;
+		std::vector<Columnar::ChunkInfo> fChunks;
+		std::vector<unsigned char> fEncoded;
+
+		FILE* fFile;
+		uint64_t fOffset;
+		size_t fChunkSize;
+		size_t fRowsInChunk;
+		uint64_t fTotalRows;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class ColumnarReader
+{
+	public:
+		// Constructor
+		ColumnarReader();
+		// Destructor
+		~ColumnarReader();
+
+		// Methods
+		bool Open(const std::string& fileName);
+		void Close();
+
+		const std::vector<Columnar::Column>& GetColumns() const { return fColumns; }
+		const std::vector<Columnar::ChunkInfo>& GetChunks() const { return fChunks; }
+		uint64_t GetNumberOfRows() const { return fTotalRows; }
+
+		// Decode one chunk; columns[i][row] holds the value of column i
+		bool ReadChunk(size_t chunk, std::vector< std::vector<double> >& columns);
+
+	private:
+		std::vector<Columnar::Column> fColumns;
+		std::vector<Columnar::ChunkInfo> fChunks;
+		std::vector<unsigned char> fBlock;
+		std::vector<unsigned char> fDecoded;
+
+		FILE* fFile;
+		uint64_t fTotalRows;
+};
+
+#endif
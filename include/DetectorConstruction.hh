@@ -3,12 +3,14 @@
 
 #include "G4VUserDetectorConstruction.hh"
 #include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
 
 class G4VPhysicalVolume;
 class G4LogicalVolume;
 class G4Material;
 class G4GenericMessenger;
-class G4ProductionCuts;
+class OverlapChecker;
 
 class DetectorConstruction : public G4VUserDetectorConstruction
 {
@@ -27,11 +29,38 @@ class DetectorConstruction : public G4VUserDetectorConstruction
     
   public:
     // Set Methods
+    // After /run/initialize the PCBs, the MWD, the rotation and the cutouts
+    // of the boxes vessel are changed in place, the Boolean vessel is rebuilt
     void SetDetectorAngle(G4double val);
+    void SetSideCutDepth(G4double val);
+    void SetTopCutDepth(G4double val);
+    void SetPCBThickness(G4double val);
+    void SetCapPCBThickness(G4double val);
+    void SetMWDThickness(G4double val);
     
     // Get Methods
     G4double GetDetectorAngle();
     
+    // Axis-aligned box around the pressure vessel, which contains every
+    // volume except the World, including the rotation of the vessel
+    void GetEnvelope(G4ThreeVector& lower, G4ThreeVector& upper) const;
+    
+    // Representation of the pressure vessel and its gas, "boolean" or "boxes"
+    void SetVesselModel(const G4String& model);
+    const G4String& GetVesselModel() const { return fVesselModel; }
+    
+    G4LogicalVolume* GetPressureVesselLogical() const { return PVLogical; }
+    G4LogicalVolume* GetGasLogical() const { return PVGasLogical; }
+    G4LogicalVolume* GetSensitiveGasLogical() const { return PVSensitiveGasLogical; }
+    
+    // Gas of the pressure vessel and the sensitive volume, one of the gases
+    // of DefineMaterials at the given pressure and temperature. After
+    // /run/initialize only the couples of the changed gas are rebuilt
+    void SetGas(const G4String& name);
+    void SetGasPressure(G4double pressure);
+    void SetGasTemperature(G4double temperature);
+    const G4Material* GetGasMaterial() const { return fMatGas; }
+    
   private:
     // Defines all the detector materials
     void DefineMaterials();
@@ -39,8 +68,36 @@ class DetectorConstruction : public G4VUserDetectorConstruction
     // Define commands to change the geometry
     void DefineCommands();
     
+    // Pressure vessel with its gas volume, placed in the World
+    void ConstructBooleanVessel();
+    void ConstructBoxVessel();
+    
+    // Positions of the boards along z, in the gas or, for the MWD, in the
+    // bottom PCB
+    G4double GetTopPCBZ() const;
+    G4double GetBottomPCBZ() const;
+    G4double GetCapPCBZ() const;
+    G4double GetMWDZ() const;
+    
+    // World half lengths, large enough for the rotated vessel
+    G4ThreeVector GetWorldHalfLengths() const;
+    void UpdateEnvelope();
+    
+    // Applies a changed parameter to the built geometry: in place followed
+    // by GeometryHasBeenModified, or by a rebuild of the whole geometry
+    void ApplyGeometryChange(G4bool rebuild);
+    void UpdatePlacements();
+    G4bool IsInRange(const G4String& name, G4double value, G4double lower, G4double upper) const;
+    
+    // Finds or creates the gas at fGasPressure and fGasTemperature and
+    // applies it to the gas volumes
+    void ApplyGas();
+    
     G4GenericMessenger* fMessenger;
+    G4GenericMessenger* fGasMessenger;
     G4bool  fCheckOverlaps;
+    G4String fVesselModel;
+    OverlapChecker* fOverlapChecker;
     
     // Standard Materials
     G4Material* fMatWorld;
@@ -49,6 +106,11 @@ class DetectorConstruction : public G4VUserDetectorConstruction
     G4Material* fMatPCB;
     G4Material* fMatMWD;
     
+    // Gas selection
+    G4String fGasName;
+    G4double fGasPressure;
+    G4double fGasTemperature;
+    
     // Logical Volumes
     G4LogicalVolume* WorldLogical;
     G4LogicalVolume* PVLogical;
@@ -143,7 +205,9 @@ class DetectorConstruction : public G4VUserDetectorConstruction
     
 	  // Rotation Angles
 	  G4double rotX;
-    G4ProductionCuts*  fTrackerCuts;
+	  G4RotationMatrix* fVesselRotation;	// Frame rotation of the vessel placement
+	  G4ThreeVector fEnvelopeLower;
+	  G4ThreeVector fEnvelopeUpper;
     
 };
 
@@ -0,0 +1,140 @@
+#ifndef GasBranches_h
+#define GasBranches_h 1
+
+#include "G4VUserTrackInformation.hh"
+#include "GasEventRecord.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4Step;
+class G4Track;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Branch of the event a track belongs to; tracks without it are in branch 0
+
+class GasBranchInfo : public G4VUserTrackInformation
+{
+	public:
+		GasBranchInfo(G4int branch) : G4VUserTrackInformation(), fBranch(branch) {}
+		virtual ~GasBranchInfo() {}
+
+		virtual void Print() const {}
+
+		G4int GetBranch() const { return fBranch; }
+		void SetBranch(G4int branch) { fBranch = branch; }
+
+	private:
+		G4int fBranch;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Gas totals of one event, kept per branch of its history so that biased
+// events can be scored as separate weighted outcomes.
+//
+// Without biasing every track has the same weight and the whole event is
+// branch 0. Every change of the weight of a track is a branching point:
+// a split into copies, a forced-collision clone, a Russian roulette
+// survival or the weight lost to implicit capture. The track and its copies
+// continue in new branches, each an alternative outcome of the history
+// from that point on, while the deposits already made in the branch and
+// those of the secondaries created before the point are shared by all of
+// them. A branch whose tracks have neither deposited, nor branched, nor been
+// joined by a secondary has nothing to share, so a weight change there is
+// only applied to the branch.
+//
+// Resolve turns the tree into weighted entries, each with the deposits of
+// one outcome. The alternatives of a point, with the weights w_c of their
+// branches and w_P of the track before the point, contribute the fraction
+// w_c/w_P each; the rest, e.g. the captures not followed by implicit
+// capture, ends the history at the point and keeps only the shared
+// deposits. Points of independent tracks in a branch combine as all pairs
+// of their outcomes. The expectation of every histogram of the entries is
+// that of the analog event, including the pulse-height spectra. Entries of
+// equal totals are merged; after a roulette survival the merged weight of
+// the shared deposits can be negative, which the kills average out.
+
+class GasBranches
+{
+	public:
+		// A weighted outcome of the event
+		struct Entry
+		{
+			GasEventRecord totals;
+			G4double weight;
+		};
+
+		// Constructor
+		GasBranches();
+		// Destructor
+		~GasBranches();
+
+		// Start of an event
+		void Reset();
+
+		// Branch of the track of a step after the weight change and the clones
+		// of the step, which also assigns the new secondaries of the step to
+		// it. Repeated calls for the same step return the same branch
+		G4int Follow(const G4Step* step);
+
+		// The track of the last followed step was set to a new weight
+		void Reweight(G4Track* track);
+		// The track of the last followed step was split into itself and the
+		// copies, which were added to its secondaries after the step
+		void Split(G4Track* track, const std::vector<G4Track*>& copies);
+
+		GasEventRecord& GetTotals(G4int branch) { fTouched = true; return fBranches[branch].totals; }
+
+		// Something was scored in the event
+		G4bool IsTouched() const { return fTouched; }
+
+		// Weighted outcomes of the event. Returns false, with one entry of
+		// all deposits at their mean weight, when the outcomes exceed
+		// kMaxEntries
+		G4bool Resolve(std::vector<Entry>& entries) const;
+
+		static const size_t kMaxEntries = 4096;
+
+	private:
+		struct Branch
+		{
+			G4double weight;		// Weight of the tracks of the branch
+			G4bool shared;			// Joined by a secondary
+			G4int firstPoint;
+			G4int lastPoint;
+			GasEventRecord totals;
+		};
+
+		struct Point
+		{
+			G4double weight;		// Weight of the track before the point
+			G4int firstChild;		// Branches of the alternatives, consecutive
+			G4int numChildren;
+			G4int nextPoint;		// Next point in the same branch
+		};
+
+		G4int AddPoint(G4int branch, G4double weight);
+		G4int AddChild(G4int point, G4double weight);
+		G4int ChangeWeight(G4int branch, G4double newWeight);
+		void SetBranch(G4Track* track, G4int branch);
+		static G4bool IsClone(const G4Track* track, const G4Track* secondary);
+
+		G4bool ResolveBranch(G4int branch, std::vector<Entry>& entries) const;
+		G4bool ResolvePoint(G4int point, std::vector<Entry>& entries) const;
+		static void AddEntry(std::vector<Entry>& entries, const GasEventRecord& totals, G4double weight);
+
+		std::vector<Branch> fBranches;
+		std::vector<Point> fPoints;
+		G4bool fTouched;
+
+		// Last followed step and the secondaries of its track already assigned
+		const G4Track* fTrack;
+		G4int fTrackID;
+		G4int fStepNumber;
+		G4int fBranch;
+		size_t fNumSecondaries;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef GasEventRecord_h
+#define GasEventRecord_h 1
+
+#include "globals.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Species scored in the Sensitive Gas Volume. The order of this table fixes
+// the layout of GasEventRecord; a species is added by extending the enum and
+// the table together.
+namespace GasScoring
+{
+	enum Species { kElectron = 0, kPositron, kPhoton, kTriton, kProton, kNumSpecies };
+
+	struct SpeciesEntry
+	{
+		const char* particleName;
+		G4bool scoreEDep;			// Energy deposited by this species
+		G4bool scoreSecondaries;	// Secondaries of this species created in the gas
+	};
+
+	constexpr SpeciesEntry kSpeciesTable[kNumSpecies] = {
+		{ "e-",		true,	true },
+		{ "e+",		true,	true },
+		{ "gamma",	false,	true },
+		{ "triton",	true,	true },
+		{ "proton",	true,	true }
+	};
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Fixed-layout totals in the Sensitive Gas Volume, of one event or of one
+// branch of a biased event (see GasBranches). Deposits and counts are
+// unweighted; the weight of an entry is kept next to its totals.
+struct GasEventRecord
+{
+	G4bool touched;		// Set by the first scored step
+	G4double eDep;
+	G4double eDepSpecies[GasScoring::kNumSpecies];
+	G4double trackLengthPassage;
+	G4double nSecondaries[GasScoring::kNumSpecies];
+
+	void Reset()
+	{
+		touched = false;
+		eDep = 0.;
+		trackLengthPassage = 0.;
+		for (G4int i = 0; i < GasScoring::kNumSpecies; ++i) {
+			eDepSpecies[i] = 0.;
+			nSecondaries[i] = 0.;
+		}
+	}
+
+	void Add(const GasEventRecord& other)
+	{
+		touched = touched || other.touched;
+		eDep += other.eDep;
+		trackLengthPassage += other.trackLengthPassage;
+		for (G4int i = 0; i < GasScoring::kNumSpecies; ++i) {
+			eDepSpecies[i] += other.eDepSpecies[i];
+			nSecondaries[i] += other.nSecondaries[i];
+		}
+	}
+
+	G4bool SameTotals(const GasEventRecord& other) const
+	{
+		if (eDep != other.eDep || trackLengthPassage != other.trackLengthPassage) return false;
+		for (G4int i = 0; i < GasScoring::kNumSpecies; ++i) {
+			if (eDepSpecies[i] != other.eDepSpecies[i] || nSecondaries[i] != other.nSecondaries[i]) return false;
+		}
+		return true;
+	}
+};
+
+#endif
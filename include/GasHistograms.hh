@@ -0,0 +1,87 @@
+#ifndef GasHistograms_h
+#define GasHistograms_h 1
+
+#include "globals.hh"
+#include "GasEventRecord.hh"
+#include <iosfwd>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Run-level histograms of the Sensitive Gas Volume held in dense per-thread
+// arrays: the total energy deposit spectrum, one spectrum per species of
+// GasScoring::kSpeciesTable, the passage track length and the secondary
+// multiplicity per species. Energy spectra use logarithmic bins, the track
+// length uses linear bins and multiplicities use one bin per count. The first
+// and last bin of every histogram hold the underflow and overflow.
+//
+// For energy scans the total deposit is also binned by the true primary
+// energy, in the bins of the energy spectra, together with the number of
+// primaries per true energy bin.
+//
+// The entries of one biased event are filled between BeginEvent and
+// EndEvent, so that their weights are summed per bin before they are squared
+// and sumw2 stays the variance of the event sums.
+
+class GasHistograms
+{
+	public:
+		// Constructor
+		GasHistograms();
+		// Destructor
+		~GasHistograms();
+
+		// Methods
+		void Fill(const GasEventRecord& record, G4double weight = 1.);
+		// Every processed event, including those that missed the gas
+		void FillPrimary(G4double primaryEnergy);
+		void FillResponse(G4double primaryEnergy, G4double eDep, G4double weight = 1.);
+		void BeginEvent();
+		void EndEvent();
+		void Add(const GasHistograms& other);
+		void Reset();
+		void Write(const G4String& fileName) const;
+		
+		// Full-precision state for checkpoints; Load fails on a different binning
+		void Save(std::ostream& out) const;
+		G4bool Load(std::istream& in);
+
+		G4double GetSumOfWeights() const { return fSumOfWeights; }
+
+	private:
+		G4int EnergyBin(G4double energy) const;
+		// Lower edge of an energy bin, the upper edge of the previous one
+		G4double EnergyBinLow(G4int bin) const;
+		G4int TrackLengthBin(G4double length) const;
+		G4int MultiplicityBin(G4double count) const;
+
+		void FillBin(std::vector<G4double>& sumw, std::vector<G4double>& sumw2,
+					 G4int bin, G4double weight);
+
+		// Sum of weights and of squared weights, one block per histogram
+		std::vector<G4double> fEDep;
+		std::vector<G4double> fEDep2;
+		std::vector<G4double> fTrackLength;
+		std::vector<G4double> fTrackLength2;
+		std::vector<G4double> fSecondaries;
+		std::vector<G4double> fSecondaries2;
+		
+		// Primaries per true energy bin and the total deposit spectrum of each
+		std::vector<G4double> fPrimaries;
+		std::vector<G4double> fResponse;
+		std::vector<G4double> fResponse2;
+
+		G4double fSumOfWeights;
+		
+		// Weights of the current event per bin, squared at its end
+		struct PendingBin
+		{
+			std::vector<G4double>* sumw2;
+			G4int bin;
+			G4double weight;
+		};
+		G4bool fInEvent;
+		std::vector<PendingBin> fPending;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef HPDataImage_h
+#define HPDataImage_h 1
+
+#include <set>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Single-file image of the NeutronHP data (G4NDL) needed for a set of
+// elements. Layout (little-endian):
+//
+//   header   "AEHPD001", file count, index bytes
+//   index    per file: data offset, size, path length, path relative to G4NDL
+//   data     file contents, each starting on a 4 KiB boundary
+//
+// Pack selects the files named "<Z>_<A>_<Name>" of the given elements and of
+// their neighbours Z-1 and Z+1, which the HP data lookup falls back to, and
+// every file not named after an isotope (thermal scattering and the like).
+//
+// The simulation maps the image read-only and installs it once per node as
+// a directory on a memory file system, "<parent>/AdEPTCubeSat-hp-<hash>",
+// to which G4NEUTRONHPDATA is pointed. Later processes find the directory
+// complete and only check it, and all of them read the same pages instead
+// of thousands of small files from a shared file system. The directory is
+// written under a temporary name and renamed, as the physics table cache.
+//
+// This file only depends on the C++ standard library and POSIX so that the
+// packer builds without Geant4.
+
+class HPDataImage
+{
+	public:
+		// Constructor
+		HPDataImage();
+		// Destructor
+		~HPDataImage();
+		
+		// Writes the image of the data directory for the elements given by Z
+		static bool Pack(const std::string& dataDirectory, const std::set<int>& elements,
+						 const std::string& imageName, std::string& error);
+		
+		// Maps an image read-only
+		bool Open(const std::string& imageName);
+		void Close();
+		
+		// Unpacks the mapped image below parent unless already there, and
+		// returns the data directory; installed is false if it was there
+		bool Install(const std::string& parent, std::string& directory, bool& installed);
+		
+		size_t GetNumberOfFiles() const { return fEntries.size(); }
+		uint64_t GetDataSize() const;
+		const std::string& GetError() const { return fError; }
+		
+	private:
+		struct Entry
+		{
+			std::string path;
+			uint64_t offset;
+			uint64_t size;
+		};
+		
+		bool Extract(const std::string& directory);
+		
+		std::vector<Entry> fEntries;
+		std::string fHash;			// Of the index, names the installed directory
+		const unsigned char* fData;
+		size_t fMappedSize;
+		std::string fError;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef InitTimer_h
+#define InitTimer_h 1
+
+#include "G4VStateDependent.hh"
+#include "globals.hh"
+
+#include <chrono>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Wall time of the initialization phases of the master thread. Phases are
+// timed explicitly with Begin/End (geometry, physics lists, production cuts)
+// and from the application state: each Init state is either a
+// /run/initialize or, if the event loop follows, the run initialization in
+// which the physics tables are built or retrieved. The report is printed
+// when the event loop of a run starts after a /run/initialize, together
+// with the resident memory of the process.
+
+class InitTimer : public G4VStateDependent
+{
+	public:
+		// Constructor
+		InitTimer();
+		// Destructor
+		virtual ~InitTimer();
+
+		// Methods
+		virtual G4bool Notify(G4ApplicationState requestedState);
+
+		// Timing of a phase on the master thread, ignored without an InitTimer
+		static void Begin(const G4String& phase);
+		static void End(const G4String& phase);
+		// Text shown next to the physics tables, e.g. the table cache status
+		static void SetTablesNote(const G4String& note);
+		
+		// Current and peak resident memory of the process in MB, false where
+		// /proc/self/status is not available
+		static G4bool GetResidentMemory(G4double& resident, G4double& peak);
+
+	private:
+		struct Phase
+		{
+			G4String name;
+			G4double seconds;
+		};
+
+		void Report(G4double tablesTime);
+
+		static InitTimer* fInstance;
+
+		// Phases not nested, repeated phases add up
+		std::vector<Phase> fPhases;
+		G4String fPhaseName;
+		std::vector<G4double> fInitTimes;
+		G4String fTablesNote;
+		std::chrono::steady_clock::time_point fInitStart;
+		std::chrono::steady_clock::time_point fPhaseStart;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef NeutronBiasingOperator_h
+#define NeutronBiasingOperator_h 1
+
+#include "G4VBiasingOperator.hh"
+
+#include <map>
+
+class G4BOptnChangeCrossSection;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Survival biasing of neutrons (/AdEPTCubeSat/physics/biasNeutron): the
+// cross section of the wrapped nCapture process is set to zero in the
+// volumes the operator is attached to, so neutrons are never captured there
+// and their weight is multiplied by the survival probability of every step
+// instead. Attached to every volume except the Sensitive Gas Volume, where
+// the captures and reactions are the signal. The weights are kept in bounds
+// by the weight windows of the SteppingAction.
+
+class NeutronBiasingOperator : public G4VBiasingOperator
+{
+	public:
+		// Constructor
+		NeutronBiasingOperator(const G4String& name);
+		// Destructor
+		virtual ~NeutronBiasingOperator();
+		
+		// Finds the wrapped capture process of this thread
+		virtual void StartRun();
+		
+	private:
+		virtual G4VBiasingOperation* ProposeOccurenceBiasingOperation(const G4Track* track,
+																	  const G4BiasingProcessInterface* callingProcess);
+		virtual G4VBiasingOperation* ProposeFinalStateBiasingOperation(const G4Track*, const G4BiasingProcessInterface*)
+		{ return 0; }
+		virtual G4VBiasingOperation* ProposeNonPhysicsBiasingOperation(const G4Track*, const G4BiasingProcessInterface*)
+		{ return 0; }
+		
+		std::map<const G4BiasingProcessInterface*, G4BOptnChangeCrossSection*> fCaptureOperations;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef OverlapChecker_h
+#define OverlapChecker_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+class G4VPhysicalVolume;
+class G4GenericMessenger;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Overlap check of all placements of a geometry after its construction, as
+// done by G4PVPlacement::CheckOverlaps for each placement: points on the
+// surface of every daughter must lie inside its mother and outside its
+// sisters, and no sister may lie inside it. The surface points are drawn on
+// the calling thread; the Inside tests, which are thread-safe like during
+// tracking, run on several threads.
+//
+// A geometry that passed is recorded in the cache directory under the hash
+// of its description (every placement with its solid, material, mother,
+// position and rotation) together with the resolution and tolerance, so an
+// unchanged geometry is not checked again while any change is.
+
+class OverlapChecker
+{
+	public:
+		// Constructor
+		OverlapChecker();
+		// Destructor
+		~OverlapChecker();
+
+		// Methods
+		// "off", "serial" (G4PVPlacement checks while placing) or "parallel"
+		const G4String& GetMode() const { return fMode; }
+
+		// Check the geometry below world in parallel mode
+		void Check(const G4VPhysicalVolume* world);
+
+	private:
+		struct Placement
+		{
+			const G4VPhysicalVolume* volume;
+			const G4VPhysicalVolume* mother;
+			std::vector<G4ThreeVector> points;		// Surface points in the mother frame
+		};
+
+		// Define commands to control the overlap check
+		void DefineCommands();
+
+		G4String Describe(const G4VPhysicalVolume* world) const;
+		void Collect(const G4VPhysicalVolume* mother, std::vector<Placement>& placements) const;
+		void CheckPlacement(const std::vector<Placement>& placements, size_t index, std::vector<G4String>& overlaps) const;
+
+		G4GenericMessenger* fMessenger;
+		G4String fMode;
+		G4String fCacheDirectory;
+		G4int fResolution;
+		G4double fTolerance;
+		G4int fThreads;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -4,7 +4,12 @@
 #include "G4VModularPhysicsList.hh"
 #include "globals.hh"
 
+#include <map>
+
 class G4VPhysicsConstructor;
+class G4GenericBiasingPhysics;
+class G4GenericMessenger;
+class PhysicsTableCache;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -19,12 +24,54 @@ public:
   	
   	virtual void ConstructProcess();
         
+  	// EM constructor, sensitive gas model or hadron physics by name, see
+  	// /AdEPTCubeSat/physics/addPhysics
   	void AddPhysicsList(const G4String& name);
   	
   	virtual void SetCuts();
+  	
+  	// Photon interactions are forced in the sensitive gas, see DetectorConstruction
+  	G4bool IsGammaBiased() const { return fBiasGamma; }
+  	
+  	// Neutrons are not captured outside the sensitive gas, see
+  	// NeutronBiasingOperator. Must be set before /run/initialize
+  	void SetBiasNeutron(G4bool bias);
+  	G4bool IsNeutronBiased() const { return fBiasNeutron; }
+  	
+  	// Electrons ranging out in the sensitive gas are deposited at once by
+  	// the RangeOutModel, see DetectorConstruction
+  	G4bool IsRangeOutEnabled() const { return fRangeOut; }
+  	G4double GetRangeOutVoxel() const { return fRangeOutVoxel; }
+  	
+  	// Production cuts of the detector regions, "<region> <value> <unit>",
+  	// applied by SetCuts and, after /run/initialize, at once. The World and
+  	// every region without its own cut use /run/setCut
+  	void SetRegionCut(const G4String& value);
+  	G4String GetCutsDescription() const;
+  	
+  	// Constructors and options the physics tables depend on
+  	G4String GetPhysicsDescription() const;
+  	
+  	// Processes a primary of this species needs but does not have with the
+  	// selected hadronic physics, e.g. " hadronic decay", empty if none
+  	G4String GetMissingProcesses(const G4ParticleDefinition* particle) const;
+  	
+  	// Physics table cache directory, empty to disable
+  	void SetTableCache(const G4String& directory);
+  	
+  	// NeutronHP data image, see HPDataImage. SetHPImage installs the image
+  	// and points G4NEUTRONHPDATA to it, PackHPImage writes the image of the
+  	// data in G4NEUTRONHPDATA for the elements of all defined materials
+  	void SetHPImage(const G4String& imageName);
+  	void PackHPImage(const G4String& imageName);
 
 private:
 
+	// Creates the hadron physics selected with /AdEPTCubeSat/physics/hadronic,
+	// once on the master thread; "auto" derives it from fPrimaries
+	void ConfigureHadronPhysics();
+	G4String SelectHadronPhysics() const;
+	
 	void AddPAIModel(const G4String&);
 	void NewPAIModel(const G4ParticleDefinition* part, 
                      const G4String& modname,
@@ -33,7 +80,23 @@ private:
  	G4VPhysicsConstructor*  fEmPhysicsList;
   	G4VPhysicsConstructor*  fDecayPhysicsList;
   	std::vector<G4VPhysicsConstructor*> fHadronPhys;
+  	G4String fHadronicName;
+  	G4String fPrimaries;
+  	G4bool fDecayProcesses;
   	G4String fEmName;
+  	
+  	// Wraps the gamma and neutron processes for the generic biasing framework
+  	G4GenericBiasingPhysics* fBiasingPhysics;
+  	G4bool fBiasGamma;
+  	G4bool fBiasNeutron;
+  	G4bool fRangeOut;
+  	G4double fRangeOutVoxel;
+  	G4GenericMessenger* fMessenger;
+  	
+  	std::map<G4String, G4double> fRegionCuts;
+  	
+  	PhysicsTableCache* fTableCache;
+  	G4String fHPImageDirectory;
 };
 
 #endif
\ No newline at end of file
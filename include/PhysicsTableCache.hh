@@ -0,0 +1,56 @@
+#ifndef PhysicsTableCache_h
+#define PhysicsTableCache_h 1
+
+#include "G4VStateDependent.hh"
+#include "globals.hh"
+
+class PhysicsList;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// On-disk cache of the physics tables of the master thread. An entry is the
+// directory "<cache>/<hash>" written by G4VUserPhysicsList::StorePhysicsTable
+// together with key.txt, the full text the hash is computed from: Geant4
+// version, physics constructors, EM parameters, production cuts and energy
+// range, regions, and every material with its composition and the volumes
+// it is placed in. When a run initialization starts, the key is made again
+// and the tables are retrieved if an entry with the same key.txt exists;
+// otherwise they are built and stored once the run starts. Entries are
+// written under a temporary name and renamed, so jobs sharing a cache never
+// read a partial entry. Any change of the key selects another entry.
+//
+// Only tables owned by the processes are cached; the PAI model data of the
+// sensitive gas region is computed at initialization in any case.
+
+class PhysicsTableCache : public G4VStateDependent
+{
+	public:
+		// Constructor
+		PhysicsTableCache(PhysicsList* physicsList);
+		// Destructor
+		virtual ~PhysicsTableCache();
+
+		// Methods
+		virtual G4bool Notify(G4ApplicationState requestedState);
+
+		// Empty to disable the cache
+		void SetDirectory(const G4String& directory) { fDirectory = directory; }
+		const G4String& GetDirectory() const { return fDirectory; }
+
+	private:
+		G4String MakeKey() const;
+		void Prepare();
+		void Store();
+
+		PhysicsList* fPhysicsList;
+		G4String fDirectory;
+
+		// Entry of the current physics tables
+		G4String fKey;
+		G4String fEntry;
+		G4bool fStorePending;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -1,30 +1,94 @@
-#ifndef PrimaryGeneratorAction_h
-#define PrimaryGeneratorAction_h 1
-
-#include "G4VUserPrimaryGeneratorAction.hh"
-#include "G4GeneralParticleSource.hh"
-
-class G4Event;
-
-class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
-
-	public:
-  		// Constructor
-  		PrimaryGeneratorAction();    
-
-  		// Destructor
-  		virtual ~PrimaryGeneratorAction();
-  
-  		// Method
-  		void GeneratePrimaries(G4Event*);
-  
-	public:
-    	G4GeneralParticleSource* GetGPS() {return particleGun;};
-
-	private:
-		// Data member
- 		G4GeneralParticleSource* particleGun;	 
-
-};
-
-#endif
\ No newline at end of file
+#ifndef PrimaryGeneratorAction_h
+#define PrimaryGeneratorAction_h 1
+
+#include "G4VUserPrimaryGeneratorAction.hh"
+#include "G4GeneralParticleSource.hh"
+#include "G4ThreeVector.hh"
+
+#include <set>
+#include <vector>
+
+class G4Event;
+class G4ParticleDefinition;
+class G4GenericMessenger;
+class DetectorConstruction;
+class Run;
+
+namespace CLHEP { class HepRandomEngine; }
+
+class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
+
+	public:
+  		// Constructor
+  		PrimaryGeneratorAction(DetectorConstruction* det = 0);    
+
+  		// Destructor
+  		virtual ~PrimaryGeneratorAction();
+  
+  		// Method
+  		void GeneratePrimaries(G4Event*);
+  
+	public:
+    	G4GeneralParticleSource* GetGPS() {return particleGun;};
+    	
+    	// Energy scan within one run, overriding the GPS energy distribution.
+    	// Arguments are a list of values followed by a unit, e.g. "10 20 50 keV"
+    	void SetScanList(const G4String& values);
+    	void SetScanRange(const G4String& values);
+    	void SetScanOff();
+    	
+    	// Random numbers of every event are a function of the master seed and
+    	// the event number only, the event ID plus the first event number
+    	G4long GetMasterSeed() const { return fMasterSeed; }
+    	G4long GetFirstEvent() const { return fFirstEvent; }
+    	const G4String& GetEngineName() const { return fEngineName; }
+
+	private:
+		// Define commands to control the source
+		void DefineCommands();
+		
+		// Select the engine of this thread and seed it for the event
+		void SeedEvent(G4long eventNumber);
+		
+		// Primary energy of this event in scan mode
+		G4double SampleScanEnergy(G4long eventNumber) const;
+		
+		// Redraw source rays until one enters the detector envelope
+		void GenerateAccepted(G4Event* anEvent, Run* run);
+		
+		// True if a primary of the vertex is headed into the detector envelope
+		G4bool IsAccepted(const G4PrimaryVertex* vertex) const;
+		
+		// Warns once per species about processes a primary needs but the
+		// physics configuration does not construct
+		void CheckPhysics(const G4Event* anEvent);
+		
+		// Data member
+ 		G4GeneralParticleSource* particleGun;	 
+ 		
+ 		DetectorConstruction* detector;
+ 		G4GenericMessenger* fMessenger;
+ 		G4GenericMessenger* fRandomMessenger;
+ 		
+ 		// Redraw source rays that miss the detector envelope. Every drawn ray
+ 		// is counted in the Run, so the acceptance fraction is known exactly
+ 		G4bool fAcceptance;
+ 		G4int fMaxTrials;
+		
+		// Scan energies: list points are used in turn by event ID, a range
+		// is sampled log-uniformly between its two values
+		enum ScanMode { kScanOff = 0, kScanList, kScanRange };
+		ScanMode fScanMode;
+		std::vector<G4double> fScanEnergies;
+		
+		// Per-event seeding, the engine is owned by this thread
+		G4long fMasterSeed;
+		G4long fFirstEvent;
+		G4String fEngineName;
+		CLHEP::HepRandomEngine* fEngine;
+		G4String fCurrentEngineName;
+		
+		std::set<const G4ParticleDefinition*> fCheckedSpecies;
+};
+
+#endif
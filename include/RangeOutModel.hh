@@ -0,0 +1,36 @@
+#ifndef RangeOutModel_h
+#define RangeOutModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "globals.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Fast simulation of electrons that range out in the Sensitive Gas Volume
+// (/AdEPTCubeSat/physics/rangeOut). Once the range of an electron is below
+// the voxel size and below its distance to the boundary of the envelope, its
+// whole kinetic energy is deposited in one step whose length is the range
+// and which ends along the current direction at the mean projected range.
+// As the electron cannot leave the envelope, the energy deposit and the
+// passage track length in the gas are the same as with full tracking; the
+// ranges are those of the restricted stopping power, so delta rays above
+// the production cut cannot be lost either.
+
+class RangeOutModel : public G4VFastSimulationModel
+{
+	public:
+		// Constructor
+		RangeOutModel(const G4String& name, G4Region* envelope, G4double voxelSize);
+		// Destructor
+		virtual ~RangeOutModel();
+		
+		// Methods
+		virtual G4bool IsApplicable(const G4ParticleDefinition& particle);
+		virtual G4bool ModelTrigger(const G4FastTrack& fastTrack);
+		virtual void DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep);
+		
+	private:
+		G4double fVoxelSize;
+};
+
+#endif
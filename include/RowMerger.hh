@@ -0,0 +1,126 @@
+#ifndef RowMerger_h
+#define RowMerger_h 1
+
+#include "RowWriter.hh"
+#include "globals.hh"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Master-side merge of the per-event rows of all worker threads into one
+// output file per run. Workers hand over completed blocks of rows together
+// with a watermark, the ID of the last event they finished. Each worker
+// processes its events in increasing ID order, so in ordered mode every
+// buffered row with an event ID not above the smallest watermark of the
+// running workers can be written. A worker whose buffered rows exceed the
+// configured limit waits until the merge has caught up, which bounds memory.
+//
+// When the workers announce their batches, a worker is running only while it
+// has events of a batch left. It joins when the batch is handed out, before
+// any later batch is, and leaves with its last rows at the end of the batch.
+// Events are handed out in increasing ID order, so a worker waiting for its
+// next batch, or a pool thread that never gets one, cannot produce an event
+// at or below the watermark of a running worker and does not hold back the
+// merge. Otherwise every worker is running until it closes.
+
+class RowMerger
+{
+	public:
+		// Constructor
+		RowMerger(RowWriter* output, G4int numColumns, G4int eventIDColumn,
+				  G4bool ordered, G4int maxBufferedRows);
+		// Destructor
+		~RowMerger();
+
+		// Methods
+		// Number of worker threads expected to submit rows in this run; others
+		// are added when they first join or submit
+		void BeginRun(G4int numberOfWorkers, G4bool announcedBatches = false);
+		// The worker got a batch of events; must not be called while holding
+		// back the merge, as it does not wait
+		void Join(G4int workerID);
+		// Rows are taken over by swapping with the given vector. A worker that
+		// is no longer running has no events left until it joins again
+		void Submit(G4int workerID, std::vector<G4double>& rows, G4long watermark, G4bool running);
+		// Write everything still buffered and close the output
+		void EndRun();
+
+		G4long GetNumberOfRows() const { return fRowsWritten; }
+
+		// The merger of the current run, set by the master
+		static RowMerger* GetInstance() { return fgInstance; }
+		static void SetInstance(RowMerger* merger) { fgInstance = merger; }
+
+	private:
+		struct Stream
+		{
+			std::deque< std::vector<G4double> > blocks;
+			size_t position;		// Next row in the front block
+			size_t bufferedRows;
+			G4long watermark;
+			G4bool running;
+		};
+
+		Stream& GetStream(G4int workerID);
+		void Drain();
+		void WriteBlocks(Stream& stream);
+
+		RowWriter* fOutput;
+		G4int fNumColumns;
+		G4int fEventIDColumn;
+		G4bool fOrdered;
+		size_t fMaxBufferedRows;
+		G4bool fAnnouncedBatches;
+
+		std::vector<Stream> fStreams;
+		G4long fRowsWritten;
+
+		std::mutex fMutex;
+		std::condition_variable fDrained;
+
+		static RowMerger* fgInstance;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Worker-side RowWriter that collects rows into blocks for the RowMerger
+class MergedRowWriter : public RowWriter
+{
+	public:
+		// Constructor
+		MergedRowWriter(RowMerger* merger, G4int workerID, G4int numColumns, G4int blockSize);
+		// Destructor
+		virtual ~MergedRowWriter();
+
+		// Methods
+		virtual bool Open(const std::string&) { return true; }
+		virtual void Fill(const double* row);
+		virtual void EventDone(long eventID);
+		virtual void BeginBatch(long events);
+		virtual void Stop() { Close(); }
+		virtual void Close();
+
+		// Includes the rows this thread wrote for the merge
+		virtual double GetBlockedTime() const { return fBlockedTime; }
+
+	private:
+		void Submit(G4bool running);
+
+		RowMerger* fMerger;
+		G4int fWorkerID;
+		G4int fNumColumns;
+		G4int fBlockSize;
+
+		std::vector<G4double> fBlock;
+		G4long fLastEventID;
+		G4int fEventsSinceSubmit;
+		G4long fBatchEvents;		// Events left in the batch, -1 if not announced
+		G4bool fClosed;
+		G4double fBlockedTime;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef RowWriter_h
+#define RowWriter_h 1
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Destination of the per-event rows. A row holds one value per column in the
+// order of Analysis::kNtupleColumns. Like ColumnarFile.hh this header only
+// depends on the C++ standard library so that the tools can use it.
+
+class RowWriter
+{
+	public:
+		// Destructor
+		virtual ~RowWriter() {}
+
+		// Methods
+		virtual bool Open(const std::string& fileName) = 0;
+		virtual void Fill(const double* row) = 0;
+		// Called once per processed event, after the rows of that event
+		virtual void EventDone(long) {}
+		// Called when the thread is handed its next batch of events, zero when
+		// the run has none left, before any later batch is handed out
+		virtual void BeginBatch(long) {}
+		// Called when the thread ends its run early, e.g. on a stop request
+		virtual void Stop() {}
+		virtual void Close() = 0;
+
+		// Seconds the calling thread spent waiting on the output so far
+		virtual double GetBlockedTime() const { return 0.; }
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Plain CSV rows with the same header comments as the g4csv ntuple. Used
+// where the thread-local Analysis Manager cannot be, e.g. for merged output.
+
+class CsvRowWriter : public RowWriter
+{
+	public:
+		// Constructor
+		CsvRowWriter();
+		// Destructor
+		virtual ~CsvRowWriter();
+
+		// Methods
+		// Integer columns are printed without a fractional part
+		void AddColumn(const std::string& name, bool isInteger);
+
+		virtual bool Open(const std::string& fileName);
+		virtual void Fill(const double* row);
+		virtual void Close();
+
+	private:
+		std::vector<std::string> fNames;
+		std::vector<bool> fIsInteger;
+		FILE* fFile;
+};
+
+#endif
@@ -3,33 +3,102 @@
 
 #include "G4Run.hh"
 #include "globals.hh"
+#include "GasHistograms.hh"
+#include "GasBranches.hh"
+
+#include <chrono>
+#include <vector>
+
+class RowWriter;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 class Run : public G4Run
 {
 	public:
+		// Throughput of one worker thread, collected when its run is merged
+		struct WorkerStats
+		{
+			G4int threadID;
+			G4int numberOfEvents;
+			G4double realTime;			// Seconds from the start of the run to the merge
+			G4double outputBlocked;		// Seconds spent waiting on the per-event output
+		};
+
 		// Constructor
-  		Run();
+  		Run(RowWriter* rowWriter = 0);
   		// Destructor
   		virtual ~Run();
 		
 		// Methods
 		virtual void RecordEvent(const G4Event*);
-// 		virtual void Merge(const G4Run*);
+		virtual void Merge(const G4Run*);
+		
+		// Rays drawn by the source, including those rejected before tracking
+		void AddSourceRays(G4long n) { fSourceRays += n; }
+		G4long GetNumberOfSourceRays() const { return fSourceRays; }
+		
+		// Secondaries killed at birth by the StackingAction and their energy
+		void AddKilledSecondary(G4double energy) { ++fKilledSecondaries; fKilledEnergy += energy; }
+		G4long GetNumberOfKilledSecondaries() const { return fKilledSecondaries; }
+		G4double GetKilledEnergy() const { return fKilledEnergy; }
+		
+		// Electrons deposited at once by the RangeOutModel
+		void AddRangedOutElectron() { ++fRangedOutElectrons; }
+		G4long GetNumberOfRangedOutElectrons() const { return fRangedOutElectrons; }
+		
+		// Steps of all tracks, counted by the SteppingAction
+		void AddStep() { ++fSteps; }
+		G4long GetNumberOfSteps() const { return fSteps; }
+		
+		// Neutrons split and killed by the weight windows of the SteppingAction
+		void AddNeutronSplits(G4long n) { fNeutronSplits += n; }
+		void AddNeutronRouletteKill() { ++fNeutronRouletteKills; }
+		G4long GetNumberOfNeutronSplits() const { return fNeutronSplits; }
+		G4long GetNumberOfNeutronRouletteKills() const { return fNeutronRouletteKills; }
+		
+		// Biased events scored as one entry since their outcomes exceeded GasBranches::kMaxEntries
+		G4long GetNumberOfCollapsedEvents() const { return fCollapsedEvents; }
+		
+		// Random number settings of the run, taken from the workers
+		G4long GetMasterSeed() const { return fMasterSeed; }
+		G4long GetFirstEvent() const { return fFirstEvent; }
+		const G4String& GetEngineName() const { return fEngineName; }
+		
+		// Per-event output of this thread, none on the master
+		RowWriter* GetRowWriter() const { return fRowWriter; }
+		
+		const GasHistograms& GetHistograms() const { return fHistograms; }
+		const std::vector<WorkerStats>& GetWorkerStats() const { return fWorkerStats; }
 
 	private:
-		G4int ID_PVSensitiveGas_eDep;
-		G4int ID_PVSensitiveGas_eDep_Positron;
-		G4int ID_PVSensitiveGas_eDep_Electron;
-		G4int ID_PVSensitiveGas_eDep_Triton;
-		G4int ID_PVSensitiveGas_eDep_Proton;
-		G4int ID_PVSensitiveGas_trackLengthPassage;
-		G4int ID_PVSensitiveGas_secondaryElectrons;
-		G4int ID_PVSensitiveGas_secondaryPositrons;
-		G4int ID_PVSensitiveGas_secondaryPhotons;
-		G4int ID_PVSensitiveGas_secondaryTritons;
-		G4int ID_PVSensitiveGas_secondaryProtons;
+		// Per-thread totals filled by the Sensitive Gas Volume detector
+		const GasBranches* fGasBranches;
+		// Weighted outcomes of the current event, reused
+		std::vector<GasBranches::Entry> fEntries;
+		
+		// Run-level tallies, merged into the master run
+		GasHistograms fHistograms;
+		
+		// Destination of one row per event with energy deposited in the gas,
+		// none when only histograms are written
+		RowWriter* fRowWriter;
+		
+		G4long fSourceRays;
+		G4long fKilledSecondaries;
+		G4double fKilledEnergy;
+		G4long fRangedOutElectrons;
+		G4long fSteps;
+		G4long fNeutronSplits;
+		G4long fNeutronRouletteKills;
+		G4long fCollapsedEvents;
+		
+		G4long fMasterSeed;
+		G4long fFirstEvent;
+		G4String fEngineName;
+		
+		std::chrono::steady_clock::time_point fStartTime;
+		std::vector<WorkerStats> fWorkerStats;
 };
 
 #endif
\ No newline at end of file
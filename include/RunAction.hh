@@ -9,6 +9,11 @@
 class Run;
 class DetectorConstruction;
 class PrimaryGeneratorAction;
+class SteppingAction;
+class G4Timer;
+class G4GenericMessenger;
+class RowWriter;
+class RowMerger;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -16,7 +21,7 @@ class RunAction : public G4UserRunAction
 {
 	public: 
 		// Constructor
-  		RunAction(DetectorConstruction* det, PrimaryGeneratorAction* primary=0);
+  		RunAction(DetectorConstruction* det, PrimaryGeneratorAction* primary=0, SteppingAction* stepping=0);
   		// Destructor
   		virtual ~RunAction();
 
@@ -27,12 +32,46 @@ class RunAction : public G4UserRunAction
  		virtual void EndOfRunAction(const G4Run*);
 
 	private:
+		// Define commands to control the run output
+		void DefineCommands();
+		// Wrap a file writer for throttling and asynchronous output
+		RowWriter* WrapFileWriter(RowWriter* fileWriter) const;
+		
 		DetectorConstruction* detector;
 		PrimaryGeneratorAction* particleGun;
+		SteppingAction* fStepping;
 		
 		// Output File
 		G4String outputFile_INFO;
 		FILE* pFile_INFO;
+		
+		// Wall-clock time of the run (master)
+		G4Timer* fTimer;
+		
+		G4GenericMessenger* fMessenger;
+		
+		// Write per-event ntuple rows; histograms are always written by the master
+		G4bool fWriteNtuple;
+		
+		// Count the steps of all tracks for the steps per event of the info file
+		G4bool fCountSteps;
+		
+		// Per-event output format ("csv" or "binary") and the row writer of this thread
+		G4String fOutputFormat;
+		RowWriter* fRowWriter;
+		
+		// Merge the rows of all workers into one file per run on the master,
+		// optionally ordered by event ID, handing them over in blocks of rows
+		G4bool fMergeOutput;
+		G4bool fOrderedOutput;
+		G4int fBlockSize;
+		RowMerger* fMerger;
+		RowWriter* fMergedOutput;
+		
+		// Write the files from a dedicated writer thread, optionally throttled
+		// by a delay per row to emulate a slow output device
+		G4bool fAsyncOutput;
+		G4double fOutputDelay;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef SchedulingRunManager_h
+#define SchedulingRunManager_h 1
+
+#ifdef G4MULTITHREADED
+
+#include "G4Version.hh"
+#if G4VERSION_NUMBER >= 1100
+#include "G4TaskRunManager.hh"
+typedef G4TaskRunManager SchedulingRunManagerBase;
+#else
+#include "G4MTRunManager.hh"
+typedef G4MTRunManager SchedulingRunManagerBase;
+#endif
+
+#include "BatchPolicy.hh"
+
+#include <chrono>
+
+class G4GenericMessenger;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Multi-threaded run manager whose event batches follow the measured cost
+// of the events (see BatchPolicy).
+//
+// The worker threads fetch their next batch of events from the master, in
+// tasks of the thread pool from Geant4 11 and as G4MTRunManager does before.
+// The batch size is computed per request from the events left and the event
+// cost measured on the previous batches of the run, instead of a fixed
+// /run/eventModulo or number of events per task, so the batches follow the
+// cost within a run. The event cost is kept from run to run, so consecutive
+// segments of a checkpointed run start with well sized batches.
+
+class SchedulingRunManager : public SchedulingRunManagerBase
+{
+	public:
+		// Constructor
+		SchedulingRunManager();
+		// Destructor
+		virtual ~SchedulingRunManager();
+
+		// Methods
+		virtual void InitializeEventLoop(G4int n_event, const char* macroFile = 0, G4int n_select = -1);
+		virtual void RunTermination();
+
+		#if G4VERSION_NUMBER >= 1010
+		// Called by the worker threads for their next batch of events, or for
+		// a single event while eventModulo is 1
+		virtual G4int SetUpNEvents(G4Event* evt, G4SeedsQueue* seedsQueue, G4bool reseedRequired = true);
+		virtual G4bool SetUpAnEvent(G4Event* evt, G4long& s1, G4long& s2, G4long& s3, G4bool reseedRequired = true);
+		#endif
+
+		// Worker threads pass each batch to their row writer (RowWriter::BeginBatch)
+		G4bool AnnouncesBatches() const { return G4VERSION_NUMBER >= 1010; }
+
+		G4long GetNumberOfBatches() const { return fBatches; }
+		G4double GetEventCost() const { return fPolicy.GetEventCost(); }
+
+	private:
+		// Define commands to control the scheduling
+		void DefineCommands();
+
+		#if G4VERSION_NUMBER >= 1010
+		// Batches of the calling worker thread, under the batch lock
+		G4double EndBatch();
+		void PlanBatch();
+		void StartBatch(G4double now, G4int events);
+		#endif
+
+		G4GenericMessenger* fMessenger;
+		G4bool fAdaptive;
+		G4double fTargetBatchTime;		// s
+
+		BatchPolicy fPolicy;
+		G4int fRunCount;
+		G4long fBatches;
+		G4int fEventsInRun;
+		std::chrono::steady_clock::time_point fRunStart;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SensitiveGasSD_h
+#define SensitiveGasSD_h 1
+
+#include "G4VSensitiveDetector.hh"
+#include "GasBranches.hh"
+#include "globals.hh"
+
+class G4Step;
+class G4HCofThisEvent;
+class G4TouchableHistory;
+class G4ParticleDefinition;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Single-pass scorer for the Sensitive Gas Volume. Each step is handled once
+// and added into the thread's GasBranches, reproducing the totals of the
+// former G4PSEnergyDeposit, G4PSPassageTrackLength and G4PSNofSecondary
+// primitives for unit track weights. With biasing the deposits stay
+// unweighted and go to the branch of the depositing track, whose weight
+// the entries of the event carry. No hits collection is produced; Run
+// reads the branches in place.
+
+class SensitiveGasSD : public G4VSensitiveDetector
+{
+	public:
+		// Constructor
+		SensitiveGasSD(const G4String& name);
+		// Destructor
+		virtual ~SensitiveGasSD();
+
+		// Methods
+		virtual void Initialize(G4HCofThisEvent*);
+		virtual G4bool ProcessHits(G4Step*, G4TouchableHistory*);
+
+		const GasBranches* GetBranches() const { return &fBranches; }
+		// Followed by the SteppingAction in every volume
+		GasBranches* GetBranches() { return &fBranches; }
+
+	private:
+		G4int FindSpecies(const G4ParticleDefinition* particle) const;
+
+		// Particle definitions in the order of GasScoring::kSpeciesTable
+		const G4ParticleDefinition* fSpecies[GasScoring::kNumSpecies];
+
+		GasBranches fBranches;
+
+		// Passage track length state of the track currently in the volume
+		G4int fCurrentTrackID;
+		G4double fCurrentTrackLength;
+};
+
+#endif
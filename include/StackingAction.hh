@@ -0,0 +1,67 @@
+#ifndef StackingAction_h
+#define StackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "G4RotationMatrix.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class G4GenericMessenger;
+class G4Navigator;
+class G4LogicalVolume;
+class DetectorConstruction;
+class Run;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Kills secondary electrons at birth that cannot reach the Sensitive Gas
+// Volume (/AdEPTCubeSat/stacking/). An electron below the maximum energy is
+// killed when its range in the material it is born in is shorter than the
+// safety of its vertex in that volume, so it cannot leave the volume, or,
+// when it is born in the pressure vessel gas region, when even its range in
+// the gas is shorter than the distance to the sensitive volume. Ranges are
+// taken from the energy loss tables of the couples and are those of the
+// restricted stopping power, i.e. never shorter than the true range.
+// The killed energy is counted in the Run.
+//
+// Photons and positrons are always tracked: neither has a range that
+// bounds where the photons they produce end up.
+
+class StackingAction : public G4UserStackingAction
+{
+	public:
+		// Constructor
+		StackingAction(DetectorConstruction* det);
+		// Destructor
+		virtual ~StackingAction();
+		
+		// Methods
+		virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track);
+		virtual void PrepareNewEvent();
+		
+	private:
+		// Define commands to control the stacking
+		void DefineCommands();
+		
+		// Finds the placement of the sensitive volume below the mother,
+		// composing the transformation from the world into its frame
+		G4bool FindSensitiveFrame(const G4LogicalVolume* mother, const G4RotationMatrix& rotation, const G4ThreeVector& translation);
+		
+		DetectorConstruction* detector;
+		G4GenericMessenger* fMessenger;
+		
+		G4bool fKillWallSecondaries;
+		G4double fMaxEnergy;
+		G4double fMargin;			// Subtracted from safeties and distances
+		
+		// Navigator of this thread for the safety of the vertices
+		G4Navigator* fNavigator;
+		
+		// Per event: run and frame of the sensitive volume, local = rotation*global + translation
+		Run* fRun;
+		G4bool fHaveSensitiveFrame;
+		G4RotationMatrix fSensitiveRotation;
+		G4ThreeVector fSensitiveTranslation;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef SteppingAction_h
+#define SteppingAction_h 1
+
+#include "G4UserSteppingAction.hh"
+#include "globals.hh"
+
+#include <map>
+#include <vector>
+
+class G4GenericMessenger;
+class Run;
+class GasBranches;
+class G4Track;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Weight windows for neutrons (/AdEPTCubeSat/neutronBias/). Every volume has
+// an importance I, by default 4 for the Sensitive Gas Volume, 2 for the
+// pressure vessel gas and 1 elsewhere, and after each step a neutron is
+// compared with the window [W_L, ratio*W_L] of the volume it is in, with
+// W_L = lower/I. Above the window it is split into copies of equal weight
+// that fit into the window, so neutrons heading into the gas multiply;
+// below it Russian roulette either kills it or raises its weight to the
+// survival weight sqrt(ratio)*W_L, so the low weights left by implicit
+// capture in the vessel and the World do not pile up. Both conserve the
+// expected weight. The copies of a split are alternative continuations of
+// the history, so each is scored as a separate entry of the event by the
+// GasBranches of the Sensitive Gas Volume detector, as is a roulette
+// survival.
+//
+// With photon or neutron biasing or the weight windows every step is followed
+// by the GasBranches of the Sensitive Gas Volume detector, which assigns
+// weight changes and secondaries to the branches of the event. With
+// /AdEPTCubeSat/output/countSteps every step is counted in the Run for the
+// steps per event of the info file. Both are decided at the start of each
+// run, so analog runs without step counting return at once.
+
+class SteppingAction : public G4UserSteppingAction
+{
+	public:
+		// Constructor
+		SteppingAction();
+		// Destructor
+		virtual ~SteppingAction();
+		
+		// Methods
+		virtual void UserSteppingAction(const G4Step* step);
+		
+		// Called by the RunAction of this thread at the start of each run
+		void BeginOfRun(G4bool countSteps);
+		
+		// Importance of a logical volume, "<name> <importance>"
+		void SetImportance(const G4String& value);
+		
+	private:
+		// Define commands to control the weight windows
+		void DefineCommands();
+		
+		G4double GetImportance(const G4String& volumeName) const;
+		
+		G4GenericMessenger* fMessenger;
+		
+		// Run of this thread and what to do per step, set by BeginOfRun
+		Run* fRun;
+		GasBranches* fBranches;
+		G4bool fCountSteps;
+		G4bool fFollowBranches;
+		
+		G4bool fWeightWindows;
+		G4double fWindowLower;		// Lower weight bound at importance 1
+		G4double fWindowRatio;		// Upper over lower weight bound
+		G4int fMaxSplit;			// Copies per split, including the original
+		
+		std::map<G4String, G4double> fImportance;
+		
+		// Copies of the current split, reused
+		std::vector<G4Track*> fCopies;
+};
+
+#endif
@@ -2,6 +2,8 @@
 #include "DetectorConstruction.hh"
 #include "PrimaryGeneratorAction.hh"
 #include "RunAction.hh"
+#include "StackingAction.hh"
+#include "SteppingAction.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -26,11 +28,18 @@ void ActionInitialization::BuildForMaster() const
 void ActionInitialization::Build() const
 {
   	// Primary Generator Action
-	PrimaryGeneratorAction* primary = new PrimaryGeneratorAction();
+	PrimaryGeneratorAction* primary = new PrimaryGeneratorAction(fDetector);
 	SetUserAction(primary);
 	
+	// Stepping Action, prepared for each run by the Run Action
+	SteppingAction* stepping = new SteppingAction();
+	SetUserAction(stepping);
+	
 	// Run Action
-	RunAction* runAction = new RunAction(fDetector,primary);
+	RunAction* runAction = new RunAction(fDetector,primary,stepping);
 	SetUserAction(runAction);
+	
+	// Stacking Action
+	SetUserAction(new StackingAction(fDetector));
 
 }
\ No newline at end of file
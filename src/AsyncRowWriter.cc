@@ -0,0 +1,161 @@
+#include "AsyncRowWriter.hh"
+
+#include <chrono>
+
+namespace
+{
+	// Shortest sleep of a throttled writer, in seconds
+	const double kMinSleep = 1e-3;
+
+	double Seconds(std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration<double>(duration).count();
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AsyncRowWriter::AsyncRowWriter(RowWriter* target, size_t numColumns, size_t blockRows, size_t numBlocks)
+ : fTarget(target), fNumColumns(numColumns), fBlockRows(blockRows > 0 ? blockRows : 1),
+   fSlots(numBlocks > 1 ? numBlocks : 2), fHead(0), fTail(0), fStop(false), fBlockedTime(0.)
+{
+	fBlock.reserve(fBlockRows*fNumColumns);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AsyncRowWriter::~AsyncRowWriter()
+{
+	Close();
+	delete fTarget;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool AsyncRowWriter::Open(const std::string& fileName)
+{
+	Close();
+	if (!fTarget->Open(fileName)) return false;
+
+	fHead.store(0);
+	fTail.store(0);
+	fStop.store(false);
+	fBlockedTime = 0.;
+	fWriter = std::thread(&AsyncRowWriter::WriterLoop, this);
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AsyncRowWriter::Fill(const double* row)
+{
+	fBlock.insert(fBlock.end(), row, row + fNumColumns);
+	if (fBlock.size() >= fBlockRows*fNumColumns) Push();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AsyncRowWriter::Push()
+{
+	if (fBlock.empty()) return;
+
+	const size_t head = fHead.load(std::memory_order_relaxed);
+	if (head - fTail.load(std::memory_order_acquire) == fSlots.size()) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::unique_lock<std::mutex> lock(fWaitMutex);
+		fSlotFreed.wait(lock, [this, head] {
+			return head - fTail.load(std::memory_order_acquire) < fSlots.size();
+		});
+		lock.unlock();
+		fBlockedTime += Seconds(std::chrono::steady_clock::now() - start);
+	}
+
+	// The slot holds an emptied block that keeps its capacity
+	fSlots[head % fSlots.size()].swap(fBlock);
+	fHead.store(head + 1, std::memory_order_release);
+	Notify(fBlockReady);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AsyncRowWriter::Notify(std::condition_variable& condition)
+{
+	// Taking the mutex orders the notification after the waiter's last check
+	// of the indices, so a wake-up cannot be lost
+	{
+		std::lock_guard<std::mutex> lock(fWaitMutex);
+	}
+	condition.notify_one();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AsyncRowWriter::WriterLoop()
+{
+	while (true) {
+		const size_t tail = fTail.load(std::memory_order_relaxed);
+		if (fHead.load(std::memory_order_acquire) == tail) {
+			// Stop is only set after the last block was pushed
+			std::unique_lock<std::mutex> lock(fWaitMutex);
+			fBlockReady.wait(lock, [this, tail] {
+				return fHead.load(std::memory_order_acquire) != tail || fStop.load(std::memory_order_acquire);
+			});
+			if (fHead.load(std::memory_order_acquire) == tail) break;
+			continue;
+		}
+
+		std::vector<double>& block = fSlots[tail % fSlots.size()];
+		for (size_t i = 0; i + fNumColumns <= block.size(); i += fNumColumns) {
+			fTarget->Fill(&block[i]);
+		}
+		block.clear();
+		fTail.store(tail + 1, std::memory_order_release);
+		Notify(fSlotFreed);
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AsyncRowWriter::Close()
+{
+	if (!fWriter.joinable()) return;
+
+	// Waiting for the remaining blocks counts as blocked time
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Push();
+	fStop.store(true, std::memory_order_release);
+	Notify(fBlockReady);
+	fWriter.join();
+	fTarget->Close();
+	fBlockedTime += Seconds(std::chrono::steady_clock::now() - start);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ThrottledRowWriter::ThrottledRowWriter(RowWriter* target, double delayPerRow)
+ : fTarget(target), fDelayPerRow(delayPerRow), fPendingDelay(0.), fBlockedTime(0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ThrottledRowWriter::~ThrottledRowWriter()
+{
+	delete fTarget;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ThrottledRowWriter::Fill(const double* row)
+{
+	// Sleeps are collected up to the minimum delay, since short sleeps
+	// overshoot by far more than their duration
+	fPendingDelay += fDelayPerRow;
+	if (fPendingDelay >= kMinSleep) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::this_thread::sleep_for(std::chrono::duration<double>(fPendingDelay));
+		double slept = Seconds(std::chrono::steady_clock::now() - start);
+		fPendingDelay -= slept;
+		fBlockedTime += slept;
+	}
+	fTarget->Fill(row);
+}
@@ -0,0 +1,65 @@
+#include "BatchPolicy.hh"
+
+#include <algorithm>
+
+namespace
+{
+	// Batches left per thread in guided self-scheduling
+	const long kGuidedFactor = 2;
+	// Least number of tasks per thread when the run is split into tasks
+	const long kTasksPerThread = 8;
+	// Weight kept by the previous samples at every new one
+	const double kDecay = 0.9;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+BatchPolicy::BatchPolicy(double targetBatchTime)
+ : fTargetBatchTime(targetBatchTime), fThreads(1), fSampleTime(0.), fSampleEvents(0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BatchPolicy::BeginRun(long, int threads)
+{
+	// The event cost is kept from the previous run, e.g. the previous segment
+	fThreads = threads > 0 ? threads : 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+long BatchPolicy::NextBatch(long remaining) const
+{
+	if (remaining <= 0) return 0;
+
+	double cost = GetEventCost();
+	if (cost <= 0.) return 1;
+
+	long batch = remaining/(kGuidedFactor*fThreads);
+	double capped = fTargetBatchTime/cost;
+	if (capped < batch) batch = (long) capped;
+	return std::max(1L, std::min(batch, remaining));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+long BatchPolicy::NumberOfTasks(long events) const
+{
+	if (events <= 0) return 1;
+
+	long tasks = kTasksPerThread*fThreads;
+	double cost = GetEventCost();
+	if (cost > 0. && fTargetBatchTime > 0.) tasks = std::max(tasks, (long) (events*cost/fTargetBatchTime));
+	return std::min(tasks, events);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void BatchPolicy::AddSample(double seconds, long events)
+{
+	if (events <= 0 || seconds < 0.) return;
+	fSampleTime = fSampleTime*kDecay + seconds;
+	fSampleEvents = fSampleEvents*kDecay + events;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
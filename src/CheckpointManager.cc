@@ -0,0 +1,239 @@
+#include "CheckpointManager.hh"
+#include "Run.hh"
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4GenericMessenger.hh"
+
+// Select output format for Analysis Manager
+#include "Analysis.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	std::atomic<bool> gStopRequested(false);
+
+	extern "C" void RequestStop(int)
+	{
+		gStopRequested.store(true);
+	}
+
+	const char* kCheckpointMagic = "AdEPTCubeSat-checkpoint-1";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CheckpointManager::CheckpointManager(G4bool resume)
+ : fMessenger(0), fResume(resume), fSegmentSize(10000000), fFirstEvent(0),
+   fShardIndex(0), fShardCount(0), fRangeFirst(0), fRangeCount(-1),
+   fSliceFirst(0), fTotalEvents(0), fSegmentsDone(0), fEventsDone(0), fSourceRays(0), fMasterSeed(0)
+{
+	// Define commands to control the segmented runs
+	DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CheckpointManager::~CheckpointManager()
+{
+	delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CheckpointManager::SetShard(G4int index, G4int count)
+{
+	fShardIndex = index;
+	fShardCount = count;
+	fRangeCount = -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CheckpointManager::SetRange(G4long first, G4long count)
+{
+	fRangeFirst = first;
+	fRangeCount = count;
+	fShardCount = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CheckpointManager::IsStopRequested()
+{
+	return gStopRequested.load(std::memory_order_relaxed);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CheckpointManager::BeamOn(G4int numberOfEvents)
+{
+	G4RunManager* runManager = G4RunManager::GetRunManager();
+	G4UImanager* uiManager = G4UImanager::GetUIpointer();
+	G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+
+	// Slice of the events processed here, and its file names
+	G4String fileName = analysisManager->GetFileName();
+	std::ostringstream baseName;
+	baseName << fileName;
+	G4long sliceStart = 0;
+	G4long sliceEnd = numberOfEvents;
+	if (fShardCount > 0) {
+		sliceStart = (G4long) numberOfEvents*fShardIndex/fShardCount;
+		sliceEnd = (G4long) numberOfEvents*(fShardIndex + 1)/fShardCount;
+		baseName << "_shard" << fShardIndex;
+	} else if (fRangeCount >= 0) {
+		sliceStart = std::min<G4long>(fRangeFirst, numberOfEvents);
+		sliceEnd = std::min<G4long>(fRangeFirst + fRangeCount, numberOfEvents);
+		baseName << "_first" << fRangeFirst;
+	}
+	fBaseName = baseName.str();
+	fSliceFirst = fFirstEvent + sliceStart;
+	fTotalEvents = sliceEnd - sliceStart;
+	fSegmentsDone = 0;
+	fEventsDone = 0;
+	fSourceRays = 0;
+	fHistograms.Reset();
+
+	// Every segmented run of the job continues from its own checkpoint,
+	// e.g. each energy of a scan; runs without one start from the beginning
+	G4String checkpointName = fBaseName + ".ckpt";
+	if (fResume) {
+		if (!LoadCheckpoint(checkpointName)) {
+			G4ExceptionDescription msg;
+			msg << "No matching checkpoint " << checkpointName << ", starting from the first event\n";
+			G4Exception("CheckpointManager::BeamOn()","Code005", JustWarning, msg);
+			fSegmentsDone = 0;
+			fEventsDone = 0;
+			fSourceRays = 0;
+			fHistograms.Reset();
+		} else if (fEventsDone >= fTotalEvents) {
+			G4cout << "Skipping " << fBaseName << ", all " << fTotalEvents << " events were done before" << G4endl;
+			return;
+		} else {
+			// The remaining segments must be seeded as before
+			std::ostringstream seedCmd;
+			seedCmd << "/AdEPTCubeSat/random/seed " << fMasterSeed;
+			uiManager->ApplyCommand(seedCmd.str());
+			uiManager->ApplyCommand("/AdEPTCubeSat/random/engine " + fEngineName);
+			G4cout << "Resuming " << fBaseName << " after segment " << fSegmentsDone - 1 << ", "
+				   << fEventsDone << " of " << fTotalEvents << " events done" << G4endl;
+		}
+	}
+
+	void (*previousTerm)(int) = std::signal(SIGTERM, RequestStop);
+	void (*previousInt)(int) = std::signal(SIGINT, RequestStop);
+
+	while (fEventsDone < fTotalEvents && !IsStopRequested()) {
+		G4int events = (G4int) std::min<G4long>(fSegmentSize, fTotalEvents - fEventsDone);
+
+		std::ostringstream fileCmd;
+		fileCmd << "/analysis/setFileName " << fBaseName << "_s" << fSegmentsDone;
+		uiManager->ApplyCommand(fileCmd.str());
+		std::ostringstream firstEventCmd;
+		firstEventCmd << "/AdEPTCubeSat/random/firstEvent " << fSliceFirst + fEventsDone;
+		uiManager->ApplyCommand(firstEventCmd.str());
+
+		runManager->BeamOn(events);
+
+		// An interrupted segment is done again after resuming
+		const Run* run = static_cast<const Run*>(runManager->GetCurrentRun());
+		if (IsStopRequested() || !run || run->GetNumberOfEvent() != events) break;
+
+		fHistograms.Add(run->GetHistograms());
+		fSourceRays += run->GetNumberOfSourceRays();
+		fMasterSeed = run->GetMasterSeed();
+		fEngineName = run->GetEngineName();
+		++fSegmentsDone;
+		fEventsDone += events;
+
+		fHistograms.Write(fBaseName + "_hist.csv");
+		if (!SaveCheckpoint(checkpointName)) {
+			G4ExceptionDescription msg;
+			msg << "Cannot write checkpoint " << checkpointName << "\n";
+			G4Exception("CheckpointManager::BeamOn()","Code005", JustWarning, msg);
+		}
+	}
+
+	std::signal(SIGTERM, previousTerm);
+	std::signal(SIGINT, previousInt);
+	uiManager->ApplyCommand("/analysis/setFileName " + fileName);
+
+	if (fEventsDone < fTotalEvents) {
+		G4cout << "Stopped " << fBaseName << " after " << fEventsDone << " of " << fTotalEvents
+			   << " events, continue with --resume" << G4endl;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CheckpointManager::SaveCheckpoint(const G4String& fileName) const
+{
+	// Written beside the previous checkpoint and renamed over it, so that a
+	// stop while writing keeps the previous one
+	G4String tmpName = fileName + ".tmp";
+	{
+		std::ofstream out(tmpName);
+		out << kCheckpointMagic << "\n"
+			<< "totalEvents " << fTotalEvents << "\n"
+			<< "segmentSize " << fSegmentSize << "\n"
+			<< "firstEvent " << fSliceFirst << "\n"
+			<< "segmentsDone " << fSegmentsDone << "\n"
+			<< "eventsDone " << fEventsDone << "\n"
+			<< "sourceRays " << fSourceRays << "\n"
+			<< "masterSeed " << fMasterSeed << "\n"
+			<< "engine " << fEngineName << "\n"
+			<< "histograms\n";
+		fHistograms.Save(out);
+		out.flush();
+		if (!out) return false;
+	}
+	return std::rename(tmpName.c_str(), fileName.c_str()) == 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CheckpointManager::LoadCheckpoint(const G4String& fileName)
+{
+	std::ifstream in(fileName);
+	std::string magic, key;
+	G4long totalEvents = 0, segmentSize = 0, firstEvent = 0;
+	if (!(in >> magic) || magic != kCheckpointMagic) return false;
+	in >> key >> totalEvents >> key >> segmentSize >> key >> firstEvent
+	   >> key >> fSegmentsDone >> key >> fEventsDone >> key >> fSourceRays
+	   >> key >> fMasterSeed >> key >> fEngineName >> key;
+	if (!in || key != "histograms" || !fHistograms.Load(in)) return false;
+
+	// Only the same segmented run can be continued
+	return totalEvents == fTotalEvents && segmentSize == fSegmentSize && firstEvent == fSliceFirst;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CheckpointManager::DefineCommands()
+{
+	// Define /AdEPTCubeSat/checkpoint/ command directory using generic messenger class
+	fMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/checkpoint/", "Segmented runs with checkpoints");
+
+	G4GenericMessenger::Command& beamOnCmd = fMessenger->DeclareMethod("beamOn", &CheckpointManager::BeamOn,
+		"Process the given number of events as consecutive runs of at most\n"
+		"segmentSize events, writing a checkpoint after each. Start the job with\n"
+		"--resume to continue an interrupted run from its last checkpoint.");
+	beamOnCmd.SetParameterName("numberOfEvents", false);
+	beamOnCmd.SetRange("numberOfEvents>0");
+
+	G4GenericMessenger::Command& segmentCmd = fMessenger->DeclareProperty("segmentSize", fSegmentSize,
+		"Events per segment, i.e. between two checkpoints.");
+	segmentCmd.SetParameterName("segmentSize", false);
+	segmentCmd.SetRange("segmentSize>0");
+
+	G4GenericMessenger::Command& firstEventCmd = fMessenger->DeclareProperty("firstEvent", fFirstEvent,
+		"Event number of the first event of the segmented run.");
+	firstEventCmd.SetParameterName("firstEvent", false);
+	firstEventCmd.SetRange("firstEvent>=0");
+}
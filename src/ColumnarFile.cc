@@ -0,0 +1,367 @@
+#include "ColumnarFile.hh"
+
+#include <cstring>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+	const char kHeaderMagic[8] = { 'A','E','C','O','L','0','0','1' };
+	const char kTrailerMagic[8] = { 'A','E','C','O','L','E','N','D' };
+
+	// Little-endian serialisation of the fixed-width integers of the format
+	void PutU8(std::vector<unsigned char>& out, unsigned value)
+	{
+		out.push_back((unsigned char) value);
+	}
+
+	void PutU16(std::vector<unsigned char>& out, unsigned value)
+	{
+		for (int i = 0; i < 2; ++i) out.push_back((unsigned char) (value >> (8*i)));
+	}
+
+	void PutU32(std::vector<unsigned char>& out, uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i) out.push_back((unsigned char) (value >> (8*i)));
+	}
+
+	void PutU64(std::vector<unsigned char>& out, uint64_t value)
+	{
+		for (int i = 0; i < 8; ++i) out.push_back((unsigned char) (value >> (8*i)));
+	}
+
+	uint64_t GetLE(const unsigned char* in, int bytes)
+	{
+		uint64_t value = 0;
+		for (int i = 0; i < bytes; ++i) value |= uint64_t(in[i]) << (8*i);
+		return value;
+	}
+
+	bool ReadBytes(FILE* file, unsigned char* out, size_t size)
+	{
+		return std::fread(out, 1, size, file) == size;
+	}
+
+	// Values are stored as little-endian bytes of their native representation
+	void AppendValue(std::vector<unsigned char>& out, Columnar::ColumnType type, double value)
+	{
+		unsigned char bytes[8];
+		size_t width = Columnar::TypeSize(type);
+		if (type == Columnar::kFloat) {
+			float v = (float) value;
+			uint32_t bits; std::memcpy(&bits, &v, 4);
+			for (int i = 0; i < 4; ++i) bytes[i] = (unsigned char) (bits >> (8*i));
+		} else if (type == Columnar::kDouble) {
+			uint64_t bits; std::memcpy(&bits, &value, 8);
+			for (int i = 0; i < 8; ++i) bytes[i] = (unsigned char) (bits >> (8*i));
+		} else {
+			int32_t v = (int32_t) (value < 0. ? value - 0.5 : value + 0.5);
+			uint32_t bits = (uint32_t) v;
+			for (int i = 0; i < 4; ++i) bytes[i] = (unsigned char) (bits >> (8*i));
+		}
+		out.insert(out.end(), bytes, bytes + width);
+	}
+
+	double ExtractValue(const unsigned char* in, Columnar::ColumnType type)
+	{
+		if (type == Columnar::kFloat) {
+			uint32_t bits = (uint32_t) GetLE(in, 4);
+			float v; std::memcpy(&v, &bits, 4);
+			return v;
+		} else if (type == Columnar::kDouble) {
+			uint64_t bits = GetLE(in, 8);
+			double v; std::memcpy(&v, &bits, 8);
+			return v;
+		}
+		return (double) (int32_t) (uint32_t) GetLE(in, 4);
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+size_t Columnar::TypeSize(ColumnType type)
+{
+	return (type == kDouble) ? 8 : 4;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Columnar::Encode(const std::vector<unsigned char>& values, size_t width, std::vector<unsigned char>& out)
+{
+	// Byte shuffle: group byte b of every value together, so that the mostly
+	// constant high-order bytes of small counts and energies form long runs
+	size_t count = values.size()/width;
+	std::vector<unsigned char> shuffled(values.size());
+	for (size_t i = 0; i < count; ++i) {
+		for (size_t b = 0; b < width; ++b) shuffled[b*count + i] = values[i*width + b];
+	}
+
+	// Zero-run-length encoding. Control byte c < 128: c+1 literal bytes follow.
+	// Control byte c >= 128: a run of c-127 zero bytes.
+	out.clear();
+	size_t pos = 0;
+	while (pos < shuffled.size()) {
+		if (shuffled[pos] == 0) {
+			size_t run = 0;
+			while (pos + run < shuffled.size() && shuffled[pos + run] == 0 && run < 128) ++run;
+			out.push_back((unsigned char) (127 + run));
+			pos += run;
+		} else {
+			size_t run = 0;
+			while (pos + run < shuffled.size() && run < 128) {
+				// A pair of zeros is cheaper as a zero run
+				if (shuffled[pos + run] == 0 && pos + run + 1 < shuffled.size() && shuffled[pos + run + 1] == 0) break;
+				++run;
+			}
+			out.push_back((unsigned char) (run - 1));
+			out.insert(out.end(), shuffled.begin() + pos, shuffled.begin() + pos + run);
+			pos += run;
+		}
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool Columnar::Decode(const unsigned char* in, size_t size, size_t width, size_t count, std::vector<unsigned char>& out)
+{
+	std::vector<unsigned char> shuffled;
+	shuffled.reserve(width*count);
+	size_t pos = 0;
+	while (pos < size) {
+		unsigned control = in[pos++];
+		if (control >= 128) {
+			shuffled.insert(shuffled.end(), control - 127, (unsigned char) 0);
+		} else {
+			size_t run = control + 1;
+			if (pos + run > size) return false;
+			shuffled.insert(shuffled.end(), in + pos, in + pos + run);
+			pos += run;
+		}
+	}
+	if (shuffled.size() != width*count) return false;
+
+	out.resize(width*count);
+	for (size_t i = 0; i < count; ++i) {
+		for (size_t b = 0; b < width; ++b) out[i*width + b] = shuffled[b*count + i];
+	}
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ColumnarWriter::ColumnarWriter()
+ : fFile(0), fOffset(0), fChunkSize(65536), fRowsInChunk(0), fTotalRows(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ColumnarWriter::~ColumnarWriter()
+{
+	Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ColumnarWriter::AddColumn(const std::string& name, Columnar::ColumnType type)
+{
+	Columnar::Column column;
+	column.name = name;
+	column.type = type;
+	fColumns.push_back(column);
+	fBuffers.push_back(std::vector<unsigned char>());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool ColumnarWriter::Open(const std::string& fileName)
+{
+	Close();
+	fFile = std::fopen(fileName.c_str(), "wb");
+	if (!fFile) return false;
+
+	fChunks.clear();
+	fRowsInChunk = 0;
+	fTotalRows = 0;
+	for (size_t i = 0; i < fBuffers.size(); ++i) {
+		fBuffers[i].clear();
+		fBuffers[i].reserve(fChunkSize*Columnar::TypeSize(fColumns[i].type));
+	}
+
+	// Header: magic, then the column schema
+	std::vector<unsigned char> header(kHeaderMagic, kHeaderMagic + 8);
+	PutU32(header, (uint32_t) fColumns.size());
+	for (size_t i = 0; i < fColumns.size(); ++i) {
+		PutU8(header, fColumns[i].type);
+		PutU16(header, (unsigned) fColumns[i].name.size());
+		header.insert(header.end(), fColumns[i].name.begin(), fColumns[i].name.end());
+	}
+	std::fwrite(&header[0], 1, header.size(), fFile);
+	fOffset = header.size();
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ColumnarWriter::Fill(const double* row)
+{
+	if (!fFile) return;
+	for (size_t i = 0; i < fColumns.size(); ++i) AppendValue(fBuffers[i], fColumns[i].type, row[i]);
+	++fTotalRows;
+	if (++fRowsInChunk >= fChunkSize) FlushChunk();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ColumnarWriter::FlushChunk()
+{
+	if (fRowsInChunk == 0) return;
+
+	Columnar::ChunkInfo chunk;
+	chunk.offset = fOffset;
+	chunk.rows = (uint32_t) fRowsInChunk;
+	chunk.bytes = 0;
+
+	std::vector<unsigned char> block;
+	for (size_t i = 0; i < fColumns.size(); ++i) {
+		Columnar::Encode(fBuffers[i], Columnar::TypeSize(fColumns[i].type), fEncoded);
+		bool useRaw = fEncoded.size() >= fBuffers[i].size();
+		const std::vector<unsigned char>& data = useRaw ? fBuffers[i] : fEncoded;
+
+		block.clear();
+		PutU8(block, useRaw ? Columnar::kRaw : Columnar::kShuffleZeroRLE);
+		PutU32(block, (uint32_t) data.size());
+		std::fwrite(&block[0], 1, block.size(), fFile);
+		if (!data.empty()) std::fwrite(&data[0], 1, data.size(), fFile);
+		chunk.bytes += (uint32_t) (block.size() + data.size());
+		fBuffers[i].clear();
+	}
+
+	fOffset += chunk.bytes;
+	fChunks.push_back(chunk);
+	fRowsInChunk = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ColumnarWriter::Close()
+{
+	if (!fFile) return;
+	FlushChunk();
+
+	// Footer with the chunk index, then the trailer pointing at it
+	std::vector<unsigned char> footer;
+	PutU32(footer, (uint32_t) fChunks.size());
+	for (size_t i = 0; i < fChunks.size(); ++i) {
+		PutU64(footer, fChunks[i].offset);
+		PutU32(footer, fChunks[i].rows);
+		PutU32(footer, fChunks[i].bytes);
+	}
+	PutU64(footer, fTotalRows);
+	PutU64(footer, fOffset);
+	footer.insert(footer.end(), kTrailerMagic, kTrailerMagic + 8);
+	std::fwrite(&footer[0], 1, footer.size(), fFile);
+
+	std::fclose(fFile);
+	fFile = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ColumnarReader::ColumnarReader()
+ : fFile(0), fTotalRows(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ColumnarReader::~ColumnarReader()
+{
+	Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ColumnarReader::Close()
+{
+	if (fFile) std::fclose(fFile);
+	fFile = 0;
+	fColumns.clear();
+	fChunks.clear();
+	fTotalRows = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool ColumnarReader::Open(const std::string& fileName)
+{
+	Close();
+	fFile = std::fopen(fileName.c_str(), "rb");
+	if (!fFile) return false;
+
+	// Header
+	unsigned char buffer[16];
+	if (!ReadBytes(fFile, buffer, 12) || std::memcmp(buffer, kHeaderMagic, 8) != 0) { Close(); return false; }
+	uint32_t numColumns = (uint32_t) GetLE(buffer + 8, 4);
+	for (uint32_t i = 0; i < numColumns; ++i) {
+		if (!ReadBytes(fFile, buffer, 3) || buffer[0] > Columnar::kInt) { Close(); return false; }
+		Columnar::Column column;
+		column.type = (Columnar::ColumnType) buffer[0];
+		std::vector<char> name((size_t) GetLE(buffer + 1, 2) + 1, '\0');
+		if (std::fread(&name[0], 1, name.size() - 1, fFile) != name.size() - 1) { Close(); return false; }
+		column.name = &name[0];
+		fColumns.push_back(column);
+	}
+
+	// Trailer, then the footer it points at
+	if (std::fseek(fFile, -16, SEEK_END) != 0 || !ReadBytes(fFile, buffer, 16)
+		|| std::memcmp(buffer + 8, kTrailerMagic, 8) != 0) { Close(); return false; }
+	uint64_t footerOffset = GetLE(buffer, 8);
+	if (std::fseek(fFile, (long) footerOffset, SEEK_SET) != 0 || !ReadBytes(fFile, buffer, 4)) { Close(); return false; }
+	uint32_t numChunks = (uint32_t) GetLE(buffer, 4);
+	for (uint32_t i = 0; i < numChunks; ++i) {
+		if (!ReadBytes(fFile, buffer, 16)) { Close(); return false; }
+		Columnar::ChunkInfo chunk;
+		chunk.offset = GetLE(buffer, 8);
+		chunk.rows = (uint32_t) GetLE(buffer + 8, 4);
+		chunk.bytes = (uint32_t) GetLE(buffer + 12, 4);
+		fChunks.push_back(chunk);
+	}
+	if (!ReadBytes(fFile, buffer, 8)) { Close(); return false; }
+	fTotalRows = GetLE(buffer, 8);
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool ColumnarReader::ReadChunk(size_t chunk, std::vector< std::vector<double> >& columns)
+{
+	if (!fFile || chunk >= fChunks.size()) return false;
+	const Columnar::ChunkInfo& info = fChunks[chunk];
+	if (std::fseek(fFile, (long) info.offset, SEEK_SET) != 0) return false;
+
+	columns.resize(fColumns.size());
+	unsigned char buffer[5];
+	for (size_t i = 0; i < fColumns.size(); ++i) {
+		if (!ReadBytes(fFile, buffer, 5)) return false;
+		size_t size = (size_t) GetLE(buffer + 1, 4);
+		fBlock.resize(size);
+		if (size > 0 && !ReadBytes(fFile, &fBlock[0], size)) return false;
+
+		size_t width = Columnar::TypeSize(fColumns[i].type);
+		const unsigned char* values = 0;
+		if (buffer[0] == Columnar::kRaw) {
+			if (size != width*info.rows) return false;
+			values = fBlock.empty() ? 0 : &fBlock[0];
+		} else if (buffer[0] == Columnar::kShuffleZeroRLE) {
+			if (!Columnar::Decode(fBlock.empty() ? 0 : &fBlock[0], size, width, info.rows, fDecoded)) return false;
+			values = fDecoded.empty() ? 0 : &fDecoded[0];
+		} else {
+			return false;
+		}
+
+		columns[i].resize(info.rows);
+		for (uint32_t row = 0; row < info.rows; ++row) {
+			columns[i][row] = ExtractValue(values + row*width, fColumns[i].type);
+		}
+	}
+	return true;
+}
@@ -10,10 +10,16 @@
 // ********************************************************************
 
 #include "DetectorConstruction.hh"
+#include "InitTimer.hh"
+#include "OverlapChecker.hh"
 #include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <sstream>
 
 // Units and constants
 #include "G4SystemOfUnits.hh"
+#include "G4UnitsTable.hh"
 #include "G4PhysicalConstants.hh"
 
 // Manager classes
@@ -21,11 +27,13 @@
 #include "G4NistManager.hh"
 #include "G4GeometryManager.hh"
 #include "G4SDManager.hh"
+#include "G4UImanager.hh"
 
 // Store classes
 #include "G4PhysicalVolumeStore.hh"
 #include "G4LogicalVolumeStore.hh"
 #include "G4SolidStore.hh"
+#include "G4RegionStore.hh"
 
 // Geometry classes
 #include "G4LogicalVolume.hh"
@@ -42,29 +50,31 @@
 // Boolean operations on volumes
 #include "G4UnionSolid.hh"
 #include "G4SubtractionSolid.hh"
+#include "G4Version.hh"
+#if G4VERSION_NUMBER >= 1010
+#include "G4MultiUnion.hh"
+#endif
 
 // Regions
 #include "G4Region.hh"
 
+// Biasing classes
+#include "G4BOptrForceCollision.hh"
+
 // Messenger classes
 #include "G4GenericMessenger.hh"
 
 // Scoring Components
-#include "G4MultiFunctionalDetector.hh"
-#include "G4PSEnergyDeposit.hh"
-#include "G4PSTrackLength.hh"
-#include "G4PSPassageTrackLength.hh"
-#include "G4PSPassageCellCurrent.hh"
-#include "G4PSNofSecondary.hh"
-#include "G4VSDFilter.hh"
-#include "G4SDParticleFilter.hh"
-#include "G4ProductionCuts.hh"
+#include "SensitiveGasSD.hh"
+#include "RangeOutModel.hh"
+#include "NeutronBiasingOperator.hh"
+#include "PhysicsList.hh"
 
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-DetectorConstruction::DetectorConstruction(): G4VUserDetectorConstruction(), fCheckOverlaps(true),
-WorldPhysical(0)
+DetectorConstruction::DetectorConstruction(): G4VUserDetectorConstruction(), fCheckOverlaps(false),
+fVesselModel("boolean"), WorldPhysical(0)
 {	
 	// Geometry Parameters (Default)
 	// Pressure Vessel Top
@@ -138,27 +148,31 @@ WorldPhysical(0)
 			
 	// Rotation Angle
 	rotX = 0.0*deg;		
+	fVesselRotation = new G4RotationMatrix();
+	UpdateEnvelope();
+	
+	// Detector gas as defined in DefineMaterials
+	fGasName = "Ar_95_CS2_5";
+	fGasPressure = 1.5*atmosphere;
+	fGasTemperature = 293.15*kelvin;
 			 
 	// Define Materials
 	DefineMaterials();
 	
 	// Define commands to control the geometry
    	DefineCommands();
-	   
-		// Production cuts for secondary particle generation
-	G4double cut = 50.*um;
-  	fTrackerCuts = new G4ProductionCuts();
-  	fTrackerCuts->SetProductionCut(cut,"gamma");
-  	fTrackerCuts->SetProductionCut(cut,"e-");
-  	fTrackerCuts->SetProductionCut(cut,"e+");
-  	fTrackerCuts->SetProductionCut(cut,"proton");
+   	
+   	// Overlap check of the placements (/AdEPTCubeSat/overlaps/)
+   	fOverlapChecker = new OverlapChecker();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 DetectorConstruction::~DetectorConstruction()
 {
-	delete fTrackerCuts; 
+	delete fOverlapChecker;
+	delete fVesselRotation;
+	delete fGasMessenger;
 }
 
 
@@ -247,7 +261,7 @@ void DetectorConstruction::DefineMaterials()
   	// Set the materials for the Geometry
   	fMatWorld = galactic;
   	fMatPressureVessel = Al;
-  	fMatGas = Ar_95_CS2_5;//Ar_293K_1p5atm;//BoronGas;//Helium3;//
+  	fMatGas = Ar_95_CS2_5;	// Selected with /AdEPTCubeSat/gas/
 	fMatPCB = G10;
 	fMatMWD = Si; 
   	
@@ -260,6 +274,11 @@ void DetectorConstruction::DefineMaterials()
 
 G4VPhysicalVolume* DetectorConstruction::Construct()
 { 	
+	InitTimer::Begin("Geometry");
+	
+	// Placements check themselves only in serial mode
+	fCheckOverlaps = (fOverlapChecker->GetMode() == "serial");
+	
 	// Cleanup old geometry
   	G4GeometryManager::GetInstance()->OpenGeometry();
   	G4PhysicalVolumeStore::GetInstance()->Clean();
@@ -270,11 +289,9 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	////////////////////////////////////////////////////////////////////////
 	// Construct The World Volume (Vacuum)
 
-	G4double world_X = 2*PV_gas_length;
-	G4double world_Y = 2*PV_gas_width;
-	G4double world_Z = 2*PV_gas_height;
+	G4ThreeVector worldHalf = GetWorldHalfLengths();
 	
-	G4Box* WorldSolid = new G4Box("World", world_X/2, world_Y/2, world_Z/2);
+	G4Box* WorldSolid = new G4Box("World", worldHalf.x(), worldHalf.y(), worldHalf.z());
   
 	WorldLogical = 
 		new G4LogicalVolume(WorldSolid,						// The Solid
@@ -292,85 +309,18 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 							fCheckOverlaps);				// Overlap Check
 							
 	////////////////////////////////////////////////////////////////////////
-	// Presure Vessel Construct
-	
-	G4Box* PVtopSolid = new G4Box("PressureVesselTop", PV_length/2, PV_width/2, PV_height/2);
-	G4Box* PVbottomSolid = new G4Box("PressureVesselBottom", PV_bottom_length/2, PV_bottom_width/2, PV_bottom_height/2);
-	
-	G4UnionSolid* PVSolidBody = new G4UnionSolid("PressureVessel", PVtopSolid, PVbottomSolid, 0, G4ThreeVector(0,0,(PV_height+PV_bottom_height)/2 - 0.001*mm));
-
-	
-	////////////////////////////////////////////////////////////////////////
-	// Pressure Vessel Side Cutouts
-	
-	G4Box* PVSideCut = new G4Box("PressureVesselSideCut", PV_sidecut_depth/2, PV_short_sidecut_length/2, PV_short_sidecut_width/2);
-							
-	G4Box* PVSideCut_3 = new G4Box("PressureVesselSideCut", PV_sidecut_length/2, PV_sidecut_depth/2, PV_sidecut_width/2);
-	
-	////////////////////////////////////////////////////////////////////////
-	// Pressure Vessel Top Cutouts
-	
-	G4Box* PVTopCut = new G4Box("PressureVesselTopCut", PV_topcut_length/2, PV_topcut_width/2, PV_topcut_depth/2);
-	
-	////////////////////////////////////////////////////////////////////////
-	// Subtraction of cutouts from Pressure Vessel
-	
-	G4SubtractionSolid* PVSolid_1 = 
-		new G4SubtractionSolid("PressureVesselSolid", PVSolidBody, PVSideCut, 0, G4ThreeVector((PV_length-PV_sidecut_depth)/2,0,0));
-	
-	G4SubtractionSolid* PVSolid_2 = 
-		new G4SubtractionSolid("PressureVesselSolid", PVSolid_1, PVSideCut, 0, G4ThreeVector(-(PV_length-PV_sidecut_depth)/2,0,0));
-	
-	G4SubtractionSolid* PVSolid_3 = 
-		new G4SubtractionSolid("PressureVesselSolid", PVSolid_2, PVSideCut_3, 0, G4ThreeVector(0,(PV_width-PV_sidecut_depth)/2,0));
-	
-	G4SubtractionSolid* PVSolid_4 = 
-		new G4SubtractionSolid("PressureVesselSolid", PVSolid_3, PVSideCut_3, 0, G4ThreeVector(0,-(PV_width-PV_sidecut_depth)/2,0));
-	
-	G4SubtractionSolid* PVSolid =
-		new G4SubtractionSolid("PressureVesselSolid", PVSolid_4, PVTopCut, 0, G4ThreeVector(0,0,-(PV_height-PV_topcut_depth)/2));
-	
-	PVLogical =
-		new G4LogicalVolume(PVSolid,
-							fMatPressureVessel,
-							"PressureVessel");
-							
-	PVPhysical = 
-		new G4PVPlacement(	0,
-							G4ThreeVector(),
-							PVLogical,
-							"PressureVessel",
-							WorldLogical,
-							false,
-							0,
-							fCheckOverlaps);
-
-	////////////////////////////////////////////////////////////////////////
-	// Pressure Vessel Detector Gas
+	// Presure Vessel and its Detector Gas
 	
-	G4Box* PVGasTop = new G4Box("PressureVesselGasTop", PV_gas_length/2, PV_gas_width/2, PV_gas_height/2);
-	G4Box* PVGasMid = new G4Box("PressureVesselGasMid", PV_mid_gas_length/2, PV_mid_gas_width/2, PV_mid_gas_height/2);
-	G4Box* PVGasBottom = new G4Box("PressureVesselGasBottom", PV_bottom_gas_length/2, PV_bottom_gas_width/2, PV_bottom_gas_height/2);
-	
-	G4UnionSolid* PVGasTemp = new G4UnionSolid("PressureVesselGasTemp", PVGasTop, PVGasMid, 0, G4ThreeVector(0,0,(PV_gas_height+PV_mid_gas_height)/2));
-	G4UnionSolid* PVGas = new G4UnionSolid("PressureVesselGas", PVGasTemp, PVGasBottom, 0, G4ThreeVector(0,0,(2*PV_mid_gas_height+PV_gas_height+PV_bottom_gas_height)/2));
+	// Only the boxes vessel places its cutouts
+	PVSideCutPhysical_1 = PVSideCutPhysical_2 = PVSideCutPhysical_3 = PVSideCutPhysical_4 = 0;
+	PVTopCutPhysical = 0;
 	
-	PVGasLogical = 
-		new G4LogicalVolume(PVGas,
-							fMatGas,
-							"PressureVesselGas");
-							
-	PVGasPhysical = 
-		new G4PVPlacement(	0,
-							G4ThreeVector(),
-							PVGasLogical,
-							"PressureVesselGas",
-							PVLogical,
-							false,
-							0,
-							fCheckOverlaps);
+	if (fVesselModel == "boxes") ConstructBoxVessel();
+	else ConstructBooleanVessel();
 
-	G4Region* regPVGas = new G4Region("Region_PV_Gas");
+	// The regions outlive a rebuild of the geometry, which keeps their
+	// production cuts
+	G4Region* regPVGas = G4RegionStore::GetInstance()->FindOrCreateRegion("Region_PV_Gas");
   	PVGasLogical->SetRegion(regPVGas);
   	regPVGas->AddRootLogicalVolume(PVGasLogical);
 	  
@@ -394,7 +344,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 							0,
 							fCheckOverlaps);
 							
-	G4Region* regSensitiveGas = new G4Region("Region_Sensitive_Gas");
+	G4Region* regSensitiveGas = G4RegionStore::GetInstance()->FindOrCreateRegion("Region_Sensitive_Gas");
   	PVSensitiveGasLogical->SetRegion(regSensitiveGas);
   	regSensitiveGas->AddRootLogicalVolume(PVSensitiveGasLogical);
 							
@@ -410,7 +360,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	
 	TopPCBPhysical =
 		new G4PVPlacement(	0,
-							G4ThreeVector(0,0,(-PV_gas_height+5.*mm)/2),//-39.5-0.8),//(-PV_gas_height+8.*mm+Top_PCB_thickness)/2),
+							G4ThreeVector(0,0,GetTopPCBZ()),//-39.5-0.8),//(-PV_gas_height+8.*mm+Top_PCB_thickness)/2),
 							TopPCBLogical,
 							"TopPCB",
 							PVGasLogical,
@@ -430,7 +380,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	
 	BottomPCBPhysical =
 		new G4PVPlacement(	0,
-							G4ThreeVector(0,0,(PV_gas_height-7.*mm)/2),//(PV_gas_height-Top_PCB_thickness-9*mm)/2),
+							G4ThreeVector(0,0,GetBottomPCBZ()),//(PV_gas_height-Top_PCB_thickness-9*mm)/2),
 							BottomPCBLogical,
 							"BottomPCB",
 							PVGasLogical,
@@ -450,7 +400,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	
 	CapPCBPhysical = 
 		new G4PVPlacement(	0,
-							G4ThreeVector(0,0,((PV_gas_height-Bottom_PCB_thickness)/2+PV_bottom_gas_height+PV_mid_gas_height)),
+							G4ThreeVector(0,0,GetCapPCBZ()),
 							CapPCBLogical,
 							"CapPCB",
 							PVGasLogical,
@@ -470,7 +420,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 							
 	MWDPhysical =
 		new G4PVPlacement(	0,
-							G4ThreeVector(0,0,(-0.8+0.5)),//(PV_gas_height/2-5.6*mm-MWD_thickness)),
+							G4ThreeVector(0,0,GetMWDZ()),//(PV_gas_height/2-5.6*mm-MWD_thickness)),
 							MWDLogical,
 							"MicrowellDetector",
 							BottomPCBLogical,
@@ -545,80 +495,348 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
 	////////////////////////////////////////////////////////////////////////
 	// Return world volume
+	InitTimer::End("Geometry");
+	
+	InitTimer::Begin("Overlap check");
+	fOverlapChecker->Check(WorldPhysical);
+	InitTimer::End("Overlap check");
+	
 	return WorldPhysical; 
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void DetectorConstruction::ConstructBooleanVessel()
+{
+	////////////////////////////////////////////////////////////////////////
+	// Presure Vessel Construct
+	
+	G4Box* PVtopSolid = new G4Box("PressureVesselTop", PV_length/2, PV_width/2, PV_height/2);
+	G4Box* PVbottomSolid = new G4Box("PressureVesselBottom", PV_bottom_length/2, PV_bottom_width/2, PV_bottom_height/2);
+	
+	G4UnionSolid* PVSolidBody = new G4UnionSolid("PressureVessel", PVtopSolid, PVbottomSolid, 0, G4ThreeVector(0,0,(PV_height+PV_bottom_height)/2 - 0.001*mm));
+
+	
+	////////////////////////////////////////////////////////////////////////
+	// Pressure Vessel Side Cutouts
+	
+	G4Box* PVSideCut = new G4Box("PressureVesselSideCut", PV_sidecut_depth/2, PV_short_sidecut_length/2, PV_short_sidecut_width/2);
+							
+	G4Box* PVSideCut_3 = new G4Box("PressureVesselSideCut", PV_sidecut_length/2, PV_sidecut_depth/2, PV_sidecut_width/2);
+	
+	////////////////////////////////////////////////////////////////////////
+	// Pressure Vessel Top Cutouts
+	
+	G4Box* PVTopCut = new G4Box("PressureVesselTopCut", PV_topcut_length/2, PV_topcut_width/2, PV_topcut_depth/2);
+	
+	////////////////////////////////////////////////////////////////////////
+	// Subtraction of cutouts from Pressure Vessel
+	
+	G4SubtractionSolid* PVSolid_1 = 
+		new G4SubtractionSolid("PressureVesselSolid", PVSolidBody, PVSideCut, 0, G4ThreeVector((PV_length-PV_sidecut_depth)/2,0,0));
+	
+	G4SubtractionSolid* PVSolid_2 = 
+		new G4SubtractionSolid("PressureVesselSolid", PVSolid_1, PVSideCut, 0, G4ThreeVector(-(PV_length-PV_sidecut_depth)/2,0,0));
+	
+	G4SubtractionSolid* PVSolid_3 = 
+		new G4SubtractionSolid("PressureVesselSolid", PVSolid_2, PVSideCut_3, 0, G4ThreeVector(0,(PV_width-PV_sidecut_depth)/2,0));
+	
+	G4SubtractionSolid* PVSolid_4 = 
+		new G4SubtractionSolid("PressureVesselSolid", PVSolid_3, PVSideCut_3, 0, G4ThreeVector(0,-(PV_width-PV_sidecut_depth)/2,0));
+	
+	G4SubtractionSolid* PVSolid =
+		new G4SubtractionSolid("PressureVesselSolid", PVSolid_4, PVTopCut, 0, G4ThreeVector(0,0,-(PV_height-PV_topcut_depth)/2));
+	
+	PVLogical =
+		new G4LogicalVolume(PVSolid,
+							fMatPressureVessel,
+							"PressureVessel");
+							
+	PVPhysical = 
+		new G4PVPlacement(	fVesselRotation,
+							G4ThreeVector(),
+							PVLogical,
+							"PressureVessel",
+							WorldLogical,
+							false,
+							0,
+							fCheckOverlaps);
+
+	////////////////////////////////////////////////////////////////////////
+	// Pressure Vessel Detector Gas
+	
+	G4Box* PVGasTop = new G4Box("PressureVesselGasTop", PV_gas_length/2, PV_gas_width/2, PV_gas_height/2);
+	G4Box* PVGasMid = new G4Box("PressureVesselGasMid", PV_mid_gas_length/2, PV_mid_gas_width/2, PV_mid_gas_height/2);
+	G4Box* PVGasBottom = new G4Box("PressureVesselGasBottom", PV_bottom_gas_length/2, PV_bottom_gas_width/2, PV_bottom_gas_height/2);
+	
+	G4UnionSolid* PVGasTemp = new G4UnionSolid("PressureVesselGasTemp", PVGasTop, PVGasMid, 0, G4ThreeVector(0,0,(PV_gas_height+PV_mid_gas_height)/2));
+	G4UnionSolid* PVGas = new G4UnionSolid("PressureVesselGas", PVGasTemp, PVGasBottom, 0, G4ThreeVector(0,0,(2*PV_mid_gas_height+PV_gas_height+PV_bottom_gas_height)/2));
+	
+	PVGasLogical = 
+		new G4LogicalVolume(PVGas,
+							fMatGas,
+							"PressureVesselGas");
+							
+	PVGasPhysical = 
+		new G4PVPlacement(	0,
+							G4ThreeVector(),
+							PVGasLogical,
+							"PressureVesselGas",
+							PVLogical,
+							false,
+							0,
+							fCheckOverlaps);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::ConstructBoxVessel()
+{
+	// Same vessel and gas as ConstructBooleanVessel without Boolean solids:
+	// the bodies are voxelized multi-unions of boxes and the cutouts are
+	// vacuum boxes placed in the vessel, so navigation only meets boxes.
+	// Mass and envelope are identical.
+	
+	#if G4VERSION_NUMBER >= 1010
+	////////////////////////////////////////////////////////////////////////
+	// Presure Vessel Construct
+	
+	// The bottom starts at the face of the top rather than overlapping it by
+	// 0.001 mm, which covers the same region
+	G4double PV_bottom_overlap = 0.001*mm;
+	G4double PV_bottom_body_height = PV_bottom_height - PV_bottom_overlap;
+	
+	G4Box* PVtopSolid = new G4Box("PressureVesselTop", PV_length/2, PV_width/2, PV_height/2);
+	G4Box* PVbottomSolid = new G4Box("PressureVesselBottom", PV_bottom_length/2, PV_bottom_width/2, PV_bottom_body_height/2);
+	
+	G4Transform3D PVtopTransform;
+	G4Transform3D PVbottomTransform(G4RotationMatrix(), G4ThreeVector(0,0,(PV_height+PV_bottom_body_height)/2));
+	
+	G4MultiUnion* PVSolid = new G4MultiUnion("PressureVesselSolid");
+	PVSolid->AddNode(*PVtopSolid, PVtopTransform);
+	PVSolid->AddNode(*PVbottomSolid, PVbottomTransform);
+	PVSolid->Voxelize();
+	
+	PVLogical =
+		new G4LogicalVolume(PVSolid,
+							fMatPressureVessel,
+							"PressureVessel");
+							
+	PVPhysical = 
+		new G4PVPlacement(	fVesselRotation,
+							G4ThreeVector(),
+							PVLogical,
+							"PressureVessel",
+							WorldLogical,
+							false,
+							0,
+							fCheckOverlaps);
+	
+	////////////////////////////////////////////////////////////////////////
+	// Pressure Vessel Side Cutouts
+	
+	G4Box* PVSideCut = new G4Box("PressureVesselSideCut", PV_sidecut_depth/2, PV_short_sidecut_length/2, PV_short_sidecut_width/2);
+							
+	G4Box* PVSideCut_3 = new G4Box("PressureVesselSideCut", PV_sidecut_length/2, PV_sidecut_depth/2, PV_sidecut_width/2);
+	
+	PVSideCutLogical_1 = new G4LogicalVolume(PVSideCut, fMatWorld, "PressureVesselSideCut");
+	PVSideCutLogical_2 = new G4LogicalVolume(PVSideCut, fMatWorld, "PressureVesselSideCut");
+	PVSideCutLogical_3 = new G4LogicalVolume(PVSideCut_3, fMatWorld, "PressureVesselSideCut");
+	PVSideCutLogical_4 = new G4LogicalVolume(PVSideCut_3, fMatWorld, "PressureVesselSideCut");
+	
+	PVSideCutPhysical_1 = 
+		new G4PVPlacement(0, G4ThreeVector((PV_length-PV_sidecut_depth)/2,0,0), PVSideCutLogical_1,
+						  "PressureVesselSideCut", PVLogical, false, 0, fCheckOverlaps);
+	PVSideCutPhysical_2 = 
+		new G4PVPlacement(0, G4ThreeVector(-(PV_length-PV_sidecut_depth)/2,0,0), PVSideCutLogical_2,
+						  "PressureVesselSideCut", PVLogical, false, 1, fCheckOverlaps);
+	PVSideCutPhysical_3 = 
+		new G4PVPlacement(0, G4ThreeVector(0,(PV_width-PV_sidecut_depth)/2,0), PVSideCutLogical_3,
+						  "PressureVesselSideCut", PVLogical, false, 2, fCheckOverlaps);
+	PVSideCutPhysical_4 = 
+		new G4PVPlacement(0, G4ThreeVector(0,-(PV_width-PV_sidecut_depth)/2,0), PVSideCutLogical_4,
+						  "PressureVesselSideCut", PVLogical, false, 3, fCheckOverlaps);
+	
+	////////////////////////////////////////////////////////////////////////
+	// Pressure Vessel Top Cutouts
+	
+	// Only the part inside the vessel is cut out
+	G4Box* PVTopCut = new G4Box("PressureVesselTopCut", PV_topcut_length/2, std::min(PV_topcut_width, PV_width)/2, PV_topcut_depth/2);
+	
+	PVTopCutLogical = new G4LogicalVolume(PVTopCut, fMatWorld, "PressureVesselTopCut");
+	
+	PVTopCutPhysical = 
+		new G4PVPlacement(0, G4ThreeVector(0,0,-(PV_height-PV_topcut_depth)/2), PVTopCutLogical,
+						  "PressureVesselTopCut", PVLogical, false, 0, fCheckOverlaps);
+	
+	////////////////////////////////////////////////////////////////////////
+	// Pressure Vessel Detector Gas
+	
+	G4Box* PVGasTop = new G4Box("PressureVesselGasTop", PV_gas_length/2, PV_gas_width/2, PV_gas_height/2);
+	G4Box* PVGasMid = new G4Box("PressureVesselGasMid", PV_mid_gas_length/2, PV_mid_gas_width/2, PV_mid_gas_height/2);
+	G4Box* PVGasBottom = new G4Box("PressureVesselGasBottom", PV_bottom_gas_length/2, PV_bottom_gas_width/2, PV_bottom_gas_height/2);
+	
+	G4Transform3D PVGasTopTransform;
+	G4Transform3D PVGasMidTransform(G4RotationMatrix(), G4ThreeVector(0,0,(PV_gas_height+PV_mid_gas_height)/2));
+	G4Transform3D PVGasBottomTransform(G4RotationMatrix(), G4ThreeVector(0,0,(2*PV_mid_gas_height+PV_gas_height+PV_bottom_gas_height)/2));
+	
+	G4MultiUnion* PVGas = new G4MultiUnion("PressureVesselGas");
+	PVGas->AddNode(*PVGasTop, PVGasTopTransform);
+	PVGas->AddNode(*PVGasMid, PVGasMidTransform);
+	PVGas->AddNode(*PVGasBottom, PVGasBottomTransform);
+	PVGas->Voxelize();
+	
+	PVGasLogical = 
+		new G4LogicalVolume(PVGas,
+							fMatGas,
+							"PressureVesselGas");
+							
+	PVGasPhysical = 
+		new G4PVPlacement(	0,
+							G4ThreeVector(),
+							PVGasLogical,
+							"PressureVesselGas",
+							PVLogical,
+							false,
+							0,
+							fCheckOverlaps);
+	#else
+	G4ExceptionDescription msg;
+	msg << "The boxes vessel needs G4MultiUnion (Geant4 10.1), using the boolean vessel\n";
+	G4Exception("DetectorConstruction::ConstructBoxVessel()","Code007", JustWarning, msg);
+	ConstructBooleanVessel();
+	#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void DetectorConstruction::ConstructSDandField()
 { 	
   	////////////////////////////////////////////////////////////////////////
-	// Construct the Multi Functional Detector for the Sensitive Gas Volume
-	
-	G4MultiFunctionalDetector* PVGasScorer = new G4MultiFunctionalDetector("PVSensitiveGas");
-	G4SDManager::GetSDMpointer()->AddNewDetector(PVGasScorer);	
+	// Construct the Sensitive Detector for the Sensitive Gas Volume
+	// Energy deposits, passage track length and secondaries of the species in
+	// GasScoring::kSpeciesTable are scored in a single pass per step
+	
+	// A rebuilt geometry reuses the detector of its thread
+	G4VSensitiveDetector* PVGasScorer = G4SDManager::GetSDMpointer()->FindSensitiveDetector("PVSensitiveGas", false);
+	if (!PVGasScorer) {
+		PVGasScorer = new SensitiveGasSD("PVSensitiveGas");
+		G4SDManager::GetSDMpointer()->AddNewDetector(PVGasScorer);	
+	}
 	G4SDManager::GetSDMpointer()->SetVerboseLevel(0);
 	PVSensitiveGasLogical->SetSensitiveDetector(PVGasScorer);
 	
-	// MFD Filters
-	G4VSDFilter* ElectronFilter = new G4SDParticleFilter("electronFilter","e-");
-	G4VSDFilter* PositronFilter = new G4SDParticleFilter("positronFilter","e+");
-	G4VSDFilter* PhotonFilter = new G4SDParticleFilter("gammaFilter","gamma");
-	G4VSDFilter* tritonFilter = new G4SDParticleFilter("tritonFilter","triton");
-	G4VSDFilter* protonFilter = new G4SDParticleFilter("protonFilter","proton");
-	
-	// Total Energy deposited in the Sensitive Gas Volume
-	G4VPrimitiveScorer* eDep_Gas = new G4PSEnergyDeposit("eDep");
-    PVGasScorer->RegisterPrimitive(eDep_Gas);
-	
-	// Energy deposited from positrons in the Sensitive Gas Volume;
-	G4VPrimitiveScorer* eDep_Gas_Positron = new G4PSEnergyDeposit("eDepP");
-	eDep_Gas_Positron->SetFilter(PositronFilter);
-    PVGasScorer->RegisterPrimitive(eDep_Gas_Positron);
-	
-	// Energy deposited from Electrons in the Sensitive Gas Volume
-	G4VPrimitiveScorer* eDep_Gas_Electron = new G4PSEnergyDeposit("eDepE");
-	eDep_Gas_Electron->SetFilter(ElectronFilter);
-	PVGasScorer->RegisterPrimitive(eDep_Gas_Electron);
-	
-	// Energy deposited from Tritons in the Sensitive Gas Volume
-	G4VPrimitiveScorer* eDep_Gas_Triton = new G4PSEnergyDeposit("eDepT");
-	eDep_Gas_Triton->SetFilter(tritonFilter);
-	PVGasScorer->RegisterPrimitive(eDep_Gas_Triton);
-	
-	// Energy deposited from Protons in the Sensitive Gas Volume
-	G4VPrimitiveScorer* eDep_Gas_Proton = new G4PSEnergyDeposit("eDepPro");
-	eDep_Gas_Proton->SetFilter(protonFilter);
-	PVGasScorer->RegisterPrimitive(eDep_Gas_Proton);
-	
-	// Track length in the Sensitive Gas Volume
-    G4PSPassageTrackLength* trackLengthPassage_Gas = new G4PSPassageTrackLength("trackLengthPassage");
- 	PVGasScorer->RegisterPrimitive(trackLengthPassage_Gas);
-	 
-	// Number of secondary electrons
-	G4PSNofSecondary* secondaryElectrons = new G4PSNofSecondary("secondaryElectrons");
-	secondaryElectrons->SetFilter(ElectronFilter);
-	PVGasScorer->RegisterPrimitive(secondaryElectrons);
-	
-	// Number of secondary positrons
-	G4PSNofSecondary* secondaryPositrons = new G4PSNofSecondary("secondaryPositrons");
-	secondaryPositrons->SetFilter(PositronFilter);
-	PVGasScorer->RegisterPrimitive(secondaryPositrons);
-	
-	// Number of secondary photons
-	G4PSNofSecondary* secondaryPhotons = new G4PSNofSecondary("secondaryPhotons");
-	secondaryPhotons->SetFilter(PhotonFilter);
-	PVGasScorer->RegisterPrimitive(secondaryPhotons);
-	
-	// Number of secondary tritons
-	G4PSNofSecondary* secondaryTritons = new G4PSNofSecondary("secondaryTritons");
-	secondaryTritons->SetFilter(tritonFilter);
-	PVGasScorer->RegisterPrimitive(secondaryTritons);
-
-	// Number of secondary protons
-	G4PSNofSecondary* secondaryProtons = new G4PSNofSecondary("secondaryProtons");
-	secondaryProtons->SetFilter(protonFilter);
-	PVGasScorer->RegisterPrimitive(secondaryProtons);
+	////////////////////////////////////////////////////////////////////////
+	// Force photon interactions in the Sensitive Gas Volume. The operator is
+	// thread-local and needs the gamma processes wrapped by the physics list
+	
+	const PhysicsList* physicsList =
+		dynamic_cast<const PhysicsList*>(G4RunManager::GetRunManager()->GetUserPhysicsList());
+	if (physicsList && physicsList->IsGammaBiased()) {
+		static G4ThreadLocal G4BOptrForceCollision* forceCollision = 0;
+		if (!forceCollision) forceCollision = new G4BOptrForceCollision("gamma", "ForceCollisionGas");
+		forceCollision->AttachTo(PVSensitiveGasLogical);
+	}
+	
+	////////////////////////////////////////////////////////////////////////
+	// Electrons ranging out in the Sensitive Gas Volume are deposited at
+	// once. The model is thread-local and stays with the region
+	
+	if (physicsList && physicsList->IsRangeOutEnabled()) {
+		static G4ThreadLocal RangeOutModel* rangeOut = 0;
+		if (!rangeOut) rangeOut = new RangeOutModel("RangeOutGas", PVSensitiveGasLogical->GetRegion(), physicsList->GetRangeOutVoxel());
+	}
+	
+	////////////////////////////////////////////////////////////////////////
+	// Implicit capture of neutrons everywhere but in the Sensitive Gas
+	// Volume, whose captures are the signal. The operator is thread-local
+	// and needs the neutron processes wrapped by the physics list
+	
+	if (physicsList && physicsList->IsNeutronBiased()) {
+		static G4ThreadLocal NeutronBiasingOperator* implicitCapture = 0;
+		if (!implicitCapture) implicitCapture = new NeutronBiasingOperator("ImplicitCaptureNeutron");
+		G4LogicalVolumeStore* volumes = G4LogicalVolumeStore::GetInstance();
+		for (size_t i = 0; i < volumes->size(); ++i) {
+			if ((*volumes)[i] != PVSensitiveGasLogical) implicitCapture->AttachTo((*volumes)[i]);
+		}
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::GetEnvelope(G4ThreeVector& lower, G4ThreeVector& upper) const
+{
+	lower = fEnvelopeLower;
+	upper = fEnvelopeUpper;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::UpdateEnvelope()
+{
+	// The pressure vessel top is centred on the origin, the bottom is
+	// attached below it along +z. The corners of this box are rotated with
+	// the vessel about the x axis
+	G4double halfX = std::max(PV_length, PV_bottom_length)/2;
+	G4double halfY = std::max(PV_width, PV_bottom_width)/2;
+	G4ThreeVector lower(-halfX, -halfY, -PV_height/2);
+	G4ThreeVector upper(halfX, halfY, PV_height/2 + PV_bottom_height);
+	
+	G4RotationMatrix rotation;
+	rotation.rotateX(rotX);
+	fEnvelopeLower = G4ThreeVector(DBL_MAX, DBL_MAX, DBL_MAX);
+	fEnvelopeUpper = -fEnvelopeLower;
+	for (G4int corner = 0; corner < 8; ++corner) {
+		G4ThreeVector point((corner & 1) ? upper.x() : lower.x(),
+							(corner & 2) ? upper.y() : lower.y(),
+							(corner & 4) ? upper.z() : lower.z());
+		point = rotation*point;
+		for (G4int axis = 0; axis < 3; ++axis) {
+			fEnvelopeLower[axis] = std::min(fEnvelopeLower[axis], point[axis]);
+			fEnvelopeUpper[axis] = std::max(fEnvelopeUpper[axis], point[axis]);
+		}
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector DetectorConstruction::GetWorldHalfLengths() const
+{
+	// Twice the gas volume, grown with a margin when the rotated vessel
+	// would reach beyond it
+	G4ThreeVector half(PV_gas_length, PV_gas_width, PV_gas_height);
+	for (G4int axis = 0; axis < 3; ++axis) {
+		G4double reach = std::max(std::abs(fEnvelopeLower[axis]), std::abs(fEnvelopeUpper[axis]));
+		half[axis] = std::max(half[axis], 1.1*reach);
+	}
+	return half;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// The PCBs in the top of the vessel keep the faces towards the sensitive gas,
+// which is centred 0.5 mm below the origin, and grow away from it. The MWD
+// lies on the face of the bottom PCB towards the sensitive gas and the cap
+// PCB on the top of the bottom gas volume
+
+G4double DetectorConstruction::GetTopPCBZ() const
+{
+	return -0.5*mm - PV_sensitive_gas_height/2 - Top_PCB_thickness/2;
+}
+
+G4double DetectorConstruction::GetBottomPCBZ() const
+{
+	return -0.5*mm + PV_sensitive_gas_height/2 + Top_PCB_thickness/2;
+}
+
+G4double DetectorConstruction::GetCapPCBZ() const
+{
+	return (PV_gas_height-Bottom_PCB_thickness)/2 + PV_bottom_gas_height + PV_mid_gas_height;
+}
+
+G4double DetectorConstruction::GetMWDZ() const
+{
+	return (MWD_thickness - Top_PCB_thickness)/2;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -627,4 +845,318 @@ void DetectorConstruction::DefineCommands()
 {
     // Define /AdEPTCubeSat/ command directory using generic messenger class
     fMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/", "Geometry control");
-}
\ No newline at end of file
+    
+    G4GenericMessenger::Command& vesselCmd = fMessenger->DeclareMethod("vessel", &DetectorConstruction::SetVesselModel,
+    	"Representation of the pressure vessel and its gas: boolean (nested Boolean\n"
+    	"solids) or boxes (multi-unions of boxes with placed vacuum cutouts), which\n"
+    	"has the same mass and envelope and is faster to navigate.");
+    vesselCmd.SetParameterName("model", false);
+    vesselCmd.SetCandidates("boolean boxes");
+    vesselCmd.SetStates(G4State_PreInit);
+    
+    // Parameters for trade studies, which may be changed between runs.
+    // Materials are not changed, so the physics tables stay in place
+    G4GenericMessenger::Command& angleCmd = fMessenger->DeclareMethodWithUnit("rotX", "deg",
+    	&DetectorConstruction::SetDetectorAngle,
+    	"Rotation of the pressure vessel about the x axis; the World grows with it.");
+    angleCmd.SetParameterName("angle", false);
+    angleCmd.SetStates(G4State_PreInit, G4State_Idle);
+    
+    G4GenericMessenger::Command& sideCutCmd = fMessenger->DeclareMethodWithUnit("sideCutDepth", "mm",
+    	&DetectorConstruction::SetSideCutDepth,
+    	"Depth of the cutouts in the four side walls of the pressure vessel.");
+    sideCutCmd.SetParameterName("depth", false);
+    sideCutCmd.SetStates(G4State_PreInit, G4State_Idle);
+    
+    G4GenericMessenger::Command& topCutCmd = fMessenger->DeclareMethodWithUnit("topCutDepth", "mm",
+    	&DetectorConstruction::SetTopCutDepth,
+    	"Depth of the cutout in the top wall of the pressure vessel.");
+    topCutCmd.SetParameterName("depth", false);
+    topCutCmd.SetStates(G4State_PreInit, G4State_Idle);
+    
+    G4GenericMessenger::Command& pcbCmd = fMessenger->DeclareMethodWithUnit("pcbThickness", "mm",
+    	&DetectorConstruction::SetPCBThickness,
+    	"Thickness of the top and bottom PCBs around the sensitive gas.");
+    pcbCmd.SetParameterName("thickness", false);
+    pcbCmd.SetStates(G4State_PreInit, G4State_Idle);
+    
+    G4GenericMessenger::Command& capPCBCmd = fMessenger->DeclareMethodWithUnit("capPCBThickness", "mm",
+    	&DetectorConstruction::SetCapPCBThickness,
+    	"Thickness of the PCB in the bottom of the pressure vessel.");
+    capPCBCmd.SetParameterName("thickness", false);
+    capPCBCmd.SetStates(G4State_PreInit, G4State_Idle);
+    
+    G4GenericMessenger::Command& mwdCmd = fMessenger->DeclareMethodWithUnit("mwdThickness", "mm",
+    	&DetectorConstruction::SetMWDThickness,
+    	"Thickness of the Micro-Well Detector in the bottom PCB.");
+    mwdCmd.SetParameterName("thickness", false);
+    mwdCmd.SetStates(G4State_PreInit, G4State_Idle);
+    
+    // Detector gas, which may also be changed between runs
+    fGasMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/gas/", "Detector gas");
+    
+    G4GenericMessenger::Command& gasCmd = fGasMessenger->DeclareMethod("name", &DetectorConstruction::SetGas,
+    	"Gas of the pressure vessel and the sensitive volume.");
+    gasCmd.SetParameterName("gas", false);
+    gasCmd.SetCandidates("Ar_95_CS2_5 Ar_293K_1p5atm BoronGas Helium3");
+    gasCmd.SetStates(G4State_PreInit, G4State_Idle);
+    
+    G4GenericMessenger::Command& pressureCmd = fGasMessenger->DeclareMethodWithUnit("pressure", "atmosphere",
+    	&DetectorConstruction::SetGasPressure,
+    	"Pressure of the gas; the density scales with pressure over temperature.");
+    pressureCmd.SetParameterName("pressure", false);
+    pressureCmd.SetStates(G4State_PreInit, G4State_Idle);
+    
+    G4GenericMessenger::Command& temperatureCmd = fGasMessenger->DeclareMethodWithUnit("temperature", "kelvin",
+    	&DetectorConstruction::SetGasTemperature,
+    	"Temperature of the gas.");
+    temperatureCmd.SetParameterName("temperature", false);
+    temperatureCmd.SetStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetVesselModel(const G4String& model)
+{
+	if (model != "boolean" && model != "boxes") {
+		G4ExceptionDescription msg;
+		msg << "Unknown vessel model " << model << ", keeping " << fVesselModel << "\n";
+		G4Exception("DetectorConstruction::SetVesselModel()","Code007", JustWarning, msg);
+		return;
+	}
+	fVesselModel = model;
+}
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetDetectorAngle(G4double val)
+{
+	rotX = val;
+	
+	// Frame rotation of the placement, the inverse of the rotation of the vessel
+	*fVesselRotation = G4RotationMatrix();
+	fVesselRotation->rotateX(-rotX);
+	UpdateEnvelope();
+	ApplyGeometryChange(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double DetectorConstruction::GetDetectorAngle()
+{
+	return rotX;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetSideCutDepth(G4double val)
+{
+	// The cutouts end before the gas volume
+	G4double wall = std::min(PV_length - PV_gas_length, PV_width - PV_gas_width)/2;
+	if (!IsInRange("sideCutDepth", val, 0., wall)) return;
+	PV_sidecut_depth = val;
+	
+	// The Boolean vessel holds the depth in the transformations of its cutouts
+	ApplyGeometryChange(PVSideCutPhysical_1 == 0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetTopCutDepth(G4double val)
+{
+	if (!IsInRange("topCutDepth", val, 0., (PV_height - PV_gas_height)/2)) return;
+	PV_topcut_depth = val;
+	ApplyGeometryChange(PVTopCutPhysical == 0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetPCBThickness(G4double val)
+{
+	// Both PCBs stay in the gas and hold the MWD
+	G4double space = PV_gas_height/2 - 0.5*mm - PV_sensitive_gas_height/2;
+	if (!IsInRange("pcbThickness", val, 0., space)) return;
+	if (val < MWD_thickness) {
+		G4ExceptionDescription msg;
+		msg << "pcbThickness " << G4BestUnit(val, "Length") << "is thinner than the MWD, keeping "
+			<< G4BestUnit(Top_PCB_thickness, "Length") << "\n";
+		G4Exception("DetectorConstruction::SetPCBThickness()","Code009", JustWarning, msg);
+		return;
+	}
+	Top_PCB_thickness = val;
+	ApplyGeometryChange(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetCapPCBThickness(G4double val)
+{
+	if (!IsInRange("capPCBThickness", val, 0., PV_bottom_gas_height)) return;
+	Bottom_PCB_thickness = val;
+	ApplyGeometryChange(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetMWDThickness(G4double val)
+{
+	if (!IsInRange("mwdThickness", val, 0., Top_PCB_thickness)) return;
+	MWD_thickness = val;
+	ApplyGeometryChange(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool DetectorConstruction::IsInRange(const G4String& name, G4double value, G4double lower, G4double upper) const
+{
+	if (value > lower && value <= upper) return true;
+	
+	G4ExceptionDescription msg;
+	msg << name << " " << G4BestUnit(value, "Length") << "is outside ("
+		<< G4BestUnit(lower, "Length") << ", " << G4BestUnit(upper, "Length") << "], not changed\n";
+	G4Exception("DetectorConstruction::IsInRange()","Code009", JustWarning, msg);
+	return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::ApplyGeometryChange(G4bool rebuild)
+{
+	// Before /run/initialize Construct uses the new values
+	if (!WorldPhysical) return;
+	
+	G4RunManager* runManager = G4RunManager::GetRunManager();
+	if (rebuild) {
+		// Construct runs again at the next /run/beamOn. The regions and
+		// materials are the same, so the couples and physics tables are kept
+		#if G4VERSION_NUMBER >= 1020
+		runManager->ReinitializeGeometry();
+		#else
+		runManager->DefineWorldVolume(Construct());
+		#endif
+		return;
+	}
+	
+	// Only the changed solids and placements are modified; the voxels are
+	// rebuilt when the geometry is closed at the next /run/beamOn
+	G4GeometryManager::GetInstance()->OpenGeometry(WorldPhysical);
+	UpdatePlacements();
+	runManager->GeometryHasBeenModified();
+	
+	fOverlapChecker->Check(WorldPhysical);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::UpdatePlacements()
+{
+	G4ThreeVector worldHalf = GetWorldHalfLengths();
+	G4Box* world = static_cast<G4Box*>(WorldLogical->GetSolid());
+	world->SetXHalfLength(worldHalf.x());
+	world->SetYHalfLength(worldHalf.y());
+	world->SetZHalfLength(worldHalf.z());
+	
+	PVPhysical->SetRotation(fVesselRotation);
+	
+	// The top and bottom PCB share their dimensions
+	static_cast<G4Box*>(TopPCBLogical->GetSolid())->SetZHalfLength(Top_PCB_thickness/2);
+	static_cast<G4Box*>(BottomPCBLogical->GetSolid())->SetZHalfLength(Top_PCB_thickness/2);
+	TopPCBPhysical->SetTranslation(G4ThreeVector(0,0,GetTopPCBZ()));
+	BottomPCBPhysical->SetTranslation(G4ThreeVector(0,0,GetBottomPCBZ()));
+	
+	static_cast<G4Box*>(CapPCBLogical->GetSolid())->SetZHalfLength(Bottom_PCB_thickness/2);
+	CapPCBPhysical->SetTranslation(G4ThreeVector(0,0,GetCapPCBZ()));
+	
+	static_cast<G4Box*>(MWDLogical->GetSolid())->SetZHalfLength(MWD_thickness/2);
+	MWDPhysical->SetTranslation(G4ThreeVector(0,0,GetMWDZ()));
+	
+	// Cutouts placed in the boxes vessel
+	if (PVSideCutPhysical_1) {
+		static_cast<G4Box*>(PVSideCutLogical_1->GetSolid())->SetXHalfLength(PV_sidecut_depth/2);
+		static_cast<G4Box*>(PVSideCutLogical_3->GetSolid())->SetYHalfLength(PV_sidecut_depth/2);
+		PVSideCutPhysical_1->SetTranslation(G4ThreeVector((PV_length-PV_sidecut_depth)/2,0,0));
+		PVSideCutPhysical_2->SetTranslation(G4ThreeVector(-(PV_length-PV_sidecut_depth)/2,0,0));
+		PVSideCutPhysical_3->SetTranslation(G4ThreeVector(0,(PV_width-PV_sidecut_depth)/2,0));
+		PVSideCutPhysical_4->SetTranslation(G4ThreeVector(0,-(PV_width-PV_sidecut_depth)/2,0));
+	}
+	if (PVTopCutPhysical) {
+		static_cast<G4Box*>(PVTopCutLogical->GetSolid())->SetZHalfLength(PV_topcut_depth/2);
+		PVTopCutPhysical->SetTranslation(G4ThreeVector(0,0,-(PV_height-PV_topcut_depth)/2));
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetGas(const G4String& name)
+{
+	if (!G4Material::GetMaterial(name, false)) {
+		G4ExceptionDescription msg;
+		msg << "Unknown gas " << name << ", keeping " << fGasName << "\n";
+		G4Exception("DetectorConstruction::SetGas()","Code010", JustWarning, msg);
+		return;
+	}
+	fGasName = name;
+	ApplyGas();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetGasPressure(G4double pressure)
+{
+	if (pressure <= 0.) {
+		G4ExceptionDescription msg;
+		msg << "Gas pressure must be positive, keeping " << fGasPressure/atmosphere << " atm\n";
+		G4Exception("DetectorConstruction::SetGasPressure()","Code010", JustWarning, msg);
+		return;
+	}
+	fGasPressure = pressure;
+	ApplyGas();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetGasTemperature(G4double temperature)
+{
+	if (temperature <= 0.) {
+		G4ExceptionDescription msg;
+		msg << "Gas temperature must be positive, keeping " << fGasTemperature/kelvin << " K\n";
+		G4Exception("DetectorConstruction::SetGasTemperature()","Code010", JustWarning, msg);
+		return;
+	}
+	fGasTemperature = temperature;
+	ApplyGas();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::ApplyGas()
+{
+	G4Material* base = G4Material::GetMaterial(fGasName);
+	
+	// Other conditions are derived from the gas of DefineMaterials as an
+	// ideal gas and kept, so a sweep that returns to a point reuses its
+	// material and couple
+	G4Material* gas = base;
+	if (std::abs(fGasPressure - base->GetPressure()) > 1e-9*base->GetPressure() ||
+		std::abs(fGasTemperature - base->GetTemperature()) > 1e-9*base->GetTemperature()) {
+		std::ostringstream name;
+		name << fGasName << "_" << fGasPressure/atmosphere << "atm_" << fGasTemperature/kelvin << "K";
+		gas = G4Material::GetMaterial(name.str(), false);
+		if (!gas) {
+			G4double density = base->GetDensity()*(fGasPressure/base->GetPressure())*(base->GetTemperature()/fGasTemperature);
+			gas = new G4Material(name.str(), density, base, kStateGas, fGasTemperature, fGasPressure);
+		}
+	}
+	if (gas == fMatGas) return;
+	fMatGas = gas;
+	
+	// Before /run/initialize Construct uses the new gas
+	if (!WorldPhysical) return;
+	
+	PVGasLogical->SetMaterial(fMatGas);
+	PVSensitiveGasLogical->SetMaterial(fMatGas);
+	
+	// The couple table finds the new material-cuts couples at the next
+	// /run/beamOn; only their tables are built, the others are kept.
+	// The command also reaches the worker threads
+	G4UImanager::GetUIpointer()->ApplyCommand("/run/physicsModified");
+}
@@ -0,0 +1,305 @@
+#include "GasBranches.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4BiasingProcessInterface.hh"
+
+namespace
+{
+	GasEventRecord EmptyTotals()
+	{
+		GasEventRecord totals;
+		totals.Reset();
+		return totals;
+	}
+
+	const GasEventRecord kEmptyTotals = EmptyTotals();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+GasBranches::GasBranches()
+ : fTouched(true), fTrack(0), fTrackID(-1), fStepNumber(-1), fBranch(0), fNumSecondaries(0)
+{
+	fBranches.resize(1);
+	Reset();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+GasBranches::~GasBranches()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasBranches::Reset()
+{
+	// Only events that reached the gas leave totals to clear; the vectors
+	// keep their capacity
+	if (fTouched) fBranches[0].totals.Reset();
+	fBranches.resize(1);
+	Branch& root = fBranches[0];
+	root.weight = 1.;
+	root.shared = false;
+	root.firstPoint = -1;
+	root.lastPoint = -1;
+	fPoints.clear();
+	fTouched = false;
+
+	fTrack = 0;
+	fTrackID = -1;
+	fStepNumber = -1;
+	fBranch = 0;
+	fNumSecondaries = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int GasBranches::AddPoint(G4int branch, G4double weight)
+{
+	Point point;
+	point.weight = weight;
+	point.firstChild = fBranches.size();
+	point.numChildren = 0;
+	point.nextPoint = -1;
+	fPoints.push_back(point);
+
+	const G4int index = fPoints.size() - 1;
+	Branch& parent = fBranches[branch];
+	if (parent.lastPoint < 0) parent.firstPoint = index;
+	else fPoints[parent.lastPoint].nextPoint = index;
+	parent.lastPoint = index;
+	return index;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int GasBranches::AddChild(G4int point, G4double weight)
+{
+	Branch child;
+	child.weight = weight;
+	child.shared = false;
+	child.firstPoint = -1;
+	child.lastPoint = -1;
+	child.totals.Reset();
+	fBranches.push_back(child);
+	++fPoints[point].numChildren;
+	return fBranches.size() - 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int GasBranches::ChangeWeight(G4int branch, G4double newWeight)
+{
+	Branch& current = fBranches[branch];
+	if (newWeight == current.weight) return branch;
+
+	// Nothing to share yet: the branch as a whole takes the new weight
+	if (current.weight <= 0. || (!current.totals.touched && !current.shared && current.firstPoint < 0)) {
+		current.weight = newWeight;
+		return branch;
+	}
+	const G4int point = AddPoint(branch, current.weight);
+	return AddChild(point, newWeight);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasBranches::SetBranch(G4Track* track, G4int branch)
+{
+	GasBranchInfo* info = dynamic_cast<GasBranchInfo*>(track->GetUserInformation());
+	if (info) info->SetBranch(branch);
+	else if (branch != 0) track->SetUserInformation(new GasBranchInfo(branch));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool GasBranches::IsClone(const G4Track* track, const G4Track* secondary)
+{
+	// Non-physics biasing operations wrap no process; the cloning of
+	// G4BOptrForceCollision is the only one making a track of the same kind
+	if (secondary->GetDefinition() != track->GetDefinition()) return false;
+	const G4BiasingProcessInterface* creator =
+		dynamic_cast<const G4BiasingProcessInterface*>(secondary->GetCreatorProcess());
+	return creator && !creator->GetWrappedProcess();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int GasBranches::Follow(const G4Step* step)
+{
+	G4Track* track = step->GetTrack();
+	if (track != fTrack || track->GetTrackID() != fTrackID) {
+		fTrack = track;
+		fTrackID = track->GetTrackID();
+		fNumSecondaries = 0;
+	} else if (track->GetCurrentStepNumber() == fStepNumber) {
+		return fBranch;
+	}
+	fStepNumber = track->GetCurrentStepNumber();
+
+	const GasBranchInfo* info = dynamic_cast<const GasBranchInfo*>(track->GetUserInformation());
+	const G4int branch = info ? info->GetBranch() : 0;
+	const G4double weight = track->GetWeight();
+
+	const G4TrackVector* secondaries = step->GetSecondary();
+	const size_t numSecondaries = secondaries ? secondaries->size() : 0;
+	G4bool cloned = false;
+	for (size_t i = fNumSecondaries; i < numSecondaries && !cloned; ++i) {
+		cloned = IsClone(track, (*secondaries)[i]);
+	}
+
+	// A clone and the track are the two alternatives of the point, with the
+	// weights the biasing operation gave them
+	G4int newBranch = branch;
+	if (cloned) {
+		const G4int point = AddPoint(branch, fBranches[branch].weight);
+		newBranch = AddChild(point, weight);
+		for (size_t i = fNumSecondaries; i < numSecondaries; ++i) {
+			G4Track* clone = (*secondaries)[i];
+			if (!IsClone(track, clone)) continue;
+			// A copied track may carry the information object of the original
+			clone->SetUserInformation(new GasBranchInfo(AddChild(point, clone->GetWeight())));
+		}
+	} else {
+		newBranch = ChangeWeight(branch, weight);
+	}
+	if (newBranch != branch) SetBranch(track, newBranch);
+
+	// The other secondaries of the step continue the branch of the track
+	for (size_t i = fNumSecondaries; i < numSecondaries; ++i) {
+		G4Track* secondary = (*secondaries)[i];
+		if (cloned && IsClone(track, secondary)) continue;
+		fBranches[newBranch].shared = true;
+		if (newBranch != 0) secondary->SetUserInformation(new GasBranchInfo(newBranch));
+	}
+	fNumSecondaries = numSecondaries;
+	fBranch = newBranch;
+	return newBranch;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasBranches::Reweight(G4Track* track)
+{
+	const G4int newBranch = ChangeWeight(fBranch, track->GetWeight());
+	if (newBranch != fBranch) SetBranch(track, newBranch);
+	fBranch = newBranch;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasBranches::Split(G4Track* track, const std::vector<G4Track*>& copies)
+{
+	const G4int point = AddPoint(fBranch, fBranches[fBranch].weight);
+	fBranch = AddChild(point, track->GetWeight());
+	SetBranch(track, fBranch);
+	for (size_t i = 0; i < copies.size(); ++i) {
+		copies[i]->SetUserInformation(new GasBranchInfo(AddChild(point, copies[i]->GetWeight())));
+	}
+
+	// The copies are not secondaries of a later step
+	fNumSecondaries += copies.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasBranches::AddEntry(std::vector<Entry>& entries, const GasEventRecord& totals, G4double weight)
+{
+	if (weight == 0.) return;
+	for (size_t i = 0; i < entries.size(); ++i) {
+		if (entries[i].totals.SameTotals(totals)) {
+			entries[i].weight += weight;
+			return;
+		}
+	}
+	Entry entry;
+	entry.totals = totals;
+	entry.weight = weight;
+	entries.push_back(entry);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool GasBranches::ResolveBranch(G4int branch, std::vector<Entry>& entries) const
+{
+	// Outcomes relative to the weight of the branch: its own totals plus one
+	// outcome of each of its points
+	entries.clear();
+	entries.push_back(Entry());
+	entries.back().totals = fBranches[branch].totals;
+	entries.back().weight = 1.;
+
+	std::vector<Entry> outcomes;
+	std::vector<Entry> combined;
+	for (G4int point = fBranches[branch].firstPoint; point >= 0; point = fPoints[point].nextPoint) {
+		if (!ResolvePoint(point, outcomes)) return false;
+		if (outcomes.size() == 1 && !outcomes[0].totals.touched) {
+			// Only the fraction of the histories that continue, e.g. implicit capture
+			for (size_t i = 0; i < entries.size(); ++i) entries[i].weight *= outcomes[0].weight;
+			continue;
+		}
+		combined.clear();
+		for (size_t i = 0; i < entries.size(); ++i) {
+			for (size_t j = 0; j < outcomes.size(); ++j) {
+				GasEventRecord totals = entries[i].totals;
+				totals.Add(outcomes[j].totals);
+				AddEntry(combined, totals, entries[i].weight*outcomes[j].weight);
+			}
+			if (combined.size() > kMaxEntries) return false;
+		}
+		entries.swap(combined);
+	}
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool GasBranches::ResolvePoint(G4int point, std::vector<Entry>& entries) const
+{
+	// Outcomes relative to the weight of the track before the point
+	entries.clear();
+	const Point& current = fPoints[point];
+	G4double remaining = 1.;
+	std::vector<Entry> outcomes;
+	for (G4int child = current.firstChild; child < current.firstChild + current.numChildren; ++child) {
+		if (!ResolveBranch(child, outcomes)) return false;
+		const G4double fraction = fBranches[child].weight/current.weight;
+		for (size_t i = 0; i < outcomes.size(); ++i) {
+			AddEntry(entries, outcomes[i].totals, outcomes[i].weight*fraction);
+		}
+		remaining -= fraction;
+		if (entries.size() > kMaxEntries) return false;
+	}
+
+	// Histories ended at the point keep only the shared totals
+	AddEntry(entries, kEmptyTotals, remaining);
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool GasBranches::Resolve(std::vector<Entry>& entries) const
+{
+	entries.clear();
+	const Branch& root = fBranches[0];
+	if (fPoints.empty()) {
+		AddEntry(entries, root.totals, root.weight);
+		return true;
+	}
+
+	if (ResolveBranch(0, entries)) {
+		for (size_t i = 0; i < entries.size(); ++i) entries[i].weight *= root.weight;
+		return true;
+	}
+
+	// Too many outcomes: all deposits as one entry at their mean weight
+	entries.clear();
+	GasEventRecord totals = kEmptyTotals;
+	G4double eDepWeighted = 0.;
+	for (size_t i = 0; i < fBranches.size(); ++i) {
+		totals.Add(fBranches[i].totals);
+		eDepWeighted += fBranches[i].totals.eDep*fBranches[i].weight;
+	}
+	AddEntry(entries, totals, totals.eDep > 0. ? eDepWeighted/totals.eDep : root.weight);
+	return false;
+}
@@ -0,0 +1,300 @@
+#include "GasHistograms.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+	// Energy deposit: logarithmic bins from 10 eV to 10 GeV
+	const G4double kEnergyMin = 10.*eV;
+	const G4int kBinsPerDecade = 20;
+	const G4int kEnergyDecades = 9;
+	const G4int kEnergyBins = kBinsPerDecade*kEnergyDecades + 2;
+
+	// Passage track length: linear bins from 0 to 1000 mm
+	const G4double kLengthMax = 1000.*mm;
+	const G4double kLengthBinWidth = 2.*mm;
+	const G4int kLengthBins = G4int(kLengthMax/kLengthBinWidth) + 2;
+
+	// Secondary multiplicity: one bin per count from 0 to 200
+	const G4int kMaxMultiplicity = 200;
+	const G4int kMultiplicityBins = kMaxMultiplicity + 3;
+
+	// Spectrum 0 is the total deposit, spectrum 1+i the deposit of species i
+	const G4int kNumSpectra = 1 + GasScoring::kNumSpecies;
+
+	// One line per block: the number of values followed by the values
+	void SaveBlock(std::ostream& out, const std::vector<G4double>& values)
+	{
+		out << values.size();
+		for (size_t i = 0; i < values.size(); ++i) out << " " << values[i];
+		out << "\n";
+	}
+
+	G4bool LoadBlock(std::istream& in, std::vector<G4double>& values)
+	{
+		size_t size = 0;
+		if (!(in >> size) || size != values.size()) return false;
+		for (size_t i = 0; i < size; ++i) {
+			if (!(in >> values[i])) return false;
+		}
+		return true;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+GasHistograms::GasHistograms()
+ : fEDep(kNumSpectra*kEnergyBins, 0.), fEDep2(kNumSpectra*kEnergyBins, 0.),
+   fTrackLength(kLengthBins, 0.), fTrackLength2(kLengthBins, 0.),
+   fSecondaries(GasScoring::kNumSpecies*kMultiplicityBins, 0.),
+   fSecondaries2(GasScoring::kNumSpecies*kMultiplicityBins, 0.),
+   fPrimaries(kEnergyBins, 0.),
+   fResponse(kEnergyBins*kEnergyBins, 0.), fResponse2(kEnergyBins*kEnergyBins, 0.),
+   fSumOfWeights(0.), fInEvent(false)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+GasHistograms::~GasHistograms()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int GasHistograms::EnergyBin(G4double energy) const
+{
+	if (energy < kEnergyMin) return 0;
+	G4int bin = 1 + G4int(std::log10(energy/kEnergyMin)*kBinsPerDecade);
+	return (bin < kEnergyBins - 1) ? bin : kEnergyBins - 1;
+}
+
+G4double GasHistograms::EnergyBinLow(G4int bin) const
+{
+	if (bin == 0) return 0.;
+	if (bin >= kEnergyBins) return HUGE_VAL;
+	return kEnergyMin*std::pow(10., G4double(bin-1)/kBinsPerDecade);
+}
+
+G4int GasHistograms::TrackLengthBin(G4double length) const
+{
+	if (length < 0.) return 0;
+	G4int bin = 1 + G4int(length/kLengthBinWidth);
+	return (bin < kLengthBins - 1) ? bin : kLengthBins - 1;
+}
+
+G4int GasHistograms::MultiplicityBin(G4double count) const
+{
+	if (count < 0.) return 0;
+	G4int bin = 1 + G4int(count + 0.5);
+	return (bin < kMultiplicityBins - 1) ? bin : kMultiplicityBins - 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasHistograms::FillBin(std::vector<G4double>& sumw, std::vector<G4double>& sumw2,
+							G4int bin, G4double weight)
+{
+	sumw[bin] += weight;
+	if (!fInEvent) {
+		sumw2[bin] += weight*weight;
+		return;
+	}
+	for (size_t i = 0; i < fPending.size(); ++i) {
+		if (fPending[i].sumw2 == &sumw2 && fPending[i].bin == bin) {
+			fPending[i].weight += weight;
+			return;
+		}
+	}
+	PendingBin pending = { &sumw2, bin, weight };
+	fPending.push_back(pending);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasHistograms::BeginEvent()
+{
+	fInEvent = true;
+	fPending.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasHistograms::EndEvent()
+{
+	for (size_t i = 0; i < fPending.size(); ++i) {
+		(*fPending[i].sumw2)[fPending[i].bin] += fPending[i].weight*fPending[i].weight;
+	}
+	fPending.clear();
+	fInEvent = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasHistograms::Fill(const GasEventRecord& record, G4double weight)
+{
+	fSumOfWeights += weight;
+
+	FillBin(fEDep, fEDep2, EnergyBin(record.eDep), weight);
+	for (G4int i = 0; i < GasScoring::kNumSpecies; ++i) {
+		if (GasScoring::kSpeciesTable[i].scoreEDep && record.eDepSpecies[i] > 0.) {
+			FillBin(fEDep, fEDep2, (1+i)*kEnergyBins + EnergyBin(record.eDepSpecies[i]), weight);
+		}
+	}
+
+	FillBin(fTrackLength, fTrackLength2, TrackLengthBin(record.trackLengthPassage), weight);
+
+	for (G4int i = 0; i < GasScoring::kNumSpecies; ++i) {
+		if (GasScoring::kSpeciesTable[i].scoreSecondaries) {
+			FillBin(fSecondaries, fSecondaries2, i*kMultiplicityBins + MultiplicityBin(record.nSecondaries[i]), weight);
+		}
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasHistograms::FillPrimary(G4double primaryEnergy)
+{
+	fPrimaries[EnergyBin(primaryEnergy)] += 1.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasHistograms::FillResponse(G4double primaryEnergy, G4double eDep, G4double weight)
+{
+	FillBin(fResponse, fResponse2, EnergyBin(primaryEnergy)*kEnergyBins + EnergyBin(eDep), weight);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasHistograms::Add(const GasHistograms& other)
+{
+	for (size_t i = 0; i < fEDep.size(); ++i) {
+		fEDep[i] += other.fEDep[i];
+		fEDep2[i] += other.fEDep2[i];
+	}
+	for (size_t i = 0; i < fTrackLength.size(); ++i) {
+		fTrackLength[i] += other.fTrackLength[i];
+		fTrackLength2[i] += other.fTrackLength2[i];
+	}
+	for (size_t i = 0; i < fSecondaries.size(); ++i) {
+		fSecondaries[i] += other.fSecondaries[i];
+		fSecondaries2[i] += other.fSecondaries2[i];
+	}
+	for (size_t i = 0; i < fPrimaries.size(); ++i) {
+		fPrimaries[i] += other.fPrimaries[i];
+	}
+	for (size_t i = 0; i < fResponse.size(); ++i) {
+		fResponse[i] += other.fResponse[i];
+		fResponse2[i] += other.fResponse2[i];
+	}
+	fSumOfWeights += other.fSumOfWeights;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasHistograms::Reset()
+{
+	fEDep.assign(fEDep.size(), 0.);
+	fEDep2.assign(fEDep2.size(), 0.);
+	fTrackLength.assign(fTrackLength.size(), 0.);
+	fTrackLength2.assign(fTrackLength2.size(), 0.);
+	fSecondaries.assign(fSecondaries.size(), 0.);
+	fSecondaries2.assign(fSecondaries2.size(), 0.);
+	fPrimaries.assign(fPrimaries.size(), 0.);
+	fResponse.assign(fResponse.size(), 0.);
+	fResponse2.assign(fResponse2.size(), 0.);
+	fSumOfWeights = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasHistograms::Save(std::ostream& out) const
+{
+	std::streamsize precision = out.precision(17);
+	out << fSumOfWeights << "\n";
+	SaveBlock(out, fEDep);
+	SaveBlock(out, fEDep2);
+	SaveBlock(out, fTrackLength);
+	SaveBlock(out, fTrackLength2);
+	SaveBlock(out, fSecondaries);
+	SaveBlock(out, fSecondaries2);
+	SaveBlock(out, fPrimaries);
+	SaveBlock(out, fResponse);
+	SaveBlock(out, fResponse2);
+	out.precision(precision);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool GasHistograms::Load(std::istream& in)
+{
+	GasHistograms loaded;
+	if (!(in >> loaded.fSumOfWeights)
+		|| !LoadBlock(in, loaded.fEDep) || !LoadBlock(in, loaded.fEDep2)
+		|| !LoadBlock(in, loaded.fTrackLength) || !LoadBlock(in, loaded.fTrackLength2)
+		|| !LoadBlock(in, loaded.fSecondaries) || !LoadBlock(in, loaded.fSecondaries2)
+		|| !LoadBlock(in, loaded.fPrimaries)
+		|| !LoadBlock(in, loaded.fResponse) || !LoadBlock(in, loaded.fResponse2)) return false;
+	*this = loaded;
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GasHistograms::Write(const G4String& fileName) const
+{
+	std::ofstream out(fileName);
+	out.precision(10);
+
+	// One row per bin; bin 0 is the underflow and the last bin the overflow
+	out << "histogram,bin,low,high,sumw,sumw2" << G4endl;
+
+	for (G4int h = 0; h < kNumSpectra; ++h) {
+		if (h > 0 && !GasScoring::kSpeciesTable[h-1].scoreEDep) continue;
+		G4String name = "eDep_PVSensitiveGas";
+		if (h > 0) name += G4String("_") + GasScoring::kSpeciesTable[h-1].particleName;
+		for (G4int bin = 0; bin < kEnergyBins; ++bin) {
+			out << name << "," << bin << "," << EnergyBinLow(bin)/eV << "," << EnergyBinLow(bin+1)/eV << ","
+				<< fEDep[h*kEnergyBins+bin] << "," << fEDep2[h*kEnergyBins+bin] << G4endl;
+		}
+	}
+
+	for (G4int bin = 0; bin < kLengthBins; ++bin) {
+		G4double low = (bin == 0) ? -HUGE_VAL : (bin-1)*kLengthBinWidth;
+		G4double high = (bin == kLengthBins-1) ? HUGE_VAL : bin*kLengthBinWidth;
+		out << "trackLength_PVSensitiveGas," << bin << "," << low/mm << "," << high/mm << ","
+			<< fTrackLength[bin] << "," << fTrackLength2[bin] << G4endl;
+	}
+
+	for (G4int i = 0; i < GasScoring::kNumSpecies; ++i) {
+		if (!GasScoring::kSpeciesTable[i].scoreSecondaries) continue;
+		G4String name = G4String("secondaries_") + GasScoring::kSpeciesTable[i].particleName;
+		for (G4int bin = 0; bin < kMultiplicityBins; ++bin) {
+			G4double low = (bin == 0) ? -HUGE_VAL : bin - 1.5;
+			G4double high = (bin == kMultiplicityBins-1) ? HUGE_VAL : bin - 0.5;
+			out << name << "," << bin << "," << low << "," << high << ","
+				<< fSecondaries[i*kMultiplicityBins+bin] << "," << fSecondaries2[i*kMultiplicityBins+bin] << G4endl;
+		}
+	}
+
+	// Response per true energy bin, written for the bins that saw primaries.
+	// The histogram name holds the true energy bin
+	for (G4int trueBin = 0; trueBin < kEnergyBins; ++trueBin) {
+		out << "primaries," << trueBin << "," << EnergyBinLow(trueBin)/eV << "," << EnergyBinLow(trueBin+1)/eV << ","
+			<< fPrimaries[trueBin] << "," << fPrimaries[trueBin] << G4endl;
+	}
+	for (G4int trueBin = 0; trueBin < kEnergyBins; ++trueBin) {
+		if (fPrimaries[trueBin] == 0.) continue;
+		std::ostringstream name;
+		name << "response_" << trueBin;
+		for (G4int bin = 0; bin < kEnergyBins; ++bin) {
+			out << name.str() << "," << bin << "," << EnergyBinLow(bin)/eV << "," << EnergyBinLow(bin+1)/eV << ","
+				<< fResponse[trueBin*kEnergyBins+bin] << "," << fResponse2[trueBin*kEnergyBins+bin] << G4endl;
+		}
+	}
+}
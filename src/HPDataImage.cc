@@ -0,0 +1,334 @@
+#include "HPDataImage.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+	const char kMagic[8] = { 'A','E','H','P','D','0','0','1' };
+	const uint64_t kAlignment = 4096;
+	const char* kCompleteMarker = ".complete";
+
+	void PutLE(std::vector<unsigned char>& out, uint64_t value, int bytes)
+	{
+		for (int i = 0; i < bytes; ++i) out.push_back((unsigned char) (value >> (8*i)));
+	}
+
+	uint64_t GetLE(const unsigned char* in, int bytes)
+	{
+		uint64_t value = 0;
+		for (int i = 0; i < bytes; ++i) value |= uint64_t(in[i]) << (8*i);
+		return value;
+	}
+
+	uint64_t Align(uint64_t offset)
+	{
+		return (offset + kAlignment - 1)/kAlignment*kAlignment;
+	}
+
+	// Z of a file named "<Z>_<A>_<Name>", 0 for any other file
+	int IsotopeZ(const std::string& fileName)
+	{
+		size_t digits = 0;
+		while (digits < fileName.size() && fileName[digits] >= '0' && fileName[digits] <= '9') ++digits;
+		if (digits == 0 || digits >= fileName.size() || fileName[digits] != '_') return 0;
+		return std::atoi(fileName.substr(0, digits).c_str());
+	}
+
+	// Regular files below directory, as paths relative to root
+	void ListFiles(const std::string& root, const std::string& relative, std::vector<std::string>& files)
+	{
+		std::string directory = relative.empty() ? root : root + "/" + relative;
+		DIR* dir = opendir(directory.c_str());
+		if (!dir) return;
+		while (dirent* entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			if (name == "." || name == "..") continue;
+			std::string path = relative.empty() ? name : relative + "/" + name;
+			struct stat status;
+			if (stat((root + "/" + path).c_str(), &status) != 0) continue;
+			if (S_ISDIR(status.st_mode)) ListFiles(root, path, files);
+			else if (S_ISREG(status.st_mode)) files.push_back(path);
+		}
+		closedir(dir);
+	}
+
+	// Creates the parent directories of path below root
+	bool MakeParents(const std::string& root, const std::string& path)
+	{
+		for (size_t slash = path.find('/'); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+			std::string directory = root + "/" + path.substr(0, slash);
+			if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) return false;
+		}
+		return true;
+	}
+
+	void RemoveTree(const std::string& path)
+	{
+		DIR* dir = opendir(path.c_str());
+		if (dir) {
+			while (dirent* entry = readdir(dir)) {
+				std::string name = entry->d_name;
+				if (name == "." || name == "..") continue;
+				std::string child = path + "/" + name;
+				struct stat status;
+				if (lstat(child.c_str(), &status) == 0 && S_ISDIR(status.st_mode)) RemoveTree(child);
+				else std::remove(child.c_str());
+			}
+			closedir(dir);
+		}
+		rmdir(path.c_str());
+	}
+
+	bool Exists(const std::string& path)
+	{
+		struct stat status;
+		return stat(path.c_str(), &status) == 0;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HPDataImage::HPDataImage() : fData(0), fMappedSize(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HPDataImage::~HPDataImage()
+{
+	Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool HPDataImage::Pack(const std::string& dataDirectory, const std::set<int>& elements,
+					   const std::string& imageName, std::string& error)
+{
+	std::vector<std::string> all;
+	ListFiles(dataDirectory, "", all);
+	if (all.empty()) {
+		error = "no data files in " + dataDirectory;
+		return false;
+	}
+	std::sort(all.begin(), all.end());
+	
+	std::vector<Entry> entries;
+	for (size_t i = 0; i < all.size(); ++i) {
+		size_t slash = all[i].rfind('/');
+		int Z = IsotopeZ(slash == std::string::npos ? all[i] : all[i].substr(slash + 1));
+		if (Z > 0 && !elements.count(Z) && !elements.count(Z - 1) && !elements.count(Z + 1)) continue;
+		
+		struct stat status;
+		if (stat((dataDirectory + "/" + all[i]).c_str(), &status) != 0) continue;
+		Entry entry = { all[i], 0, (uint64_t) status.st_size };
+		entries.push_back(entry);
+	}
+	
+	// Index size is known before the offsets, which only depend on it
+	uint64_t indexBytes = 0;
+	for (size_t i = 0; i < entries.size(); ++i) indexBytes += 8 + 8 + 2 + entries[i].path.size();
+	uint64_t offset = Align(sizeof(kMagic) + 8 + 8 + indexBytes);
+	for (size_t i = 0; i < entries.size(); ++i) {
+		entries[i].offset = offset;
+		offset = Align(offset + entries[i].size);
+	}
+	
+	std::vector<unsigned char> header(kMagic, kMagic + sizeof(kMagic));
+	PutLE(header, entries.size(), 8);
+	PutLE(header, indexBytes, 8);
+	for (size_t i = 0; i < entries.size(); ++i) {
+		PutLE(header, entries[i].offset, 8);
+		PutLE(header, entries[i].size, 8);
+		PutLE(header, entries[i].path.size(), 2);
+		header.insert(header.end(), entries[i].path.begin(), entries[i].path.end());
+	}
+	
+	std::string tmpName = imageName + ".tmp";
+	FILE* out = std::fopen(tmpName.c_str(), "wb");
+	if (!out) {
+		error = "cannot write " + tmpName;
+		return false;
+	}
+	bool ok = std::fwrite(&header[0], 1, header.size(), out) == header.size();
+	std::vector<char> buffer(1 << 20);
+	for (size_t i = 0; ok && i < entries.size(); ++i) {
+		ok = std::fseek(out, (long) entries[i].offset, SEEK_SET) == 0;
+		FILE* in = std::fopen((dataDirectory + "/" + entries[i].path).c_str(), "rb");
+		uint64_t copied = 0;
+		while (ok && in && copied < entries[i].size) {
+			size_t n = std::fread(&buffer[0], 1, buffer.size(), in);
+			if (n == 0) break;
+			ok = std::fwrite(&buffer[0], 1, n, out) == n;
+			copied += n;
+		}
+		if (in) std::fclose(in);
+		if (ok && copied != entries[i].size) {
+			error = "cannot read " + entries[i].path;
+			ok = false;
+		}
+	}
+	// Pads the last file to the boundary
+	if (ok && offset > 0) ok = std::fseek(out, (long) offset - 1, SEEK_SET) == 0 && std::fputc(0, out) != EOF;
+	if (std::fclose(out) != 0) ok = false;
+	if (ok && std::rename(tmpName.c_str(), imageName.c_str()) != 0) ok = false;
+	if (!ok) {
+		std::remove(tmpName.c_str());
+		if (error.empty()) error = "cannot write " + imageName;
+	}
+	return ok;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool HPDataImage::Open(const std::string& imageName)
+{
+	Close();
+	fError = "";
+	
+	int fd = open(imageName.c_str(), O_RDONLY);
+	struct stat status;
+	if (fd < 0 || fstat(fd, &status) != 0 || (uint64_t) status.st_size < sizeof(kMagic) + 16) {
+		if (fd >= 0) close(fd);
+		fError = "cannot read " + imageName;
+		return false;
+	}
+	void* mapping = mmap(0, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		fError = "cannot map " + imageName;
+		return false;
+	}
+	fData = (const unsigned char*) mapping;
+	fMappedSize = status.st_size;
+	
+	const unsigned char* in = fData + sizeof(kMagic);
+	uint64_t count = GetLE(in, 8);
+	uint64_t indexBytes = GetLE(in + 8, 8);
+	in += 16;
+	const unsigned char* indexEnd = in + indexBytes;
+	bool ok = std::memcmp(fData, kMagic, sizeof(kMagic)) == 0 && indexBytes <= fMappedSize - sizeof(kMagic) - 16;
+	for (uint64_t i = 0; ok && i < count; ++i) {
+		if (indexEnd - in < 18) { ok = false; break; }
+		Entry entry;
+		entry.offset = GetLE(in, 8);
+		entry.size = GetLE(in + 8, 8);
+		size_t length = GetLE(in + 16, 2);
+		in += 18;
+		if ((size_t) (indexEnd - in) < length) { ok = false; break; }
+		entry.path.assign((const char*) in, length);
+		in += length;
+		// Paths stay inside the installed directory
+		ok = entry.offset <= fMappedSize && entry.size <= fMappedSize - entry.offset
+			&& !entry.path.empty() && entry.path[0] != '/' && entry.path.find("..") == std::string::npos;
+		fEntries.push_back(entry);
+	}
+	if (!ok) {
+		Close();
+		fError = imageName + " is not a valid HP data image";
+		return false;
+	}
+	
+	// 64-bit FNV-1a of the index
+	uint64_t hash = 14695981039346656037ULL;
+	for (const unsigned char* c = fData; c < indexEnd; ++c) {
+		hash ^= *c;
+		hash *= 1099511628211ULL;
+	}
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << hash;
+	fHash = name.str();
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HPDataImage::Close()
+{
+	if (fData) munmap((void*) fData, fMappedSize);
+	fData = 0;
+	fMappedSize = 0;
+	fEntries.clear();
+	fHash = "";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+uint64_t HPDataImage::GetDataSize() const
+{
+	uint64_t size = 0;
+	for (size_t i = 0; i < fEntries.size(); ++i) size += fEntries[i].size;
+	return size;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool HPDataImage::Install(const std::string& parent, std::string& directory, bool& installed)
+{
+	installed = false;
+	if (!fData) {
+		fError = "no image is open";
+		return false;
+	}
+	directory = parent + "/AdEPTCubeSat-hp-" + fHash;
+	if (Exists(directory + "/" + kCompleteMarker)) return true;
+	
+	// Another process may install the same image meanwhile
+	std::ostringstream tmpName;
+	tmpName << directory << ".tmp" << getpid();
+	RemoveTree(tmpName.str());
+	if (!Extract(tmpName.str())) {
+		RemoveTree(tmpName.str());
+		return false;
+	}
+	if (std::rename(tmpName.str().c_str(), directory.c_str()) != 0) {
+		RemoveTree(tmpName.str());
+		if (!Exists(directory + "/" + kCompleteMarker)) {
+			fError = "cannot install " + directory;
+			return false;
+		}
+		return true;
+	}
+	installed = true;
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool HPDataImage::Extract(const std::string& directory)
+{
+	if (mkdir(directory.c_str(), 0755) != 0) {
+		fError = "cannot create " + directory;
+		return false;
+	}
+	for (size_t i = 0; i < fEntries.size(); ++i) {
+		const Entry& entry = fEntries[i];
+		std::string path = directory + "/" + entry.path;
+		FILE* out = MakeParents(directory, entry.path) ? std::fopen(path.c_str(), "wb") : 0;
+		bool ok = out && std::fwrite(fData + entry.offset, 1, entry.size, out) == entry.size;
+		if (out && std::fclose(out) != 0) ok = false;
+		if (!ok) {
+			fError = "cannot write " + path;
+			return false;
+		}
+	}
+	// The marker comes last, a directory without it is never used
+	FILE* marker = std::fopen((directory + "/" + kCompleteMarker).c_str(), "wb");
+	if (!marker || std::fclose(marker) != 0) {
+		fError = "cannot write " + directory + "/" + kCompleteMarker;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,139 @@
+#include "InitTimer.hh"
+#include "G4StateManager.hh"
+#include "G4Threading.hh"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+InitTimer* InitTimer::fInstance = 0;
+
+namespace
+{
+	G4double Seconds(std::chrono::steady_clock::time_point from)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+InitTimer::InitTimer() : G4VStateDependent()
+{
+	fInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+InitTimer::~InitTimer()
+{
+	if (fInstance == this) fInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void InitTimer::Begin(const G4String& phase)
+{
+	if (!fInstance || !G4Threading::IsMasterThread()) return;
+	fInstance->fPhaseName = phase;
+	fInstance->fPhaseStart = std::chrono::steady_clock::now();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void InitTimer::End(const G4String& phase)
+{
+	if (!fInstance || !G4Threading::IsMasterThread() || fInstance->fPhaseName != phase) return;
+	G4double seconds = Seconds(fInstance->fPhaseStart);
+	fInstance->fPhaseName = "";
+
+	std::vector<Phase>& phases = fInstance->fPhases;
+	for (size_t i = 0; i < phases.size(); ++i) {
+		if (phases[i].name == phase) {
+			phases[i].seconds += seconds;
+			return;
+		}
+	}
+	Phase entry = { phase, seconds };
+	phases.push_back(entry);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void InitTimer::SetTablesNote(const G4String& note)
+{
+	if (fInstance && G4Threading::IsMasterThread()) fInstance->fTablesNote = note;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool InitTimer::GetResidentMemory(G4double& resident, G4double& peak)
+{
+	resident = peak = 0.;
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		std::istringstream fields(line);
+		std::string key;
+		G4double kilobytes = 0.;
+		fields >> key >> kilobytes;
+		if (key == "VmRSS:") resident = kilobytes/1024.;
+		else if (key == "VmHWM:") peak = kilobytes/1024.;
+	}
+	return resident > 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool InitTimer::Notify(G4ApplicationState)
+{
+	// Registered with the state manager of the master thread only
+	G4StateManager* stateManager = G4StateManager::GetStateManager();
+	G4ApplicationState previous = stateManager->GetPreviousState();
+	G4ApplicationState current = stateManager->GetCurrentState();
+
+	if (current == G4State_Init) {
+		fInitStart = std::chrono::steady_clock::now();
+	} else if (previous == G4State_Init && current == G4State_Idle) {
+		fInitTimes.push_back(Seconds(fInitStart));
+	} else if (current == G4State_GeomClosed && !fInitTimes.empty()) {
+		// The last Init state was the run initialization, the others /run/initialize
+		G4double tablesTime = fInitTimes.back();
+		fInitTimes.pop_back();
+		if (!fInitTimes.empty()) Report(tablesTime);
+		fInitTimes.clear();
+		fPhases.clear();
+		fTablesNote = "";
+	}
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void InitTimer::Report(G4double tablesTime)
+{
+	G4double initTime = 0.;
+	for (size_t i = 0; i < fInitTimes.size(); ++i) initTime += fInitTimes[i];
+
+	std::ios::fmtflags flags = G4cout.flags();
+	std::streamsize precision = G4cout.precision();
+	G4cout << "============================    Initialization Timing    ============================" << G4endl;
+	G4cout << std::fixed << std::setprecision(3);
+	for (size_t i = 0; i < fPhases.size(); ++i) {
+		G4cout << std::setw(24) << std::left << fPhases[i].name + ":" << fPhases[i].seconds << " s" << G4endl;
+	}
+	G4cout << std::setw(24) << std::left << "/run/initialize:" << initTime << " s" << G4endl;
+	G4cout << std::setw(24) << std::left << "Physics tables:" << tablesTime << " s";
+	if (!fTablesNote.empty()) G4cout << " (" << fTablesNote << ")";
+	G4cout << G4endl;
+	G4double resident, peak;
+	if (GetResidentMemory(resident, peak)) {
+		G4cout << std::setw(24) << std::left << "Resident memory:" << resident << " MB (peak "
+			   << peak << " MB)" << G4endl;
+	}
+	G4cout << "==================================================================================" << G4endl;
+	G4cout.flags(flags);
+	G4cout.precision(precision);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
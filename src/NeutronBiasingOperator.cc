@@ -0,0 +1,71 @@
+#include "NeutronBiasingOperator.hh"
+#include "G4BOptnChangeCrossSection.hh"
+#include "G4BiasingProcessInterface.hh"
+#include "G4BiasingProcessSharedData.hh"
+#include "G4Neutron.hh"
+#include "G4ProcessManager.hh"
+#include "G4Track.hh"
+
+#include <cfloat>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+NeutronBiasingOperator::NeutronBiasingOperator(const G4String& name)
+ : G4VBiasingOperator(name)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+NeutronBiasingOperator::~NeutronBiasingOperator()
+{
+	std::map<const G4BiasingProcessInterface*, G4BOptnChangeCrossSection*>::iterator it;
+	for (it = fCaptureOperations.begin(); it != fCaptureOperations.end(); ++it) delete it->second;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void NeutronBiasingOperator::StartRun()
+{
+	const G4BiasingProcessSharedData* sharedData =
+		G4BiasingProcessInterface::GetSharedData(G4Neutron::Neutron()->GetProcessManager());
+	if (!sharedData) return;
+	
+	const std::vector<const G4BiasingProcessInterface*>& wrappers = sharedData->GetPhysicsBiasingProcessInterfaces();
+	for (size_t i = 0; i < wrappers.size(); ++i) {
+		if (wrappers[i]->GetWrappedProcess()->GetProcessName() != "nCapture") continue;
+		if (fCaptureOperations.find(wrappers[i]) != fCaptureOperations.end()) continue;
+		fCaptureOperations[wrappers[i]] = new G4BOptnChangeCrossSection("ImplicitCapture");
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VBiasingOperation* NeutronBiasingOperator::ProposeOccurenceBiasingOperation(const G4Track* track,
+																			   const G4BiasingProcessInterface* callingProcess)
+{
+	if (track->GetDefinition() != G4Neutron::Neutron()) return 0;
+	
+	std::map<const G4BiasingProcessInterface*, G4BOptnChangeCrossSection*>::iterator it =
+		fCaptureOperations.find(callingProcess);
+	if (it == fCaptureOperations.end()) return 0;
+	
+	// No capture possible at this energy
+	G4double analogLength = callingProcess->GetWrappedProcess()->GetCurrentInteractionLength();
+	if (analogLength > DBL_MAX/10.) return 0;
+	
+	// Same bookkeeping as for any cross section change: the operation is
+	// sampled anew after an interaction and updated by the last step
+	// otherwise. The biased cross section is zero, so the weight of a step
+	// of length L is multiplied by exp(-L/analogLength)
+	G4BOptnChangeCrossSection* operation = it->second;
+	G4VBiasingOperation* previousOperation = callingProcess->GetPreviousOccurenceBiasingOperation();
+	if (previousOperation != operation || operation->GetInteractionOccured()) {
+		operation->SetBiasedCrossSection(0.);
+		operation->Sample();
+	} else {
+		operation->UpdateForStep(callingProcess->GetPreviousStepSize());
+		operation->SetBiasedCrossSection(0.);
+		operation->UpdateForStep(0.);
+	}
+	return operation;
+}
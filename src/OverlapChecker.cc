@@ -0,0 +1,311 @@
+#include "OverlapChecker.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4Material.hh"
+#include "G4AffineTransform.hh"
+#include "G4RotationMatrix.hh"
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4UnitsTable.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <stdint.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	// Name of the cache file of a geometry description, 64-bit FNV-1a
+	G4String CacheName(const G4String& description)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < description.size(); ++i) {
+			hash ^= (unsigned char) description[i];
+			hash *= 1099511628211ULL;
+		}
+		std::ostringstream name;
+		name << std::hex << std::setw(16) << std::setfill('0') << hash << ".ok";
+		return name.str();
+	}
+
+	G4String ReadFile(const G4String& fileName)
+	{
+		std::ifstream in(fileName);
+		std::ostringstream text;
+		text << in.rdbuf();
+		return in ? text.str() : G4String();
+	}
+
+	// Largest penetration and the number of points found for one kind of overlap
+	struct Overlap
+	{
+		Overlap() : points(0), depth(0.) {}
+		void Add(G4double distance, const G4ThreeVector& point)
+		{
+			if (points++ == 0 || distance > depth) {
+				depth = distance;
+				where = point;
+			}
+		}
+		G4int points;
+		G4double depth;
+		G4ThreeVector where;
+	};
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OverlapChecker::OverlapChecker()
+ : fMessenger(0), fMode("parallel"), fCacheDirectory("overlapCache"), fResolution(1000), fTolerance(0.), fThreads(0)
+{
+	// Define commands to control the overlap check
+	DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OverlapChecker::~OverlapChecker()
+{
+	delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OverlapChecker::Check(const G4VPhysicalVolume* world)
+{
+	if (fMode != "parallel" || !world) return;
+
+	// A geometry that passed with the same settings is not checked again
+	std::ostringstream key;
+	key << "resolution " << fResolution << "\n" << "tolerance " << std::setprecision(17) << fTolerance << "\n"
+		<< Describe(world);
+	G4String cacheFile;
+	if (!fCacheDirectory.empty()) {
+		cacheFile = fCacheDirectory + "/" + CacheName(key.str());
+		if (ReadFile(cacheFile) == key.str()) {
+			G4cout << "Overlap check: geometry unchanged since it passed, see " << cacheFile << G4endl;
+			return;
+		}
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Surface points are drawn here, solids need not draw them thread-safely
+	std::vector<Placement> placements;
+	Collect(world, placements);
+
+	// Inside tests of every placement against its mother and sisters
+	std::vector< std::vector<G4String> > overlaps(placements.size());
+	std::atomic<size_t> next(0);
+	G4int threads = fThreads > 0 ? fThreads : (G4int) std::thread::hardware_concurrency();
+	if (threads < 1) threads = 1;
+	if ((size_t) threads > placements.size()) threads = placements.size();
+	std::vector<std::thread> pool;
+	for (G4int t = 0; t < threads; ++t) {
+		pool.push_back(std::thread([&]() {
+			for (size_t i = next++; i < placements.size(); i = next++) CheckPlacement(placements, i, overlaps[i]);
+		}));
+	}
+	for (size_t t = 0; t < pool.size(); ++t) pool[t].join();
+
+	G4double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	G4ExceptionDescription msg;
+	G4int found = 0;
+	for (size_t i = 0; i < overlaps.size(); ++i) {
+		for (size_t j = 0; j < overlaps[i].size(); ++j, ++found) msg << overlaps[i][j] << "\n";
+	}
+	if (found > 0) {
+		G4Exception("OverlapChecker::Check()","Code008", JustWarning, msg);
+		return;
+	}
+
+	G4cout << "Overlap check: " << placements.size() << " placements with " << fResolution << " points each OK in "
+		   << seconds << " s on " << threads << " threads" << G4endl;
+
+	if (!cacheFile.empty()) {
+		// Written under a temporary name and renamed, as for the checkpoints
+		mkdir(fCacheDirectory.c_str(), 0755);
+		std::ostringstream tmpName;
+		tmpName << cacheFile << ".tmp" << getpid();
+		std::ofstream out(tmpName.str().c_str());
+		out << key.str();
+		out.close();
+		if (out.fail() || std::rename(tmpName.str().c_str(), cacheFile.c_str()) != 0) std::remove(tmpName.str().c_str());
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String OverlapChecker::Describe(const G4VPhysicalVolume* world) const
+{
+	std::ostringstream description;
+	description << std::setprecision(17);
+
+	// Depth-first over the logical volumes, each described once
+	std::vector<const G4LogicalVolume*> stack(1, world->GetLogicalVolume());
+	std::set<const G4LogicalVolume*> seen;
+	while (!stack.empty()) {
+		const G4LogicalVolume* logical = stack.back();
+		stack.pop_back();
+		if (!seen.insert(logical).second) continue;
+
+		description << "volume " << logical->GetName() << " "
+					<< (logical->GetMaterial() ? logical->GetMaterial()->GetName() : G4String("none")) << "\n";
+		logical->GetSolid()->StreamInfo(description);
+		for (G4int i = 0; i < (G4int) logical->GetNoDaughters(); ++i) {
+			const G4VPhysicalVolume* daughter = logical->GetDaughter(i);
+			description << "daughter " << daughter->GetName() << " " << daughter->GetCopyNo() << " "
+						<< daughter->GetLogicalVolume()->GetName() << " " << daughter->GetTranslation();
+			const G4RotationMatrix* rotation = daughter->GetRotation();
+			if (rotation) {
+				description << " " << rotation->xx() << " " << rotation->xy() << " " << rotation->xz()
+							<< " " << rotation->yx() << " " << rotation->yy() << " " << rotation->yz()
+							<< " " << rotation->zx() << " " << rotation->zy() << " " << rotation->zz();
+			}
+			description << "\n";
+			stack.push_back(daughter->GetLogicalVolume());
+		}
+	}
+	return description.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OverlapChecker::Collect(const G4VPhysicalVolume* world, std::vector<Placement>& placements) const
+{
+	// Daughters of a logical volume placed several times are checked once
+	std::vector<const G4LogicalVolume*> stack(1, world->GetLogicalVolume());
+	std::set<const G4LogicalVolume*> seen;
+	while (!stack.empty()) {
+		const G4LogicalVolume* mother = stack.back();
+		stack.pop_back();
+		if (!seen.insert(mother).second) continue;
+
+		for (G4int i = 0; i < (G4int) mother->GetNoDaughters(); ++i) {
+			const G4VPhysicalVolume* daughter = mother->GetDaughter(i);
+			stack.push_back(daughter->GetLogicalVolume());
+			// Replicas and parameterisations have their own checks
+			if (!dynamic_cast<const G4PVPlacement*>(daughter)) continue;
+
+			Placement placement;
+			placement.volume = daughter;
+			placement.mother = mother;
+			G4AffineTransform toMother(daughter->GetRotation(), daughter->GetTranslation());
+			G4VSolid* solid = daughter->GetLogicalVolume()->GetSolid();
+			placement.points.reserve(fResolution);
+			for (G4int n = 0; n < fResolution; ++n) placement.points.push_back(toMother.TransformPoint(solid->GetPointOnSurface()));
+			placements.push_back(placement);
+		}
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OverlapChecker::CheckPlacement(const std::vector<Placement>& placements, size_t index, std::vector<G4String>& overlaps) const
+{
+	const Placement& placement = placements[index];
+	const G4VSolid* solid = placement.volume->GetLogicalVolume()->GetSolid();
+	const G4VSolid* motherSolid = placement.mother->GetSolid();
+	G4AffineTransform fromMother = G4AffineTransform(placement.volume->GetRotation(), placement.volume->GetTranslation()).Inverse();
+
+	// Protrusion from the mother
+	Overlap outside;
+	for (size_t n = 0; n < placement.points.size(); ++n) {
+		const G4ThreeVector& point = placement.points[n];
+		if (motherSolid->Inside(point) != kOutside) continue;
+		G4double distance = motherSolid->DistanceToIn(point);
+		if (distance > fTolerance) outside.Add(distance, point);
+	}
+	if (outside.points > 0) {
+		std::ostringstream text;
+		text << "Overlap of " << placement.volume->GetName() << " with its mother " << placement.mother->GetName()
+			 << ": " << outside.points << " points outside, up to " << G4BestUnit(outside.depth, "Length")
+			 << " at " << G4BestUnit(outside.where, "Length") << " in the mother frame";
+		overlaps.push_back(text.str());
+	}
+
+	for (size_t j = 0; j < placements.size(); ++j) {
+		if (j == index || placements[j].mother != placement.mother) continue;
+		const G4VPhysicalVolume* sister = placements[j].volume;
+		const G4VSolid* sisterSolid = sister->GetLogicalVolume()->GetSolid();
+		G4AffineTransform toSister = G4AffineTransform(sister->GetRotation(), sister->GetTranslation()).Inverse();
+
+		Overlap inside;
+		for (size_t n = 0; n < placement.points.size(); ++n) {
+			G4ThreeVector point = toSister.TransformPoint(placement.points[n]);
+			if (sisterSolid->Inside(point) != kInside) continue;
+			G4double distance = sisterSolid->DistanceToOut(point);
+			if (distance > fTolerance) inside.Add(distance, placement.points[n]);
+		}
+		// A sister entirely inside this volume has no surface point of this one in it
+		if (!placements[j].points.empty()) {
+			G4ThreeVector point = fromMother.TransformPoint(placements[j].points[0]);
+			if (solid->Inside(point) == kInside && solid->DistanceToOut(point) > fTolerance) {
+				std::ostringstream text;
+				text << "Overlap of " << placement.volume->GetName() << ": sister " << sister->GetName()
+					 << " lies inside it";
+				overlaps.push_back(text.str());
+			}
+		}
+		if (inside.points > 0) {
+			std::ostringstream text;
+			text << "Overlap of " << placement.volume->GetName() << " with its sister " << sister->GetName()
+				 << ": " << inside.points << " points inside, up to " << G4BestUnit(inside.depth, "Length")
+				 << " at " << G4BestUnit(inside.where, "Length") << " in the mother frame";
+			overlaps.push_back(text.str());
+		}
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OverlapChecker::DefineCommands()
+{
+	// Define /AdEPTCubeSat/overlaps/ command directory using generic messenger class
+	fMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/overlaps/", "Geometry overlap check");
+
+	G4GenericMessenger::Command& modeCmd = fMessenger->DeclareProperty("mode", fMode,
+		"off, serial (G4PVPlacement checks every placement while the geometry is\n"
+		"built) or parallel (all placements after construction, cached).");
+	modeCmd.SetParameterName("mode", false);
+	modeCmd.SetCandidates("off serial parallel");
+	modeCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+	G4GenericMessenger::Command& resolutionCmd = fMessenger->DeclareProperty("resolution", fResolution,
+		"Surface points per placement.");
+	resolutionCmd.SetParameterName("resolution", false);
+	resolutionCmd.SetRange("resolution>0");
+	resolutionCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+	G4GenericMessenger::Command& toleranceCmd = fMessenger->DeclarePropertyWithUnit("tolerance", "um", fTolerance,
+		"Overlaps up to this depth are accepted.");
+	toleranceCmd.SetParameterName("tolerance", false);
+	toleranceCmd.SetRange("tolerance>=0");
+	toleranceCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+	G4GenericMessenger::Command& threadsCmd = fMessenger->DeclareProperty("threads", fThreads,
+		"Threads of the parallel check, 0 for one per core.");
+	threadsCmd.SetParameterName("threads", false);
+	threadsCmd.SetRange("threads>=0");
+	threadsCmd.SetStates(G4State_PreInit, G4State_Idle);
+
+	G4GenericMessenger::Command& cacheCmd = fMessenger->DeclareProperty("cache", fCacheDirectory,
+		"Directory recording the geometries that passed; empty to check every time.");
+	cacheCmd.SetParameterName("directory", true);
+	cacheCmd.SetDefaultValue("");
+	cacheCmd.SetStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
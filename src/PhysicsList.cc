@@ -1,4 +1,7 @@
 #include "PhysicsList.hh"
+#include "PhysicsTableCache.hh"
+#include "HPDataImage.hh"
+#include "InitTimer.hh"
 
 #include "G4Region.hh"
 #include "G4RegionStore.hh"
@@ -11,9 +14,21 @@
 #include "G4EmLivermorePhysics.hh"
 #include "G4EmPenelopePhysics.hh"
 #include "G4DecayPhysics.hh"
+#include "G4GenericBiasingPhysics.hh"
+#include "G4BiasingProcessInterface.hh"
+#include "G4Threading.hh"
+#include "G4GenericMessenger.hh"
+#include "G4ApplicationState.hh"
+#include "G4StateManager.hh"
+#include "G4Element.hh"
+
+#include <cstdlib>
+#include <set>
+#include <sstream>
 
 #include "G4PAIModel.hh"
 #include "G4PAIPhotModel.hh"
+#include "G4FastSimulationManagerProcess.hh"
 
 #include "G4HadronPhysicsQGSP_BIC_HP.hh"
 #include "G4HadronPhysicsQGSP_BERT_HP.hh"
@@ -31,6 +46,7 @@
 #include "G4UnitsTable.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4LossTableManager.hh"
+#include "G4ProductionCuts.hh"
 #include "G4ProductionCutsTable.hh"
 #include "G4EmConfigurator.hh"
 #include "G4EmParameters.hh"
@@ -59,7 +75,17 @@
 
 PhysicsList::PhysicsList() : G4VModularPhysicsList(),
 	fEmPhysicsList(0),
-  	fDecayPhysicsList(0)
+  	fDecayPhysicsList(0),
+  	fHadronicName("QGSP_BIC_HP"),
+  	fDecayProcesses(true),
+  	fBiasingPhysics(0),
+  	fBiasGamma(false),
+  	fBiasNeutron(false),
+  	fRangeOut(false),
+  	fRangeOutVoxel(1.*mm),
+  	fMessenger(0),
+  	fTableCache(0),
+  	fHPImageDirectory("/dev/shm")
 {	
 	// Default cut value
   	SetDefaultCutValue(0.5*mm);
@@ -79,12 +105,109 @@ PhysicsList::PhysicsList() : G4VModularPhysicsList(),
   	// fEmName = G4String("pai_photon");
   	fEmName = G4String("pai");
 	  
-	// Hadron Physics
-  	// fHadronPhys.push_back( new G4HadronPhysicsQGSP_BERT_HP());
-  	fHadronPhys.push_back( new G4HadronPhysicsQGSP_BIC_HP());
-	// fHadronPhys.push_back( new G4HadronPhysicsFTFP_BERT_HP());
-	// fHadronPhys.push_back( new G4HadronPhysicsQGSP_BIC_AllHP());
-
+	// Hadron Physics is created by ConfigureHadronPhysics
+	
+	// Biasing of all photon processes, only applied when enabled
+	fBiasingPhysics = new G4GenericBiasingPhysics();
+	fBiasingPhysics->Bias("gamma");
+	
+	// Production cuts of the gas regions, the same for gamma, e- and e+
+	fRegionCuts["Region_Sensitive_Gas"] = 10*mm;
+	fRegionCuts["Region_PV_Gas"] = 10*mm;
+	
+	// Define /AdEPTCubeSat/physics/ command directory using generic messenger class
+	fMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/physics/", "Physics control");
+	G4GenericMessenger::Command& biasCmd = fMessenger->DeclareProperty("biasGamma", fBiasGamma,
+		"Force photons entering the sensitive gas to interact there (conversion,\n"
+		"Compton, photoelectric or Rayleigh) and write the event weight to the\n"
+		"ntuple and the histograms. Must be set before /run/initialize.");
+	biasCmd.SetParameterName("biasGamma", true);
+	biasCmd.SetDefaultValue("true");
+	biasCmd.SetStates(G4State_PreInit);
+	
+	G4GenericMessenger::Command& addCmd = fMessenger->DeclareMethod("addPhysics", &PhysicsList::AddPhysicsList,
+		"Select the EM constructor, the model of the sensitive gas (nopai for the\n"
+		"EM constructor alone) or the hadron physics. Must be given before\n"
+		"/run/initialize.");
+	addCmd.SetParameterName("name", false);
+	addCmd.SetCandidates("emstandard emstandard_opt1 emstandard_opt2 emstandard_opt3 emstandard_opt4 "
+						 "emlivermore empenelope pai pai_photon nopai "
+						 "none QGSP_BIC_HP QGSP_BERT_HP QGSP_BIC_AllHP FTFP_BERT_HP");
+	addCmd.SetStates(G4State_PreInit);
+	
+	G4GenericMessenger::Command& hadronicCmd = fMessenger->DeclareProperty("hadronic", fHadronicName,
+		"Hadron physics constructor. \"auto\" derives it from the primaries: none\n"
+		"(and no decay processes) when only photons and electrons are shot,\n"
+		"QGSP_BIC_HP otherwise. Must be set before /run/initialize.");
+	hadronicCmd.SetParameterName("hadronic", false);
+	hadronicCmd.SetCandidates("auto none QGSP_BIC_HP QGSP_BERT_HP QGSP_BIC_AllHP FTFP_BERT_HP");
+	hadronicCmd.SetStates(G4State_PreInit);
+	
+	G4GenericMessenger::Command& primariesCmd = fMessenger->DeclareProperty("primaries", fPrimaries,
+		"Particle names of the primaries of the following runs, e.g. \"gamma e-\",\n"
+		"from which hadronic auto selects the physics. Each new primary species is\n"
+		"checked against the constructed processes.");
+	primariesCmd.SetParameterName("particles", false);
+	primariesCmd.SetStates(G4State_PreInit);
+	
+	G4GenericMessenger::Command& neutronCmd = fMessenger->DeclareMethod("biasNeutron", &PhysicsList::SetBiasNeutron,
+		"Survival biasing of neutrons: outside the sensitive gas neutrons are not\n"
+		"captured and carry the survival probability in their weight instead.\n"
+		"Combine with /AdEPTCubeSat/neutronBias/windows. Must be set before\n"
+		"/run/initialize.");
+	neutronCmd.SetParameterName("biasNeutron", true);
+	neutronCmd.SetDefaultValue("true");
+	neutronCmd.SetStates(G4State_PreInit);
+	
+	G4GenericMessenger::Command& rangeOutCmd = fMessenger->DeclareProperty("rangeOut", fRangeOut,
+		"Deposit electrons in the sensitive gas at once when their range is below\n"
+		"rangeOutVoxel and their distance to the boundary, instead of tracking\n"
+		"them with PAI steps. Must be set before /run/initialize.");
+	rangeOutCmd.SetParameterName("rangeOut", true);
+	rangeOutCmd.SetDefaultValue("true");
+	rangeOutCmd.SetStates(G4State_PreInit);
+	
+	G4GenericMessenger::Command& voxelCmd = fMessenger->DeclarePropertyWithUnit("rangeOutVoxel", "mm", fRangeOutVoxel,
+		"Range below which electrons are deposited at once by rangeOut.");
+	voxelCmd.SetParameterName("voxel", false);
+	voxelCmd.SetRange("voxel>0.");
+	voxelCmd.SetStates(G4State_PreInit);
+	
+	// Physics tables are stored and retrieved by the master thread
+	fTableCache = new PhysicsTableCache(this);
+	G4GenericMessenger::Command& cacheCmd = fMessenger->DeclareMethod("tableCache", &PhysicsList::SetTableCache,
+		"Directory in which the physics tables are stored and from which they\n"
+		"are retrieved when physics list, cuts and materials are unchanged.\n"
+		"Without a directory the tables are always built.");
+	cacheCmd.SetParameterName("directory", true);
+	cacheCmd.SetDefaultValue("");
+	cacheCmd.SetStates(G4State_PreInit, G4State_Idle);
+	
+	G4GenericMessenger::Command& regionCutCmd = fMessenger->DeclareMethod("regionCut", &PhysicsList::SetRegionCut,
+		"Production cut of a region, e.g. \"Region_Sensitive_Gas 5 mm\". Regions\n"
+		"without a cut use /run/setCut, which does not change the region cuts.");
+	regionCutCmd.SetParameterName("regionCut", false);
+	regionCutCmd.SetStates(G4State_PreInit, G4State_Idle);
+	
+	// The HP data directory is read when the hadronic models are constructed
+	G4GenericMessenger::Command& imageCmd = fMessenger->DeclareMethod("hpImage", &PhysicsList::SetHPImage,
+		"NeutronHP data image written by hpPack or the hppack tool. It is installed\n"
+		"once per node in hpImageDir and used instead of G4NEUTRONHPDATA.\n"
+		"Must be given before /run/initialize.");
+	imageCmd.SetParameterName("image", false);
+	imageCmd.SetStates(G4State_PreInit);
+	
+	G4GenericMessenger::Command& imageDirCmd = fMessenger->DeclareProperty("hpImageDir", fHPImageDirectory,
+		"Directory in which hpImage is installed, preferably on a memory file\n"
+		"system shared by the processes of the node.");
+	imageDirCmd.SetParameterName("directory", false);
+	imageDirCmd.SetStates(G4State_PreInit);
+	
+	G4GenericMessenger::Command& packCmd = fMessenger->DeclareMethod("hpPack", &PhysicsList::PackHPImage,
+		"Write the NeutronHP data image for the elements of all defined materials\n"
+		"from the data in G4NEUTRONHPDATA.");
+	packCmd.SetParameterName("image", false);
+	packCmd.SetStates(G4State_PreInit, G4State_Idle);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -93,6 +216,9 @@ PhysicsList::~PhysicsList()
 {
 	delete fDecayPhysicsList;
 	delete fEmPhysicsList;
+	delete fBiasingPhysics;
+	delete fMessenger;
+	delete fTableCache;
 	for(size_t i=0; i<fHadronPhys.size(); ++i) { delete fHadronPhys[i]; }
 }
 
@@ -100,13 +226,17 @@ PhysicsList::~PhysicsList()
 
 void PhysicsList::ConstructParticle()
 {
+	InitTimer::Begin("Particles");
 	fDecayPhysicsList->ConstructParticle();
+	InitTimer::End("Particles");
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void PhysicsList::ConstructProcess()
 {
+	InitTimer::Begin("Processes");
+	
 	// Transportation Physics
 	AddTransportation();
 	
@@ -114,13 +244,165 @@ void PhysicsList::ConstructProcess()
 	fEmPhysicsList->ConstructProcess();
 	AddPAIModel(fEmName);
 	
-	// Decay Physics
-	fDecayPhysicsList->ConstructProcess();
-	
-	// Hadronic Physics
+	// Decay and Hadronic Physics
+	if (G4Threading::IsMasterThread()) ConfigureHadronPhysics();
+	if (fDecayProcesses) fDecayPhysicsList->ConstructProcess();
 	for(size_t i=0; i<fHadronPhys.size(); ++i) { 
     	fHadronPhys[i]->ConstructProcess(); 
-  	}	
+  	}
+  	
+  	// Fast simulation of electrons in the regions with a model
+  	if (fRangeOut) {
+  		G4Electron::Electron()->GetProcessManager()->AddDiscreteProcess(new G4FastSimulationManagerProcess());
+  	}
+  	
+  	// Biasing wraps the processes defined above, so it comes last
+  	if (fBiasGamma || fBiasNeutron) fBiasingPhysics->ConstructProcess();
+  	
+  	InitTimer::End("Processes");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String PhysicsList::GetPhysicsDescription() const
+{
+	G4String description = fEmPhysicsList->GetPhysicsName() + " " + fEmName;
+	if (fDecayProcesses) description += " " + fDecayPhysicsList->GetPhysicsName();
+	for(size_t i=0; i<fHadronPhys.size(); ++i) { 
+		description += " " + fHadronPhys[i]->GetPhysicsName(); 
+	}
+	if (fBiasGamma) description += " biasGamma";
+	if (fBiasNeutron) description += " biasNeutron";
+	if (fRangeOut) description += " rangeOut";
+	return description;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhysicsList::ConfigureHadronPhysics()
+{
+	G4String name = fHadronicName == "auto" ? SelectHadronPhysics() : fHadronicName;
+	
+	for(size_t i=0; i<fHadronPhys.size(); ++i) { delete fHadronPhys[i]; }
+	fHadronPhys.clear();
+	if (name == "QGSP_BIC_HP") fHadronPhys.push_back( new G4HadronPhysicsQGSP_BIC_HP());
+	else if (name == "QGSP_BERT_HP") fHadronPhys.push_back( new G4HadronPhysicsQGSP_BERT_HP());
+	else if (name == "QGSP_BIC_AllHP") fHadronPhys.push_back( new G4HadronPhysicsQGSP_BIC_AllHP());
+	else if (name == "FTFP_BERT_HP") fHadronPhys.push_back( new G4HadronPhysicsFTFP_BERT_HP());
+	
+	// Without hadrons only the EM processes can produce secondaries, and
+	// none of them is unstable
+	fDecayProcesses = !fHadronPhys.empty();
+	
+	G4cout << "Physics configuration: " << GetPhysicsDescription()
+		   << (fHadronicName == "auto" ? " (auto for primaries: " + fPrimaries + ")" : G4String()) << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String PhysicsList::SelectHadronPhysics() const
+{
+	// There are no gamma- or electro-nuclear processes in this list, so
+	// photons and electrons never lead to hadrons at any energy
+	std::istringstream species(fPrimaries);
+	G4String name;
+	G4bool any = false;
+	while (species >> name) {
+		any = true;
+		if (name != "gamma" && name != "e-" && name != "e+") return "QGSP_BIC_HP";
+	}
+	if (!any) {
+		G4Exception("PhysicsList::SelectHadronPhysics()","Code013", JustWarning,
+					"hadronic auto without /AdEPTCubeSat/physics/primaries, QGSP_BIC_HP is used.");
+		return "QGSP_BIC_HP";
+	}
+	return "none";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String PhysicsList::GetMissingProcesses(const G4ParticleDefinition* particle) const
+{
+	G4bool hadronic = false;
+	G4bool decay = false;
+	G4ProcessManager* processManager = particle->GetProcessManager();
+	G4ProcessVector* processes = processManager ? processManager->GetProcessList() : 0;
+	for (G4int i = 0; processes && i < (G4int) processes->size(); ++i) {
+		const G4VProcess* process = (*processes)[i];
+		// Biased processes are found through their wrapper
+		const G4BiasingProcessInterface* wrapper = dynamic_cast<const G4BiasingProcessInterface*>(process);
+		if (wrapper && wrapper->GetWrappedProcess()) process = wrapper->GetWrappedProcess();
+		if (process->GetProcessType() == fHadronic) hadronic = true;
+		else if (process->GetProcessType() == fDecay) decay = true;
+	}
+	
+	G4String type = particle->GetParticleType();
+	G4String missing;
+	if (!hadronic && (type == "baryon" || type == "meson" || type == "nucleus")) missing += " hadronic";
+	if (!decay && !particle->GetPDGStable() && !particle->IsShortLived() && type != "nucleus") missing += " decay";
+	return missing;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhysicsList::SetBiasNeutron(G4bool bias)
+{
+	// The neutron processes are wrapped once, an unused wrapper is harmless
+	if (bias && !fBiasNeutron) fBiasingPhysics->Bias("neutron");
+	fBiasNeutron = bias;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhysicsList::SetTableCache(const G4String& directory)
+{
+	fTableCache->SetDirectory(directory);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhysicsList::SetHPImage(const G4String& imageName)
+{
+	InitTimer::Begin("HP data image");
+	HPDataImage image;
+	std::string directory;
+	G4bool installed = false;
+	if (!image.Open(imageName) || !image.Install(fHPImageDirectory, directory, installed)) {
+		InitTimer::End("HP data image");
+		const char* dataDirectory = std::getenv("G4NEUTRONHPDATA");
+		G4ExceptionDescription msg;
+		msg << image.GetError() << "\nThe NeutronHP data is read from "
+			<< (dataDirectory ? dataDirectory : "G4NEUTRONHPDATA, which is not set") << ".";
+		G4Exception("PhysicsList::SetHPImage()","Code012", JustWarning, msg);
+		return;
+	}
+	setenv("G4NEUTRONHPDATA", directory.c_str(), 1);
+	InitTimer::End("HP data image");
+	
+	G4cout << "NeutronHP data: " << image.GetNumberOfFiles() << " files, "
+		   << image.GetDataSize()/1048576. << " MB of " << imageName
+		   << (installed ? " installed in " : " already in ") << directory << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhysicsList::PackHPImage(const G4String& imageName)
+{
+	const char* dataDirectory = std::getenv("G4NEUTRONHPDATA");
+	std::set<int> elements;
+	const G4ElementTable* table = G4Element::GetElementTable();
+	for (size_t i = 0; i < table->size(); ++i) elements.insert((int) (*table)[i]->GetZ());
+	
+	std::string error = dataDirectory ? "" : "G4NEUTRONHPDATA is not set";
+	if (!dataDirectory || !HPDataImage::Pack(dataDirectory, elements, imageName, error)) {
+		G4ExceptionDescription msg;
+		msg << "Cannot pack the NeutronHP data image " << imageName << ": " << error;
+		G4Exception("PhysicsList::PackHPImage()","Code012", JustWarning, msg);
+		return;
+	}
+	G4cout << "NeutronHP data of Z =";
+	for (std::set<int>::const_iterator it = elements.begin(); it != elements.end(); ++it) G4cout << " " << *it;
+	G4cout << " (and Z+-1) packed into " << imageName << G4endl;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -131,54 +413,51 @@ void PhysicsList::AddPhysicsList(const G4String& name)
     	G4cout << "PhysicsList::AddPhysicsList: <" << name << ">" << G4endl;
   	}
 
-  	if (name == fEmName) {
-    	return;
+	// EM constructors replace fEmPhysicsList, the PAI models are added to the
+	// sensitive gas region of whichever constructor in ConstructProcess
+  	if (name == "emstandard") {
+
+    	delete fEmPhysicsList;
+    	fEmPhysicsList = new G4EmStandardPhysics();
 
 	} else if (name == "emstandard_opt1") {
 
-    	fEmName = name;
     	delete fEmPhysicsList;
     	fEmPhysicsList = new G4EmStandardPhysics_option1();
 
   	} else if (name == "emstandard_opt2") {
 
-    	fEmName = name;
     	delete fEmPhysicsList;
 		fEmPhysicsList = new G4EmStandardPhysics_option2();
 
 	} else if (name == "emstandard_opt3") {
 
-    	fEmName = name;
     	delete fEmPhysicsList;
     	fEmPhysicsList = new G4EmStandardPhysics_option3();
 
 	} else if (name == "emstandard_opt4") {
 
-		fEmName = name;
 		delete fEmPhysicsList;
 		fEmPhysicsList = new G4EmStandardPhysics_option4();
 
 	} else if (name == "emlivermore") {
 
-		fEmName = name;
 		delete fEmPhysicsList;
 		fEmPhysicsList = new G4EmLivermorePhysics();
 
 	} else if (name == "empenelope") {
 
-		fEmName = name;
 		delete fEmPhysicsList;
 		fEmPhysicsList = new G4EmPenelopePhysics();
 		
-	} else if (name == "pai") {
+	} else if (name == "pai" || name == "pai_photon" || name == "nopai") {
 
     	fEmName = name;
-    	AddPAIModel(name);
 
-  	} else if (name == "pai_photon") { 
+	} else if (name == "none" || name == "QGSP_BIC_HP" || name == "QGSP_BERT_HP" || name == "QGSP_BIC_AllHP"
+			   || name == "FTFP_BERT_HP") {
 
-    	fEmName = name;
-    	AddPAIModel(name);
+		fHadronicName = name;
 
 	} else {
 
@@ -192,6 +471,7 @@ void PhysicsList::AddPhysicsList(const G4String& name)
 
 void PhysicsList::SetCuts()
 {
+	InitTimer::Begin("Production cuts");
 
 	// Special threshold for low energy physics
   	G4ProductionCutsTable::GetProductionCutsTable()->SetEnergyRange(990*eV, 10*GeV);
@@ -199,26 +479,60 @@ void PhysicsList::SetCuts()
 	// Default production thresholds for the world volume
  	SetCutsWithDefault();
  	
- 	// Production thresholds for detector regions
-  	G4Region* region;
-  	G4String regName;
-  	G4ProductionCuts* cuts;
-  	
-  	// Production cuts for Sensitive Gas Volume 
-  	regName = "Region_Sensitive_Gas";
-  	region = G4RegionStore::GetInstance()->GetRegion(regName);
-  	cuts = new G4ProductionCuts;
-  	cuts->SetProductionCut(10*mm); // same cuts for gamma, e- and e+
-  	region->SetProductionCuts(cuts);
-  	
-  	// Production cuts for the remaining PV Gas 
-  	regName = "Region_PV_Gas";
-  	region = G4RegionStore::GetInstance()->GetRegion(regName);
-  	cuts = new G4ProductionCuts;
-  	cuts->SetProductionCut(10*mm); // same cuts for gamma, e- and e+
-  	region->SetProductionCuts(cuts);
+ 	// Production thresholds for detector regions, same cuts for gamma, e- and e+.
+ 	// New cuts are picked up by the cuts table at the next run initialization
+ 	std::map<G4String, G4double>::const_iterator it;
+ 	for (it = fRegionCuts.begin(); it != fRegionCuts.end(); ++it) {
+ 		G4Region* region = G4RegionStore::GetInstance()->GetRegion(it->first, false);
+ 		if (!region) {
+ 			G4ExceptionDescription msg;
+ 			msg << "Region " << it->first << " of /AdEPTCubeSat/physics/regionCut does not exist.";
+ 			G4Exception("PhysicsList::SetCuts()","Code014", JustWarning, msg);
+ 			continue;
+ 		}
+ 		G4ProductionCuts* cuts = new G4ProductionCuts;
+ 		cuts->SetProductionCut(it->second);
+ 		region->SetProductionCuts(cuts);
+ 	}
  	 
  	if (verboseLevel > 0) { DumpCutValuesTable(); }
+ 	
+ 	InitTimer::End("Production cuts");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhysicsList::SetRegionCut(const G4String& value)
+{
+	std::istringstream input(value);
+	G4String regionName, unit;
+	G4double cut = 0.;
+	if (!(input >> regionName >> cut >> unit) || !G4UnitDefinition::IsUnitDefined(unit)
+		|| G4UnitDefinition::GetCategory(unit) != "Length" || cut <= 0.) {
+		G4ExceptionDescription msg;
+		msg << "Expected \"<region> <cut> <length unit>\" with a positive cut, got \"" << value
+			<< "\". Cuts unchanged.";
+		G4Exception("PhysicsList::SetRegionCut()","Code014", JustWarning, msg);
+		return;
+	}
+	fRegionCuts[regionName] = cut*G4UnitDefinition::GetValueOf(unit);
+	
+	// After /run/initialize the cuts are applied to the regions at once,
+	// before it the regions are not built yet
+	if (G4StateManager::GetStateManager()->GetCurrentState() == G4State_Idle) SetCuts();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String PhysicsList::GetCutsDescription() const
+{
+	std::ostringstream description;
+	description << "default " << GetDefaultCutValue()/mm << " mm";
+	std::map<G4String, G4double>::const_iterator it;
+	for (it = fRegionCuts.begin(); it != fRegionCuts.end(); ++it) {
+		description << ", " << it->first << " " << it->second/mm << " mm";
+	}
+	return description.str();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,201 @@
+#include "PhysicsTableCache.hh"
+#include "PhysicsList.hh"
+#include "InitTimer.hh"
+
+#include "G4StateManager.hh"
+#include "G4Version.hh"
+#include "G4Material.hh"
+#include "G4Element.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4EmParameters.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdint.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	const char* kCacheVersion = "AdEPTCubeSat-physics-tables-1";
+
+	// 64-bit FNV-1a, names the entry; key.txt decides whether it matches
+	G4String Hash(const G4String& text)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < text.size(); ++i) {
+			hash ^= (unsigned char) text[i];
+			hash *= 1099511628211ULL;
+		}
+		std::ostringstream name;
+		name << std::hex << std::setw(16) << std::setfill('0') << hash;
+		return name.str();
+	}
+
+	G4String ReadFile(const G4String& fileName)
+	{
+		std::ifstream in(fileName);
+		std::ostringstream text;
+		text << in.rdbuf();
+		return in ? text.str() : G4String();
+	}
+
+	// Removes a directory holding only files
+	void RemoveDirectory(const G4String& path)
+	{
+		DIR* dir = opendir(path.c_str());
+		if (dir) {
+			while (dirent* entry = readdir(dir)) {
+				G4String name = entry->d_name;
+				if (name != "." && name != "..") std::remove((path + "/" + name).c_str());
+			}
+			closedir(dir);
+		}
+		rmdir(path.c_str());
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhysicsTableCache::PhysicsTableCache(PhysicsList* physicsList)
+ : G4VStateDependent(), fPhysicsList(physicsList), fStorePending(false)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhysicsTableCache::~PhysicsTableCache()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PhysicsTableCache::Notify(G4ApplicationState)
+{
+	// Registered with the state manager of the master thread only
+	G4StateManager* stateManager = G4StateManager::GetStateManager();
+	G4ApplicationState previous = stateManager->GetPreviousState();
+	G4ApplicationState current = stateManager->GetCurrentState();
+
+	// Tables are built in the Init state of the run initialization, after
+	// any /run/setCut, and are complete when the geometry is closed
+	if (previous == G4State_Idle && current == G4State_Init) Prepare();
+	else if (current == G4State_GeomClosed && fStorePending) Store();
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String PhysicsTableCache::MakeKey() const
+{
+	std::ostringstream key;
+	key << std::setprecision(17);
+	key << kCacheVersion << "\n";
+	key << "geant4 " << G4VERSION_NUMBER << "\n";
+	key << "physics " << fPhysicsList->GetPhysicsDescription() << "\n";
+
+	#if G4VERSION_NUMBER >= 1040
+	key << "emParameters\n" << *G4EmParameters::Instance();
+	#endif
+
+	G4ProductionCutsTable* cutsTable = G4ProductionCutsTable::GetProductionCutsTable();
+	key << "energyRange " << cutsTable->GetLowEdgeEnergy() << " " << cutsTable->GetHighEdgeEnergy() << "\n";
+	key << "defaultCut " << fPhysicsList->GetDefaultCutValue() << "\n";
+
+	const G4RegionStore* regions = G4RegionStore::GetInstance();
+	for (size_t i = 0; i < regions->size(); ++i) {
+		const G4Region* region = (*regions)[i];
+		key << "region " << region->GetName();
+		const G4ProductionCuts* cuts = region->GetProductionCuts();
+		if (cuts) {
+			key << " cuts " << cuts->GetProductionCut("gamma") << " " << cuts->GetProductionCut("e-")
+				<< " " << cuts->GetProductionCut("e+") << " " << cuts->GetProductionCut("proton");
+		}
+		key << "\n";
+	}
+
+	const G4MaterialTable* materials = G4Material::GetMaterialTable();
+	for (size_t i = 0; i < materials->size(); ++i) {
+		const G4Material* material = (*materials)[i];
+		key << "material " << material->GetName() << " " << material->GetDensity() << " " << material->GetState()
+			<< " " << material->GetTemperature() << " " << material->GetPressure()
+			<< " " << material->GetIonisation()->GetMeanExcitationEnergy();
+		for (size_t j = 0; j < material->GetNumberOfElements(); ++j) {
+			const G4Element* element = material->GetElement(j);
+			key << " " << element->GetZ() << ":" << element->GetN() << ":" << material->GetFractionVector()[j];
+		}
+		key << "\n";
+	}
+
+	// Materials and regions of the volumes define the material-cuts couples
+	const G4LogicalVolumeStore* volumes = G4LogicalVolumeStore::GetInstance();
+	for (size_t i = 0; i < volumes->size(); ++i) {
+		const G4LogicalVolume* volume = (*volumes)[i];
+		key << "volume " << volume->GetName() << " " << (volume->GetMaterial() ? volume->GetMaterial()->GetName() : "none")
+			<< " " << (volume->GetRegion() ? volume->GetRegion()->GetName() : "none") << "\n";
+	}
+	return key.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhysicsTableCache::Prepare()
+{
+	fStorePending = false;
+	if (fDirectory.empty()) {
+		fPhysicsList->ResetPhysicsTableRetrieved();
+		return;
+	}
+
+	fKey = MakeKey();
+	fEntry = fDirectory + "/" + Hash(fKey);
+	if (ReadFile(fEntry + "/key.txt") == fKey) {
+		fPhysicsList->SetPhysicsTableRetrieved(fEntry);
+		InitTimer::SetTablesNote("retrieved from " + fEntry);
+	} else {
+		fPhysicsList->ResetPhysicsTableRetrieved();
+		fStorePending = true;
+		InitTimer::SetTablesNote("built, stored in " + fEntry);
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhysicsTableCache::Store()
+{
+	fStorePending = false;
+
+	std::ostringstream tmpName;
+	tmpName << fEntry << ".tmp" << getpid();
+	G4String tmpEntry = tmpName.str();
+	mkdir(fDirectory.c_str(), 0755);
+	mkdir(tmpEntry.c_str(), 0755);
+
+	// key.txt comes last, an entry without it is never retrieved
+	G4bool stored = fPhysicsList->StorePhysicsTable(tmpEntry);
+	if (stored) {
+		std::ofstream out(tmpEntry + "/key.txt");
+		out << fKey;
+		out.close();
+		stored = !out.fail();
+	}
+
+	// Another job may have stored the same entry meanwhile
+	if (!stored || std::rename(tmpEntry.c_str(), fEntry.c_str()) != 0) {
+		RemoveDirectory(tmpEntry);
+		if (!stored) {
+			G4ExceptionDescription msg;
+			msg << "Cannot store the physics tables in " << fEntry << "\n";
+			G4Exception("PhysicsTableCache::Store()","Code006", JustWarning, msg);
+		}
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -1,17 +1,344 @@
-#include "PrimaryGeneratorAction.hh"
-#include "G4GeneralParticleSource.hh"
-
-PrimaryGeneratorAction::PrimaryGeneratorAction()
-{
-	particleGun = new G4GeneralParticleSource();
-}
-
-PrimaryGeneratorAction::~PrimaryGeneratorAction()
-{
-	delete particleGun;
-}
-
-void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
-{
-	particleGun->GeneratePrimaryVertex(anEvent);
-}
\ No newline at end of file
+#include "PrimaryGeneratorAction.hh"
+#include "DetectorConstruction.hh"
+#include "Run.hh"
+#include "RowWriter.hh"
+#include "CheckpointManager.hh"
+#include "PhysicsList.hh"
+#include "G4GeneralParticleSource.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4RunManager.hh"
+#include "G4UIcommand.hh"
+#include "G4UnitsTable.hh"
+#include "Randomize.hh"
+#include "G4Version.hh"
+#include "CLHEP/Random/RanecuEngine.h"
+#include "CLHEP/Random/RanluxEngine.h"
+#if G4VERSION_NUMBER >= 1030
+#include "CLHEP/Random/MixMaxRng.h"
+#endif
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <sstream>
+#include <stdint.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+	// Values followed by an energy unit; false if the unit or a value is invalid
+	G4bool ParseEnergies(const G4String& values, std::vector<G4double>& energies)
+	{
+		std::istringstream in(values);
+		std::vector<G4String> tokens;
+		G4String token;
+		while (in >> token) tokens.push_back(token);
+		if (tokens.size() < 2 || !G4UnitDefinition::IsUnitDefined(tokens.back())
+			|| G4UnitDefinition::GetCategory(tokens.back()) != "Energy") return false;
+		
+		G4double unit = G4UIcommand::ValueOf(tokens.back());
+		energies.clear();
+		for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+			std::istringstream value(tokens[i]);
+			G4double energy;
+			if (!(value >> energy) || energy <= 0.) return false;
+			energies.push_back(energy*unit);
+		}
+		return true;
+	}
+	
+	// Engines selectable with /AdEPTCubeSat/random/engine
+#if G4VERSION_NUMBER >= 1030
+	const char* kEngineNames = "Ranecu MixMax Ranlux";
+#else
+	const char* kEngineNames = "Ranecu Ranlux";
+#endif
+	
+	CLHEP::HepRandomEngine* NewEngine(const G4String& name)
+	{
+#if G4VERSION_NUMBER >= 1030
+		if (name == "MixMax") return new CLHEP::MixMaxRng();
+#endif
+		if (name == "Ranlux") return new CLHEP::RanluxEngine();
+		return new CLHEP::RanecuEngine();
+	}
+	
+	// SplitMix64 step, spreads consecutive event numbers over the seed space
+	uint64_t SplitMix64(uint64_t& state)
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PrimaryGeneratorAction::PrimaryGeneratorAction(DetectorConstruction* det)
+ : detector(det), fMessenger(0), fRandomMessenger(0), fAcceptance(false), fMaxTrials(1000000),
+   fScanMode(kScanOff), fMasterSeed(12345), fFirstEvent(0), fEngineName("Ranecu"), fEngine(0)
+{
+	particleGun = new G4GeneralParticleSource();
+	
+	// Define commands to control the source
+	DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PrimaryGeneratorAction::~PrimaryGeneratorAction()
+{
+	delete particleGun;
+	delete fMessenger;
+	delete fRandomMessenger;
+	
+	// An engine still in use by the thread is left to it
+	if (G4Random::getTheEngine() != fEngine) delete fEngine;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
+{
+	Run* run = dynamic_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+	
+	// Stop requested by a signal: end the run of this thread after the events
+	// already processed; this event is not recorded. The rows of this thread
+	// end here, so the merge no longer waits on the rest of its batch
+	if (CheckpointManager::IsStopRequested()) {
+		G4RunManager::GetRunManager()->AbortRun(true);
+		anEvent->SetEventAborted();
+		if (run && run->GetRowWriter()) run->GetRowWriter()->Stop();
+		return;
+	}
+	
+	G4long eventNumber = fFirstEvent + anEvent->GetEventID();
+	SeedEvent(eventNumber);
+	
+	if (!fAcceptance || !detector) {
+		particleGun->GeneratePrimaryVertex(anEvent);
+		if (run) run->AddSourceRays(1);
+	} else {
+		GenerateAccepted(anEvent, run);
+	}
+	
+	// The scan energy replaces the energy drawn by the GPS
+	if (fScanMode != kScanOff) {
+		G4double energy = SampleScanEnergy(eventNumber);
+		for (G4int i = 0; i < anEvent->GetNumberOfPrimaryVertex(); ++i) {
+			for (G4PrimaryParticle* primary = anEvent->GetPrimaryVertex(i)->GetPrimary(); primary; primary = primary->GetNext()) {
+				primary->SetKineticEnergy(energy);
+			}
+		}
+	}
+	
+	CheckPhysics(anEvent);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::CheckPhysics(const G4Event* anEvent)
+{
+	for (G4int i = 0; i < anEvent->GetNumberOfPrimaryVertex(); ++i) {
+		for (G4PrimaryParticle* primary = anEvent->GetPrimaryVertex(i)->GetPrimary(); primary; primary = primary->GetNext()) {
+			const G4ParticleDefinition* particle = primary->GetG4code();
+			if (!particle || !fCheckedSpecies.insert(particle).second) continue;
+			
+			const PhysicsList* physicsList =
+				dynamic_cast<const PhysicsList*>(G4RunManager::GetRunManager()->GetUserPhysicsList());
+			G4String missing = physicsList ? physicsList->GetMissingProcesses(particle) : G4String();
+			if (missing.empty()) continue;
+			G4ExceptionDescription msg;
+			msg << "Primary " << particle->GetParticleName() << " has no" << missing << " processes with "
+				<< physicsList->GetPhysicsDescription() << ".\n"
+				<< "Set /AdEPTCubeSat/physics/hadronic or /AdEPTCubeSat/physics/primaries.";
+			G4Exception("PrimaryGeneratorAction::CheckPhysics()","Code013", JustWarning, msg);
+		}
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::GenerateAccepted(G4Event* anEvent, Run* run)
+{
+	// Draw rays until one is headed into the envelope. The rejected rays
+	// never reach the detector, so only the count of drawn rays is kept
+	for (G4int trial = 1; ; ++trial) {
+		G4Event candidate(anEvent->GetEventID());
+		particleGun->GeneratePrimaryVertex(&candidate);
+		
+		G4bool accepted = false;
+		for (G4int i = 0; i < candidate.GetNumberOfPrimaryVertex() && !accepted; ++i) {
+			accepted = IsAccepted(candidate.GetPrimaryVertex(i));
+		}
+		if (!accepted && trial < fMaxTrials) continue;
+		
+		if (!accepted) {
+			G4ExceptionDescription msg;
+			msg << "No source ray entered the detector envelope in " << fMaxTrials
+				<< " trials, the last ray is tracked anyway\n";
+			G4Exception("PrimaryGeneratorAction::GenerateAccepted()","Code003", JustWarning, msg);
+		}
+		for (G4int i = 0; i < candidate.GetNumberOfPrimaryVertex(); ++i) {
+			anEvent->AddPrimaryVertex(new G4PrimaryVertex(*candidate.GetPrimaryVertex(i)));
+		}
+		if (run) run->AddSourceRays(trial);
+		return;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PrimaryGeneratorAction::IsAccepted(const G4PrimaryVertex* vertex) const
+{
+	G4ThreeVector lower, upper;
+	detector->GetEnvelope(lower, upper);
+	const G4ThreeVector position = vertex->GetPosition();
+	
+	// Slab test of the forward ray against the envelope box
+	for (const G4PrimaryParticle* primary = vertex->GetPrimary(); primary; primary = primary->GetNext()) {
+		const G4ThreeVector direction = primary->GetMomentumDirection();
+		G4double tNear = 0.;
+		G4double tFar = DBL_MAX;
+		G4bool hit = true;
+		for (G4int axis = 0; axis < 3 && hit; ++axis) {
+			if (direction[axis] == 0.) {
+				hit = position[axis] >= lower[axis] && position[axis] <= upper[axis];
+				continue;
+			}
+			G4double t1 = (lower[axis] - position[axis])/direction[axis];
+			G4double t2 = (upper[axis] - position[axis])/direction[axis];
+			tNear = std::max(tNear, std::min(t1, t2));
+			tFar = std::min(tFar, std::max(t1, t2));
+			hit = tNear <= tFar;
+		}
+		if (hit) return true;
+	}
+	return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::SeedEvent(G4long eventNumber)
+{
+	// Replaces the engine and the per-event seeds set by the run manager
+	if (!fEngine || fCurrentEngineName != fEngineName) {
+		CLHEP::HepRandomEngine* engine = NewEngine(fEngineName);
+		G4Random::setTheEngine(engine);
+		delete fEngine;
+		fEngine = engine;
+		fCurrentEngineName = fEngineName;
+	}
+	
+	// Two positive 31-bit seeds, valid for every engine
+	uint64_t state = (uint64_t) fMasterSeed ^ ((uint64_t) eventNumber*0xD1B54A32D192ED03ULL);
+	long seeds[3] = { 0, 0, 0 };
+	for (G4int i = 0; i < 2; ++i) {
+		seeds[i] = (long) (SplitMix64(state) >> 33);
+		if (seeds[i] == 0) seeds[i] = 1;
+	}
+	G4Random::setTheSeeds(seeds, -1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PrimaryGeneratorAction::SampleScanEnergy(G4long eventNumber) const
+{
+	if (fScanMode == kScanList) return fScanEnergies[eventNumber % fScanEnergies.size()];
+	return fScanEnergies[0]*std::pow(fScanEnergies[1]/fScanEnergies[0], G4UniformRand());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::SetScanList(const G4String& values)
+{
+	std::vector<G4double> energies;
+	if (!ParseEnergies(values, energies)) {
+		G4ExceptionDescription msg;
+		msg << "Invalid scan list \"" << values << "\", expected positive values and an energy unit\n";
+		G4Exception("PrimaryGeneratorAction::SetScanList()","Code004", JustWarning, msg);
+		return;
+	}
+	fScanEnergies = energies;
+	fScanMode = kScanList;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::SetScanRange(const G4String& values)
+{
+	std::vector<G4double> energies;
+	if (!ParseEnergies(values, energies) || energies.size() != 2 || energies[1] < energies[0]) {
+		G4ExceptionDescription msg;
+		msg << "Invalid scan range \"" << values << "\", expected <min> <max> <unit>\n";
+		G4Exception("PrimaryGeneratorAction::SetScanRange()","Code004", JustWarning, msg);
+		return;
+	}
+	fScanEnergies = energies;
+	fScanMode = kScanRange;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::SetScanOff()
+{
+	fScanEnergies.clear();
+	fScanMode = kScanOff;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::DefineCommands()
+{
+	// Define /AdEPTCubeSat/source/ command directory using generic messenger class
+	fMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/source/", "Primary source control");
+	
+	G4GenericMessenger::Command& acceptanceCmd = fMessenger->DeclareProperty("acceptance", fAcceptance,
+		"Only track source rays headed into the box around the pressure vessel.\n"
+		"Rejected rays are redrawn and counted, the info file reports the number\n"
+		"of drawn rays and the acceptance fraction for the fluence normalization.");
+	acceptanceCmd.SetParameterName("acceptance", true);
+	acceptanceCmd.SetDefaultValue("true");
+	
+	G4GenericMessenger::Command& trialsCmd = fMessenger->DeclareProperty("maxTrials", fMaxTrials,
+		"Rays drawn per event before a ray missing the envelope is tracked anyway.");
+	trialsCmd.SetParameterName("maxTrials", false);
+	trialsCmd.SetRange("maxTrials>0");
+	
+	fMessenger->DeclareMethod("scanList", &PrimaryGeneratorAction::SetScanList,
+		"Scan the listed primary energies in one run, e.g. \"10 20 50 keV\".\n"
+		"Event n uses the (n mod N)-th energy, so every point gets the same number\n"
+		"of events. The energy is written to the primaryEnergy column and the\n"
+		"histograms hold the response per true energy bin.");
+	
+	fMessenger->DeclareMethod("scanRange", &PrimaryGeneratorAction::SetScanRange,
+		"Sample the primary energy log-uniformly in one run, e.g. \"1 1000 MeV\".");
+	
+	fMessenger->DeclareMethod("scanOff", &PrimaryGeneratorAction::SetScanOff,
+		"Use the energy distribution of the GPS again.");
+	
+	// Define /AdEPTCubeSat/random/ command directory using generic messenger class
+	fRandomMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/random/", "Per-event random number control");
+	
+	G4GenericMessenger::Command& seedCmd = fRandomMessenger->DeclareProperty("seed", fMasterSeed,
+		"Master seed of the run. The seeds of each event are derived from the\n"
+		"master seed and the event number, independent of the number of threads.");
+	seedCmd.SetParameterName("seed", false);
+	
+	G4GenericMessenger::Command& firstEventCmd = fRandomMessenger->DeclareProperty("firstEvent", fFirstEvent,
+		"Event number of the first event of the next run, written to the eventID\n"
+		"column. Shards of one run use consecutive ranges; a single event is\n"
+		"re-run with firstEvent set to its eventID and /run/beamOn 1.");
+	firstEventCmd.SetParameterName("firstEvent", false);
+	firstEventCmd.SetRange("firstEvent>=0");
+	
+	G4GenericMessenger::Command& engineCmd = fRandomMessenger->DeclareProperty("engine", fEngineName,
+		"Random engine of the event loop, see the rngbench tool for their cost.");
+	engineCmd.SetParameterName("engine", false);
+	engineCmd.SetCandidates(kEngineNames);
+}
@@ -0,0 +1,66 @@
+#include "RangeOutModel.hh"
+#include "Run.hh"
+#include "G4Electron.hh"
+#include "G4Track.hh"
+#include "G4VSolid.hh"
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4LossTableManager.hh"
+#include "G4RunManager.hh"
+
+namespace
+{
+	// Mean projected range of low-energy electrons as a fraction of their
+	// path length; only places the end of the step
+	const G4double kProjectedRangeFraction = 0.5;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RangeOutModel::RangeOutModel(const G4String& name, G4Region* envelope, G4double voxelSize)
+ : G4VFastSimulationModel(name, envelope), fVoxelSize(voxelSize)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RangeOutModel::~RangeOutModel()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool RangeOutModel::IsApplicable(const G4ParticleDefinition& particle)
+{
+	// Positrons annihilate at the end of their range
+	return &particle == G4Electron::Electron();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool RangeOutModel::ModelTrigger(const G4FastTrack& fastTrack)
+{
+	const G4Track* track = fastTrack.GetPrimaryTrack();
+	G4double range = G4LossTableManager::Instance()->GetRange(track->GetDefinition(), track->GetKineticEnergy(),
+															  track->GetMaterialCutsCouple());
+	if (range >= fVoxelSize) return false;
+	return range < fastTrack.GetEnvelopeSolid()->DistanceToOut(fastTrack.GetPrimaryTrackLocalPosition());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RangeOutModel::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep)
+{
+	const G4Track* track = fastTrack.GetPrimaryTrack();
+	G4double energy = track->GetKineticEnergy();
+	G4double range = G4LossTableManager::Instance()->GetRange(track->GetDefinition(), energy,
+															  track->GetMaterialCutsCouple());
+	
+	// In the frame of the envelope
+	fastStep.ProposePrimaryTrackFinalPosition(fastTrack.GetPrimaryTrackLocalPosition()
+											  + kProjectedRangeFraction*range*fastTrack.GetPrimaryTrackLocalDirection());
+	fastStep.ProposePrimaryTrackPathLength(range);
+	fastStep.ProposeTotalEnergyDeposited(energy);
+	fastStep.KillPrimaryTrack();
+	
+	Run* run = dynamic_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+	if (run) run->AddRangedOutElectron();
+}
@@ -0,0 +1,230 @@
+#include "RowMerger.hh"
+
+#include <chrono>
+#include <climits>
+
+RowMerger* RowMerger::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RowMerger::RowMerger(RowWriter* output, G4int numColumns, G4int eventIDColumn,
+					 G4bool ordered, G4int maxBufferedRows)
+ : fOutput(output), fNumColumns(numColumns), fEventIDColumn(eventIDColumn),
+   fOrdered(ordered), fMaxBufferedRows(maxBufferedRows > 0 ? maxBufferedRows : 1),
+   fAnnouncedBatches(false), fRowsWritten(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RowMerger::~RowMerger()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RowMerger::BeginRun(G4int numberOfWorkers, G4bool announcedBatches)
+{
+	std::lock_guard<std::mutex> lock(fMutex);
+
+	fAnnouncedBatches = announcedBatches;
+	fStreams.clear();
+	GetStream(numberOfWorkers > 0 ? numberOfWorkers - 1 : 0);
+	fRowsWritten = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RowMerger::Stream& RowMerger::GetStream(G4int workerID)
+{
+	if (workerID >= (G4int) fStreams.size()) {
+		// With announced batches a worker only holds back the merge once it
+		// has joined
+		Stream empty;
+		empty.position = 0;
+		empty.bufferedRows = 0;
+		empty.watermark = -1;
+		empty.running = !fAnnouncedBatches;
+		fStreams.resize(workerID + 1, empty);
+	}
+	return fStreams[workerID];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RowMerger::Join(G4int workerID)
+{
+	std::lock_guard<std::mutex> lock(fMutex);
+	GetStream(workerID).running = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RowMerger::Submit(G4int workerID, std::vector<G4double>& rows, G4long watermark, G4bool running)
+{
+	std::unique_lock<std::mutex> lock(fMutex);
+
+	Stream& stream = GetStream(workerID);
+	if (!rows.empty()) {
+		stream.bufferedRows += rows.size()/fNumColumns;
+		stream.blocks.push_back(std::vector<G4double>());
+		stream.blocks.back().swap(rows);
+	}
+	if (watermark > stream.watermark) stream.watermark = watermark;
+	stream.running = running;
+
+	Drain();
+	fDrained.notify_all();
+
+	// Bound the memory held for this worker. The running worker with the
+	// smallest watermark never waits, as all its rows can be written. Other
+	// workers may add streams meanwhile, so the stream is looked up again
+	while (fStreams[workerID].running && fStreams[workerID].bufferedRows > fMaxBufferedRows) {
+		fDrained.wait(lock);
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RowMerger::WriteBlocks(Stream& stream)
+{
+	while (!stream.blocks.empty()) {
+		const std::vector<G4double>& block = stream.blocks.front();
+		for (size_t row = stream.position; row < block.size()/fNumColumns; ++row) {
+			fOutput->Fill(&block[row*fNumColumns]);
+			++fRowsWritten;
+		}
+		stream.blocks.pop_front();
+		stream.position = 0;
+	}
+	stream.bufferedRows = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RowMerger::Drain()
+{
+	if (!fOrdered) {
+		for (size_t i = 0; i < fStreams.size(); ++i) WriteBlocks(fStreams[i]);
+		return;
+	}
+
+	// No running worker can still produce an event at or below this ID
+	G4long limit = LONG_MAX;
+	for (size_t i = 0; i < fStreams.size(); ++i) {
+		if (fStreams[i].running && fStreams[i].watermark < limit) limit = fStreams[i].watermark;
+	}
+
+	// k-way merge of the per-worker streams, which are each ordered by event ID
+	while (true) {
+		G4int best = -1;
+		G4long bestID = 0;
+		for (size_t i = 0; i < fStreams.size(); ++i) {
+			const Stream& stream = fStreams[i];
+			if (stream.bufferedRows == 0) continue;
+			G4long eventID = (G4long) stream.blocks.front()[stream.position*fNumColumns + fEventIDColumn];
+			if (eventID <= limit && (best < 0 || eventID < bestID)) {
+				best = i;
+				bestID = eventID;
+			}
+		}
+		if (best < 0) break;
+
+		Stream& stream = fStreams[best];
+		fOutput->Fill(&stream.blocks.front()[stream.position*fNumColumns]);
+		++fRowsWritten;
+		--stream.bufferedRows;
+		if (++stream.position*fNumColumns >= stream.blocks.front().size()) {
+			stream.blocks.pop_front();
+			stream.position = 0;
+		}
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RowMerger::EndRun()
+{
+	std::lock_guard<std::mutex> lock(fMutex);
+
+	for (size_t i = 0; i < fStreams.size(); ++i) fStreams[i].running = false;
+	Drain();
+	fOutput->Close();
+	fDrained.notify_all();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MergedRowWriter::MergedRowWriter(RowMerger* merger, G4int workerID, G4int numColumns, G4int blockSize)
+ : RowWriter(), fMerger(merger), fWorkerID(workerID), fNumColumns(numColumns),
+   fBlockSize(blockSize > 0 ? blockSize : 1), fLastEventID(-1), fEventsSinceSubmit(0), fBatchEvents(-1),
+   fClosed(false), fBlockedTime(0.)
+{
+	fBlock.reserve(fBlockSize*fNumColumns);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MergedRowWriter::~MergedRowWriter()
+{
+	Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MergedRowWriter::Fill(const double* row)
+{
+	fBlock.insert(fBlock.end(), row, row + fNumColumns);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MergedRowWriter::EventDone(long eventID)
+{
+	if (fClosed) return;
+	fLastEventID = eventID;
+
+	// The last event of an announced batch hands over the rest of the rows
+	// and leaves the merge until the next batch
+	if (fBatchEvents > 0 && --fBatchEvents == 0) {
+		Submit(false);
+		fBlock.reserve(fBlockSize*fNumColumns);
+		fEventsSinceSubmit = 0;
+		return;
+	}
+
+	// Full blocks are handed over; so are watermarks of workers that rarely
+	// produce rows, so that the ordered merge never waits long on them
+	if ((G4int) (fBlock.size()/fNumColumns) >= fBlockSize || ++fEventsSinceSubmit >= fBlockSize) {
+		Submit(true);
+		fBlock.reserve(fBlockSize*fNumColumns);
+		fEventsSinceSubmit = 0;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MergedRowWriter::BeginBatch(long events)
+{
+	// Called while no later batch can be handed out, so no other worker has
+	// gone past the first event of this one yet
+	if (fClosed || events <= 0) return;
+	fMerger->Join(fWorkerID);
+	fBatchEvents = events;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MergedRowWriter::Close()
+{
+	if (fClosed) return;
+	Submit(false);
+	fClosed = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MergedRowWriter::Submit(G4bool running)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	fMerger->Submit(fWorkerID, fBlock, fLastEventID, running);
+	fBlockedTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,58 @@
+#include "RowWriter.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CsvRowWriter::CsvRowWriter()
+ : fFile(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CsvRowWriter::~CsvRowWriter()
+{
+	Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CsvRowWriter::AddColumn(const std::string& name, bool isInteger)
+{
+	fNames.push_back(name);
+	fIsInteger.push_back(isInteger);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool CsvRowWriter::Open(const std::string& fileName)
+{
+	Close();
+	fFile = std::fopen(fileName.c_str(), "w");
+	if (!fFile) return false;
+
+	std::fprintf(fFile, "#class tools::wcsv::ntuple\n");
+	for (size_t i = 0; i < fNames.size(); ++i) {
+		std::fprintf(fFile, "#column %s %s\n", fIsInteger[i] ? "int" : "double", fNames[i].c_str());
+	}
+	return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CsvRowWriter::Fill(const double* row)
+{
+	if (!fFile) return;
+	for (size_t i = 0; i < fNames.size(); ++i) {
+		if (i > 0) std::fputc(',', fFile);
+		if (fIsInteger[i]) std::fprintf(fFile, "%ld", (long) row[i]);
+		else std::fprintf(fFile, "%.10g", row[i]);
+	}
+	std::fputc('\n', fFile);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CsvRowWriter::Close()
+{
+	if (fFile) std::fclose(fFile);
+	fFile = 0;
+}
@@ -1,31 +1,37 @@
 #include "Run.hh"
+#include "SensitiveGasSD.hh"
+#include "PrimaryGeneratorAction.hh"
 #include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
 #include "G4Run.hh"
 #include "G4SDManager.hh"
-#include "G4HCofThisEvent.hh"
-#include "G4THitsMap.hh"
+#include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4PhysicalConstants.hh"
+#include "G4Threading.hh"
 
 // Select output format for Analysis Manager
 #include "Analysis.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-Run::Run():G4Run()
+Run::Run(RowWriter* rowWriter):G4Run(), fGasBranches(0), fRowWriter(rowWriter),
+fSourceRays(0), fKilledSecondaries(0), fKilledEnergy(0.), fRangedOutElectrons(0), fSteps(0), fNeutronSplits(0), fNeutronRouletteKills(0), fCollapsedEvents(0), fMasterSeed(0), fFirstEvent(0), fStartTime(std::chrono::steady_clock::now())
 {
-	G4SDManager* SDMan = G4SDManager::GetSDMpointer(); 
-    ID_PVSensitiveGas_eDep = SDMan->GetCollectionID("PVSensitiveGas/eDep");
-    ID_PVSensitiveGas_eDep_Positron = SDMan->GetCollectionID("PVSensitiveGas/eDepP");
-	ID_PVSensitiveGas_eDep_Electron = SDMan->GetCollectionID("PVSensitiveGas/eDepE");
-	ID_PVSensitiveGas_eDep_Triton = SDMan->GetCollectionID("PVSensitiveGas/eDepT");
-	ID_PVSensitiveGas_eDep_Proton = SDMan->GetCollectionID("PVSensitiveGas/eDepPro");
-	ID_PVSensitiveGas_trackLengthPassage = SDMan->GetCollectionID("PVSensitiveGas/trackLengthPassage");
-	ID_PVSensitiveGas_secondaryElectrons = SDMan->GetCollectionID("PVSensitiveGas/secondaryElectrons");
-	ID_PVSensitiveGas_secondaryPhotons = SDMan->GetCollectionID("PVSensitiveGas/secondaryPhotons");
-	ID_PVSensitiveGas_secondaryPositrons = SDMan->GetCollectionID("PVSensitiveGas/secondaryPositrons");
-	ID_PVSensitiveGas_secondaryTritons = SDMan->GetCollectionID("PVSensitiveGas/secondaryTritons");
-	ID_PVSensitiveGas_secondaryProtons = SDMan->GetCollectionID("PVSensitiveGas/secondaryProtons");	
+	// The master has no sensitive detectors and records no events
+	SensitiveGasSD* gasSD = dynamic_cast<SensitiveGasSD*>(
+		G4SDManager::GetSDMpointer()->FindSensitiveDetector("PVSensitiveGas", false));
+	if (gasSD) fGasBranches = gasSD->GetBranches();
+	
+	// Neither has the master a primary generator
+	const PrimaryGeneratorAction* primary = dynamic_cast<const PrimaryGeneratorAction*>(
+		G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction());
+	if (primary) {
+		fMasterSeed = primary->GetMasterSeed();
+		fFirstEvent = primary->GetFirstEvent();
+		fEngineName = primary->GetEngineName();
+	}
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -37,128 +43,93 @@ Run::~Run()
 
 void Run::RecordEvent(const G4Event* event)
 { 	
-  	// Get hits collections
-  	G4HCofThisEvent* HCE = event->GetHCofThisEvent();
-  	if(!HCE) { 
-    	G4ExceptionDescription msg; 
-    	msg << "No hits collection of this event found.\n"; 
-    	G4Exception("Run::RecordEvent()","Code001", JustWarning, msg); 
-    	return; 
-  	} 
-  	
-	// Zero out the variables
-	G4double PVSensitiveGas_eDep = 0.;
-	G4double PVSensitiveGas_eDep_Positron = 0.;
-	G4double PVSensitiveGas_eDep_Electron = 0.;
-	G4double PVSensitiveGas_eDep_Triton = 0.;
-	G4double PVSensitiveGas_eDep_Proton = 0.;
-	G4double PVSensitiveGas_trackLengthPassage = 0.;
-	G4double PVSensitiveGas_secondaryElectrons = 0.;
-	G4double PVSensitiveGas_secondaryPhotons = 0.;
-	G4double PVSensitiveGas_secondaryPositrons = 0.;
-	G4double PVSensitiveGas_secondaryTritons = 0.;
-	G4double PVSensitiveGas_secondaryProtons = 0.;
-	
-	// Get the HitMaps for this event
-	G4THitsMap<G4double>* event_PVSensitiveGas_eDep = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_eDep));
-	G4THitsMap<G4double>* event_PVSensitiveGas_eDep_Positron = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_eDep_Positron));
-	G4THitsMap<G4double>* event_PVSensitiveGas_eDep_Electron = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_eDep_Electron));
-	G4THitsMap<G4double>* event_PVSensitiveGas_eDep_Triton = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_eDep_Triton));
-	G4THitsMap<G4double>* event_PVSensitiveGas_eDep_Proton = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_eDep_Proton));
-	G4THitsMap<G4double>* event_PVSensitiveGas_trackLengthPassage = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_trackLengthPassage));
-	G4THitsMap<G4double>* event_PVSensitiveGas_secondaryElectrons = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_secondaryElectrons));
-	G4THitsMap<G4double>* event_PVSensitiveGas_secondaryPhotons = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_secondaryPhotons));
-	G4THitsMap<G4double>* event_PVSensitiveGas_secondaryPositrons = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_secondaryPositrons));
-	G4THitsMap<G4double>* event_PVSensitiveGas_secondaryTritons = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_secondaryTritons));
-	G4THitsMap<G4double>* event_PVSensitiveGas_secondaryProtons = (G4THitsMap<G4double>*)(HCE->GetHC(ID_PVSensitiveGas_secondaryProtons));
-	
-	std::map<G4int,G4double*>::iterator itr;
-	
-	// Get the total energy deposited for this event in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_eDep->GetMap()->begin(); itr != event_PVSensitiveGas_eDep->GetMap()->end(); itr++) {
-		PVSensitiveGas_eDep += *(itr->second);
-	}
-	
-	// Get the positron energy deposited for this event in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_eDep_Positron->GetMap()->begin(); itr != event_PVSensitiveGas_eDep_Positron->GetMap()->end(); itr++) {
-		PVSensitiveGas_eDep_Positron += *(itr->second);
-	}
-	
-	// Get the electron energy deposited for this event in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_eDep_Electron->GetMap()->begin(); itr != event_PVSensitiveGas_eDep_Electron->GetMap()->end(); itr++) {
-		PVSensitiveGas_eDep_Electron += *(itr->second);
-	}
-	
-	// Get the triton energy deposited for this event in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_eDep_Triton->GetMap()->begin(); itr != event_PVSensitiveGas_eDep_Triton->GetMap()->end(); itr++) {
-		PVSensitiveGas_eDep_Triton += *(itr->second);
-	}
-	
-	// Get the proton energy deposited for this event in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_eDep_Proton->GetMap()->begin(); itr != event_PVSensitiveGas_eDep_Proton->GetMap()->end(); itr++) {
-		PVSensitiveGas_eDep_Proton += *(itr->second);
+	// Events aborted before generation, e.g. on a stop request, are not
+	// counted, but the merge of the rows is told they are done
+	if (event->IsAborted()) {
+		if (fRowWriter) fRowWriter->EventDone(fFirstEvent + event->GetEventID());
+		return;
 	}
 	
-	// Get the passage track length for this event in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_trackLengthPassage->GetMap()->begin(); itr != event_PVSensitiveGas_trackLengthPassage->GetMap()->end(); itr++) {
-		PVSensitiveGas_trackLengthPassage += *(itr->second);
-	} 
-
-	// Get the number of secondary electrons in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_secondaryElectrons->GetMap()->begin(); itr != event_PVSensitiveGas_secondaryElectrons->GetMap()->end(); itr++) {
-		PVSensitiveGas_secondaryElectrons += *(itr->second);
-	}
+	// True energy of the first primary, which varies per event in scan mode
+	G4double primaryEnergy = 0.;
+	const G4PrimaryVertex* vertex = event->GetPrimaryVertex();
+	if (vertex && vertex->GetPrimary()) primaryEnergy = vertex->GetPrimary()->GetKineticEnergy();
+	if (fGasBranches) fHistograms.FillPrimary(primaryEnergy);
 	
-	// Get the number of secondary photons in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_secondaryPhotons->GetMap()->begin(); itr != event_PVSensitiveGas_secondaryPhotons->GetMap()->end(); itr++) {
-		PVSensitiveGas_secondaryPhotons += *(itr->second);
+	// Nothing entered the Sensitive Gas Volume in this event
+	if (!fGasBranches || !fGasBranches->IsTouched()) {
+		if (fRowWriter) fRowWriter->EventDone(fFirstEvent + event->GetEventID());
+		G4Run::RecordEvent(event);
+		return;
 	}
 	
-	// Get the number of secondary positrons in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_secondaryPositrons->GetMap()->begin(); itr != event_PVSensitiveGas_secondaryPositrons->GetMap()->end(); itr++) {
-		PVSensitiveGas_secondaryPositrons += *(itr->second);
-	}
+	// One entry per weighted outcome, a single one without biasing
+	if (!fGasBranches->Resolve(fEntries)) ++fCollapsedEvents;
+	const G4bool branched = fEntries.size() > 1;
+	if (branched) fHistograms.BeginEvent();
 	
-	// Get the number of secondary tritons in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_secondaryTritons->GetMap()->begin(); itr != event_PVSensitiveGas_secondaryTritons->GetMap()->end(); itr++) {
-		PVSensitiveGas_secondaryTritons += *(itr->second);
-	}
-	
-	// Get the number of secondary protons in the Sensitive Gas Volume
-	for (itr = event_PVSensitiveGas_secondaryProtons->GetMap()->begin(); itr != event_PVSensitiveGas_secondaryProtons->GetMap()->end(); itr++) {
-		PVSensitiveGas_secondaryProtons += *(itr->second);
-	}
-	
-	// Record Sensitive Gas events with non-zero deposited energy
-	if (PVSensitiveGas_eDep > 0) {
-		// Get analysis manager
-  		G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
-  		
-  	// Fill ntuple
-	  	analysisManager->FillNtupleDColumn(0, PVSensitiveGas_eDep/eV);
-  		analysisManager->FillNtupleDColumn(1, PVSensitiveGas_eDep_Positron/eV);
-		analysisManager->FillNtupleDColumn(2, PVSensitiveGas_eDep_Electron/eV);
-		analysisManager->FillNtupleDColumn(3, PVSensitiveGas_eDep_Triton/eV);
-		analysisManager->FillNtupleDColumn(4, PVSensitiveGas_eDep_Proton/eV);
-  		analysisManager->FillNtupleDColumn(5, PVSensitiveGas_trackLengthPassage/mm);
-  		analysisManager->FillNtupleDColumn(6, PVSensitiveGas_secondaryElectrons);
-		analysisManager->FillNtupleDColumn(7, PVSensitiveGas_secondaryPhotons);
-		analysisManager->FillNtupleDColumn(8, PVSensitiveGas_secondaryPositrons);
-		analysisManager->FillNtupleDColumn(9, PVSensitiveGas_secondaryTritons);
-		analysisManager->FillNtupleDColumn(10, PVSensitiveGas_secondaryProtons);
-  		analysisManager->AddNtupleRow();
+	for (size_t i = 0; i < fEntries.size(); ++i) {
+		const GasEventRecord& record = fEntries[i].totals;
+		const G4double weight = fEntries[i].weight;
+		
+		// Record Sensitive Gas events with non-zero deposited energy
+		if (record.eDep <= 0) continue;
+		fHistograms.Fill(record, weight);
+		fHistograms.FillResponse(primaryEnergy, record.eDep, weight);
+		
+		if (fRowWriter) {
+			// Fill the row in the layout of Analysis::kNtupleColumns
+			G4double row[Analysis::kNumColumns];
+			row[Analysis::kEDep] = record.eDep/eV;
+			row[Analysis::kEDepPositron] = record.eDepSpecies[GasScoring::kPositron]/eV;
+			row[Analysis::kEDepElectron] = record.eDepSpecies[GasScoring::kElectron]/eV;
+			row[Analysis::kEDepTriton] = record.eDepSpecies[GasScoring::kTriton]/eV;
+			row[Analysis::kEDepProton] = record.eDepSpecies[GasScoring::kProton]/eV;
+			row[Analysis::kTrackLength] = record.trackLengthPassage/mm;
+			row[Analysis::kSecondaryElectrons] = record.nSecondaries[GasScoring::kElectron];
+			row[Analysis::kSecondaryPhotons] = record.nSecondaries[GasScoring::kPhoton];
+			row[Analysis::kSecondaryPositrons] = record.nSecondaries[GasScoring::kPositron];
+			row[Analysis::kSecondaryTritons] = record.nSecondaries[GasScoring::kTriton];
+			row[Analysis::kSecondaryProtons] = record.nSecondaries[GasScoring::kProton];
+			row[Analysis::kEventID] = fFirstEvent + event->GetEventID();
+			row[Analysis::kWeight] = weight;
+			row[Analysis::kPrimaryEnergy] = primaryEnergy/eV;
+			fRowWriter->Fill(row);
+		}
 	}
+	if (branched) fHistograms.EndEvent();
+	if (fRowWriter) fRowWriter->EventDone(fFirstEvent + event->GetEventID());
 	
 	// Invoke base class method
   	G4Run::RecordEvent(event); 
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
-// 
-// void Run::Merge(const G4Run* aRun)
-// {
-//   	const Run* localRun = static_cast<const Run*>(aRun);
-//   	
-//   	//  Invoke base class method
-//   	G4Run::Merge(aRun); 
-// } 
\ No newline at end of file
+
+void Run::Merge(const G4Run* aRun)
+{
+  	const Run* localRun = static_cast<const Run*>(aRun);
+  	fHistograms.Add(localRun->fHistograms);
+  	fSourceRays += localRun->fSourceRays;
+  	fKilledSecondaries += localRun->fKilledSecondaries;
+  	fKilledEnergy += localRun->fKilledEnergy;
+  	fRangedOutElectrons += localRun->fRangedOutElectrons;
+  	fSteps += localRun->fSteps;
+  	fNeutronSplits += localRun->fNeutronSplits;
+  	fNeutronRouletteKills += localRun->fNeutronRouletteKills;
+  	fCollapsedEvents += localRun->fCollapsedEvents;
+  	fMasterSeed = localRun->fMasterSeed;
+  	fFirstEvent = localRun->fFirstEvent;
+  	fEngineName = localRun->fEngineName;
+  	
+  	// Merge is called by the worker thread that owns the local run
+  	WorkerStats stats;
+  	stats.threadID = G4Threading::G4GetThreadId();
+  	stats.numberOfEvents = localRun->GetNumberOfEvent();
+  	stats.realTime = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - localRun->fStartTime).count();
+  	stats.outputBlocked = localRun->fRowWriter ? localRun->fRowWriter->GetBlockedTime() : 0.;
+  	fWorkerStats.push_back(stats);
+  	
+  	//  Invoke base class method
+  	G4Run::Merge(aRun); 
+}
@@ -1,33 +1,45 @@
 #include "RunAction.hh"
 #include "Run.hh"
+#include "RowMerger.hh"
+#include "AsyncRowWriter.hh"
 #include "PrimaryGeneratorAction.hh"
+#include "SteppingAction.hh"
 #include "DetectorConstruction.hh"
+#include "InitTimer.hh"
+#include "PhysicsList.hh"
 #include "G4Run.hh"
 #include "G4RunManager.hh"
 #include "G4UImanager.hh"
 #include "G4VVisManager.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4Material.hh"
+#include "G4Timer.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Threading.hh"
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#include "SchedulingRunManager.hh"
+#endif
 
 // Select output format for Analysis Manager
 #include "Analysis.hh"
 
 #include <stdio.h>
+#include <sstream>
 #include <time.h>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-RunAction::RunAction(DetectorConstruction* det, PrimaryGeneratorAction* primary):G4UserRunAction(),
-detector(det), particleGun(primary)
+RunAction::RunAction(DetectorConstruction* det, PrimaryGeneratorAction* primary, SteppingAction* stepping):G4UserRunAction(),
+detector(det), particleGun(primary), fStepping(stepping), pFile_INFO(0), fTimer(new G4Timer), fMessenger(0), fWriteNtuple(true), fCountSteps(false),
+fOutputFormat("csv"), fRowWriter(0), fMergeOutput(false), fOrderedOutput(true), fBlockSize(1000),
+fMerger(0), fMergedOutput(0), fAsyncOutput(true), fOutputDelay(0.)
 {
 	// Set printing event number per each event
   	G4RunManager::GetRunManager()->SetPrintProgress(1E5);  
   	
-	// Set starting seed for the Random Number Generator
-	long seeds[2];
-	time_t systime = time(NULL);
-	seeds[0] = (long) systime;
-	seeds[1] = (long) (systime*G4UniformRand());  
-    G4Random::setTheSeeds(seeds);
+	// Random numbers are seeded per event by the PrimaryGeneratorAction from
+	// /AdEPTCubeSat/random/seed and the event number
   	
   	// Create analysis manager 
   	// The choice of analysis technology is done via selection of an appropriate namespace
@@ -41,24 +53,25 @@ detector(det), particleGun(primary)
   	// Create ntuple 
   	// Pressure Sensitive Gas Volume
  	analysisManager->CreateNtuple("G4AdEPTCubeSat", "Edep and TrackLength");
-	analysisManager->CreateNtupleDColumn("eDep_PVSensitiveGas");
- 	analysisManager->CreateNtupleDColumn("eDep_PVSensitiveGas_Positron");
-	analysisManager->CreateNtupleDColumn("eDep_PVSensitiveGas_Electron");
-	analysisManager->CreateNtupleDColumn("eDep_PVSensitiveGas_Triton");
-	analysisManager->CreateNtupleDColumn("eDep_PVSensitiveGas_Proton");
- 	analysisManager->CreateNtupleDColumn("trackLength_PVSensitiveGas");
-	analysisManager->CreateNtupleDColumn("Secondary Electrons");
-	analysisManager->CreateNtupleDColumn("Secondary Photons");
-	analysisManager->CreateNtupleDColumn("Secondary Positrons");
-	analysisManager->CreateNtupleDColumn("Secondary Tritons");
-	analysisManager->CreateNtupleDColumn("Secondary Protons");
+ 	for (G4int i = 0; i < Analysis::kNumColumns; ++i) {
+ 		analysisManager->CreateNtupleDColumn(Analysis::kNtupleColumns[i].name);
+ 	}
  	analysisManager->FinishNtuple();
+ 	
+ 	// Define commands to control the run output
+ 	DefineCommands();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 RunAction::~RunAction()
 {
+	delete fTimer;
+	delete fMessenger;
+	delete fRowWriter;
+	delete fMerger;
+	delete fMergedOutput;
+	
 	// Delete analysis manager
 	delete G4AnalysisManager::Instance();
 }
@@ -67,7 +80,31 @@ RunAction::~RunAction()
 
 G4Run* RunAction::GenerateRun()
 { 
-	return new Run; 
+	// Per-event rows are produced by the worker threads only
+	if (IsMaster() || !fWriteNtuple) return new Run();
+	
+	// Writer of this run, following the current output settings
+	delete fRowWriter;
+	if (fMergeOutput && RowMerger::GetInstance()) {
+		fRowWriter = new MergedRowWriter(RowMerger::GetInstance(), G4Threading::G4GetThreadId(),
+										 Analysis::kNumColumns, fBlockSize);
+	} else if (fOutputFormat == "binary") {
+		ColumnarWriter* columnarWriter = new ColumnarWriter();
+		for (G4int i = 0; i < Analysis::kNumColumns; ++i) {
+			columnarWriter->AddColumn(Analysis::kNtupleColumns[i].name, Analysis::kNtupleColumns[i].type);
+		}
+		fRowWriter = WrapFileWriter(columnarWriter);
+	} else if (fAsyncOutput || fOutputDelay > 0.) {
+		// The thread-local Analysis Manager cannot be filled from another thread
+		CsvRowWriter* csvWriter = new CsvRowWriter();
+		for (G4int i = 0; i < Analysis::kNumColumns; ++i) {
+			csvWriter->AddColumn(Analysis::kNtupleColumns[i].name, Analysis::kNtupleColumns[i].type == Columnar::kInt);
+		}
+		fRowWriter = WrapFileWriter(csvWriter);
+	} else {
+		fRowWriter = new AnalysisRowWriter();
+	}
+	return new Run(fRowWriter); 
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -77,13 +114,27 @@ void RunAction::BeginOfRunAction(const G4Run* aRun)
 	// Get analysis manager
   	G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
 
-  	// Open an AnalysisManager data file for the worker threads
-  	if (!IsMaster()){
+  	// Open the per-event output of the worker threads
+  	if (!IsMaster() && fRowWriter){
 		// Filename for AnalysisManager is provided in the macro file using
-		// /analysis/setFileName command
-		analysisManager->OpenFile();
+		// /analysis/setFileName command. CSV files are named like the
+		// per-thread files of the Analysis Manager
+		std::ostringstream fileName;
+		if (fOutputFormat == "binary") {
+			fileName << analysisManager->GetFileName() << "_t" << G4Threading::G4GetThreadId() << ".aecol";
+		} else {
+			fileName << analysisManager->GetFileName() << "_nt_G4AdEPTCubeSat_t" << G4Threading::G4GetThreadId() << ".csv";
+		}
+		if (!fRowWriter->Open(fileName.str())) {
+			G4ExceptionDescription msg;
+			msg << "Cannot open the output file of thread " << G4Threading::G4GetThreadId() << "\n";
+			G4Exception("RunAction::BeginOfRunAction()","Code002", JustWarning, msg);
+		}
   	}
   	
+  	// The stepping action of the thread decides once what to do per step
+  	if (fStepping) fStepping->BeginOfRun(fCountSteps);
+  	
   	// For the master let's create an info file
   	if (IsMaster()){
 		// Get the local time at the start of the simulation
@@ -99,6 +150,56 @@ void RunAction::BeginOfRunAction(const G4Run* aRun)
 		// Export Source Information
 		outFile_INFO << "============================    Simulation Information    ============================" << G4endl;
 		outFile_INFO << "Start Time: \t\t" <<  ctime(&now);
+		
+		// Merged output file, written while the workers are running
+		if (fWriteNtuple && fMergeOutput) {
+			G4String fileName = analysisManager->GetFileName() + "_nt_G4AdEPTCubeSat";
+			if (fOutputFormat == "binary") {
+				ColumnarWriter* columnarWriter = new ColumnarWriter();
+				for (G4int i = 0; i < Analysis::kNumColumns; ++i) {
+					columnarWriter->AddColumn(Analysis::kNtupleColumns[i].name, Analysis::kNtupleColumns[i].type);
+				}
+				fMergedOutput = columnarWriter;
+				fileName += ".aecol";
+			} else {
+				CsvRowWriter* csvWriter = new CsvRowWriter();
+				for (G4int i = 0; i < Analysis::kNumColumns; ++i) {
+					csvWriter->AddColumn(Analysis::kNtupleColumns[i].name, Analysis::kNtupleColumns[i].type == Columnar::kInt);
+				}
+				fMergedOutput = csvWriter;
+				fileName += ".csv";
+			}
+			// The merge runs in the submitting worker threads, which then
+			// only hand the rows on to the writer thread
+			fMergedOutput = WrapFileWriter(fMergedOutput);
+			
+			if (fMergedOutput->Open(fileName)) {
+				// Threads of a task pool are added when they take their first
+				// batch; with announced batches the ones without a batch do
+				// not hold back the ordered merge
+				G4int numberOfWorkers = 1;
+				G4bool announcedBatches = false;
+#ifdef G4MULTITHREADED
+				G4MTRunManager* mtRunManager = G4MTRunManager::GetMasterRunManager();
+				if (mtRunManager) numberOfWorkers = mtRunManager->GetNumberOfThreads();
+				SchedulingRunManager* scheduler = dynamic_cast<SchedulingRunManager*>(mtRunManager);
+				announcedBatches = scheduler && scheduler->AnnouncesBatches();
+#endif
+				// Each worker may run ahead of the merge by a few blocks
+				fMerger = new RowMerger(fMergedOutput, Analysis::kNumColumns, Analysis::kEventID,
+										fOrderedOutput, 8*fBlockSize);
+				fMerger->BeginRun(numberOfWorkers, announcedBatches);
+				RowMerger::SetInstance(fMerger);
+			} else {
+				G4ExceptionDescription msg;
+				msg << "Cannot open merged output file " << fileName << ", no rows are written\n";
+				G4Exception("RunAction::BeginOfRunAction()","Code002", JustWarning, msg);
+				delete fMergedOutput;
+				fMergedOutput = 0;
+			}
+		}
+		
+		fTimer->Start();
   	}
   	
 }
@@ -109,12 +210,30 @@ void RunAction::EndOfRunAction(const G4Run* aRun)
 { 	
   	// Output & close analysis file 
 	G4AnalysisManager* analysisManager = G4AnalysisManager::Instance(); 
-	if (!IsMaster()){
-  		analysisManager->CloseFile(); 
+	if (!IsMaster() && fRowWriter){
+		fRowWriter->Close();
   	}
   	
   	// Append Source Information to the INFO file
   	if (IsMaster()){
+		fTimer->Stop();
+		
+		// All workers have finished, write the remaining merged rows
+		G4long mergedRows = -1;
+		if (fMerger) {
+			fMerger->EndRun();
+			mergedRows = fMerger->GetNumberOfRows();
+			RowMerger::SetInstance(0);
+			delete fMerger;
+			fMerger = 0;
+			delete fMergedOutput;
+			fMergedOutput = 0;
+		}
+		
+		// Write the merged run histograms
+		const Run* run = static_cast<const Run*>(aRun);
+		run->GetHistograms().Write(analysisManager->GetFileName() + "_hist.csv");
+		
 		// Open the Information File
 		std::ofstream outFile_INFO(outputFile_INFO,std::ios::out|std::ios::app);
 		
@@ -125,8 +244,77 @@ void RunAction::EndOfRunAction(const G4Run* aRun)
     	outFile_INFO << "End Time: \t\t\t" <<  ctime(&now);
 		outFile_INFO << "============================    Source Information    ============================" << G4endl;
 		outFile_INFO <<  "Number of Events: \t" << aRun->GetNumberOfEvent() << G4endl;	
-		//outFile_INFO << "============================    Detector Information    ============================" << G4endl;
-		//outFile_INFO <<  "Number of Ionizations: \t" << detector->GetDetectorAngle()/degree << " deg" << G4endl;	
+		if (aRun->GetNumberOfEvent() < aRun->GetNumberOfEventToBeProcessed()) {
+			outFile_INFO <<  "Interrupted after: \t" << aRun->GetNumberOfEvent() << " of "
+						 << aRun->GetNumberOfEventToBeProcessed() << " events" << G4endl;
+		}
+		// Differs from the number of events with /AdEPTCubeSat/source/acceptance
+		if (run->GetNumberOfSourceRays() > aRun->GetNumberOfEvent()) {
+			outFile_INFO <<  "Source Rays: \t\t" << run->GetNumberOfSourceRays() << G4endl;
+			outFile_INFO <<  "Acceptance: \t\t" << (G4double) aRun->GetNumberOfEvent()/run->GetNumberOfSourceRays() << G4endl;
+		}
+		if (run->GetNumberOfKilledSecondaries() > 0) {
+			outFile_INFO <<  "Killed Secondaries: \t" << run->GetNumberOfKilledSecondaries() << " ("
+						 << run->GetKilledEnergy()/MeV << " MeV)" << G4endl;
+		}
+		if (run->GetNumberOfRangedOutElectrons() > 0) {
+			outFile_INFO <<  "Ranged Out Electrons: \t" << run->GetNumberOfRangedOutElectrons() << G4endl;
+		}
+		if (run->GetNumberOfNeutronSplits() > 0 || run->GetNumberOfNeutronRouletteKills() > 0) {
+			outFile_INFO <<  "Neutron Splits: \t\t" << run->GetNumberOfNeutronSplits() << G4endl;
+			outFile_INFO <<  "Neutron Roulette Kills: \t" << run->GetNumberOfNeutronRouletteKills() << G4endl;
+		}
+		// Biased events with too many outcomes, scored as one entry at the mean weight
+		if (run->GetNumberOfCollapsedEvents() > 0) {
+			outFile_INFO <<  "Collapsed Events: \t" << run->GetNumberOfCollapsedEvents() << G4endl;
+		}
+		if (!run->GetEngineName().empty()) {
+			outFile_INFO <<  "Random Engine: \t\t" << run->GetEngineName() << G4endl;
+			outFile_INFO <<  "Master Seed: \t\t" << run->GetMasterSeed() << G4endl;
+			outFile_INFO <<  "First Event: \t\t" << run->GetFirstEvent() << G4endl;
+		}
+		if (mergedRows >= 0) {
+			outFile_INFO <<  "Merged Rows: \t\t" << mergedRows << (fOrderedOutput ? " (ordered by eventID)" : "") << G4endl;
+		}
+		outFile_INFO << "============================    Performance Information    ============================" << G4endl;
+		outFile_INFO <<  "Run Time: \t\t\t" << fTimer->GetRealElapsed() << " s" << G4endl;
+		if (fTimer->GetRealElapsed() > 0.) {
+			outFile_INFO <<  "Events per Second: \t" << aRun->GetNumberOfEvent()/fTimer->GetRealElapsed() << G4endl;
+		}
+		if (aRun->GetNumberOfEvent() > 0) {
+			if (fCountSteps) {
+				outFile_INFO <<  "Steps per Event: \t" << (G4double) run->GetNumberOfSteps()/aRun->GetNumberOfEvent() << G4endl;
+			}
+			// All threads of the process
+			outFile_INFO <<  "CPU per Event: \t\t" << 1000.*(fTimer->GetUserElapsed() + fTimer->GetSystemElapsed())/aRun->GetNumberOfEvent()
+						 << " ms" << G4endl;
+		}
+		if (fOutputDelay > 0.) {
+			outFile_INFO <<  "Output Delay: \t\t" << fOutputDelay/microsecond << " us per row" << G4endl;
+		}
+		G4double resident, peak;
+		if (InitTimer::GetResidentMemory(resident, peak)) {
+			outFile_INFO <<  "Peak Resident Memory: \t" << peak << " MB" << G4endl;
+		}
+		const PhysicsList* physicsList =
+			dynamic_cast<const PhysicsList*>(G4RunManager::GetRunManager()->GetUserPhysicsList());
+		if (physicsList) {
+			outFile_INFO <<  "Physics: \t\t\t" << physicsList->GetPhysicsDescription() << G4endl;
+			outFile_INFO <<  "Production Cuts: \t" << physicsList->GetCutsDescription() << G4endl;
+		}
+		const std::vector<Run::WorkerStats>& workerStats = run->GetWorkerStats();
+		for (size_t i = 0; i < workerStats.size(); ++i) {
+			const Run::WorkerStats& stats = workerStats[i];
+			outFile_INFO <<  "Thread " << stats.threadID << ": \t\t" << stats.numberOfEvents << " events";
+			if (stats.realTime > 0.) outFile_INFO << ", " << stats.numberOfEvents/stats.realTime << " events/s";
+			outFile_INFO << ", " << stats.outputBlocked << " s waiting on output"
+						 << (fAsyncOutput ? " (async)" : "") << G4endl;
+		}
+		outFile_INFO << "============================    Detector Information    ============================" << G4endl;
+		outFile_INFO <<  "Detector Angle: \t" << detector->GetDetectorAngle()/degree << " deg" << G4endl;	
+		const G4Material* gas = detector->GetGasMaterial();
+		outFile_INFO <<  "Gas: \t\t\t\t" << gas->GetName() << ", " << gas->GetPressure()/atmosphere << " atm, "
+					 << gas->GetTemperature()/kelvin << " K, " << gas->GetDensity()/(g/cm3) << " g/cm3" << G4endl;
 		outFile_INFO << "==================================================================================" << G4endl; 
 		
 		//Close file
@@ -135,3 +323,67 @@ void RunAction::EndOfRunAction(const G4Run* aRun)
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::DefineCommands()
+{
+	// Define /AdEPTCubeSat/output/ command directory using generic messenger class
+	fMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/output/", "Run output control");
+	
+	G4GenericMessenger::Command& ntupleCmd = fMessenger->DeclareProperty("ntuple", fWriteNtuple,
+		"Write one ntuple row per event with energy deposited in the sensitive gas.\n"
+		"When false only the merged run histograms are written.");
+	ntupleCmd.SetParameterName("writeNtuple", true);
+	ntupleCmd.SetDefaultValue("true");
+	
+	G4GenericMessenger::Command& stepsCmd = fMessenger->DeclareProperty("countSteps", fCountSteps,
+		"Count the steps of all tracks and write the steps per event to the info file.\n"
+		"Costs a little time per step, so it is off by default.");
+	stepsCmd.SetParameterName("countSteps", true);
+	stepsCmd.SetDefaultValue("true");
+	
+	G4GenericMessenger::Command& formatCmd = fMessenger->DeclareProperty("format", fOutputFormat,
+		"Per-event output format: csv (Analysis Manager ntuple) or binary\n"
+		"(self-describing columnar file <fileName>_t<thread>.aecol, see columnar2csv).");
+	formatCmd.SetParameterName("format", false);
+	formatCmd.SetCandidates("csv binary");
+	
+	G4GenericMessenger::Command& mergeCmd = fMessenger->DeclareProperty("merge", fMergeOutput,
+		"Merge the rows of all worker threads on the master into one file per run,\n"
+		"<fileName>_nt_G4AdEPTCubeSat.csv or .aecol, instead of one file per thread.");
+	mergeCmd.SetParameterName("merge", true);
+	mergeCmd.SetDefaultValue("true");
+	
+	G4GenericMessenger::Command& orderedCmd = fMessenger->DeclareProperty("ordered", fOrderedOutput,
+		"Write the merged rows in increasing eventID order, independent of the number of threads.");
+	orderedCmd.SetParameterName("ordered", true);
+	orderedCmd.SetDefaultValue("true");
+	
+	G4GenericMessenger::Command& blockSizeCmd = fMessenger->DeclareProperty("blockSize", fBlockSize,
+		"Rows (or events) per block handed from a worker to the merge. Each worker\n"
+		"buffers at most eight blocks before it waits for the merge to catch up.");
+	blockSizeCmd.SetParameterName("blockSize", false);
+	blockSizeCmd.SetRange("blockSize>0");
+	
+	G4GenericMessenger::Command& asyncCmd = fMessenger->DeclareProperty("async", fAsyncOutput,
+		"Write the output files from a dedicated thread, so that event processing\n"
+		"only waits on the output when the writer falls more than a few blocks behind.\n"
+		"CSV rows are then written without the Analysis Manager, to the same file names.");
+	asyncCmd.SetParameterName("async", true);
+	asyncCmd.SetDefaultValue("true");
+	
+	G4GenericMessenger::Command& delayCmd = fMessenger->DeclarePropertyWithUnit("delay", "us", fOutputDelay,
+		"Delay per written row, emulating a slow output device for benchmarks.");
+	delayCmd.SetParameterName("delay", false);
+	delayCmd.SetRange("delay>=0");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RowWriter* RunAction::WrapFileWriter(RowWriter* fileWriter) const
+{
+	if (fOutputDelay > 0.) fileWriter = new ThrottledRowWriter(fileWriter, fOutputDelay/s);
+	if (fAsyncOutput) fileWriter = new AsyncRowWriter(fileWriter, Analysis::kNumColumns);
+	return fileWriter;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,167 @@
+#ifdef G4MULTITHREADED
+
+#include "SchedulingRunManager.hh"
+#include "Run.hh"
+#include "RowWriter.hh"
+#include "G4GenericMessenger.hh"
+#include "G4AutoLock.hh"
+#include "G4RunManager.hh"
+#include "G4Event.hh"
+
+namespace
+{
+	G4Mutex gBatchMutex = G4MUTEX_INITIALIZER;
+
+	// Batch in progress on this worker thread
+	G4ThreadLocal G4double tBatchStart = 0.;
+	G4ThreadLocal G4long tBatchEvents = 0;
+	G4ThreadLocal G4int tBatchRun = -1;
+
+	G4double Seconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+	{
+		return std::chrono::duration<double>(to - from).count();
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SchedulingRunManager::SchedulingRunManager()
+ : SchedulingRunManagerBase(), fMessenger(0), fAdaptive(true), fTargetBatchTime(0.2),
+   fRunCount(0), fBatches(0), fEventsInRun(0)
+{
+	// Define commands to control the scheduling
+	DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SchedulingRunManager::~SchedulingRunManager()
+{
+	delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SchedulingRunManager::InitializeEventLoop(G4int n_event, const char* macroFile, G4int n_select)
+{
+	fPolicy.SetTargetBatchTime(fTargetBatchTime);
+	fPolicy.BeginRun(n_event, GetNumberOfThreads());
+	++fRunCount;
+	fBatches = 0;
+	fEventsInRun = n_event;
+	fRunStart = std::chrono::steady_clock::now();
+
+	#if G4VERSION_NUMBER >= 1100
+	// Enough tasks to occupy every thread of the pool; the events of a task
+	// are fetched in batches through SetUpNEvents
+	if (fAdaptive) SetGrainsize((G4int) fPolicy.NumberOfTasks(n_event));
+	#endif
+
+	SchedulingRunManagerBase::InitializeEventLoop(n_event, macroFile, n_select);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SchedulingRunManager::RunTermination()
+{
+	SchedulingRunManagerBase::RunTermination();
+
+	if (fAdaptive && verboseLevel > 0) {
+		G4cout << "Scheduled " << fEventsInRun << " events";
+		if (fBatches > 0) G4cout << " in " << fBatches << " batches";
+		G4cout << ", " << fPolicy.GetEventCost()*1e6 << " us per event and thread" << G4endl;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#if G4VERSION_NUMBER >= 1010
+G4int SchedulingRunManager::SetUpNEvents(G4Event* evt, G4SeedsQueue* seedsQueue, G4bool reseedRequired)
+{
+	G4AutoLock lock(&gBatchMutex);
+	G4double now = EndBatch();
+	if (fAdaptive) PlanBatch();
+	G4int events = SchedulingRunManagerBase::SetUpNEvents(evt, seedsQueue, reseedRequired);
+	StartBatch(now, events);
+	return events;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SchedulingRunManager::SetUpAnEvent(G4Event* evt, G4long& s1, G4long& s2, G4long& s3, G4bool reseedRequired)
+{
+	G4AutoLock lock(&gBatchMutex);
+	G4double now = EndBatch();
+	G4bool event = SchedulingRunManagerBase::SetUpAnEvent(evt, s1, s2, s3, reseedRequired);
+	StartBatch(now, event ? 1 : 0);
+	return event;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double SchedulingRunManager::EndBatch()
+{
+	// The previous batch of this thread is done now
+	G4double now = Seconds(fRunStart, std::chrono::steady_clock::now());
+	if (tBatchRun == fRunCount && tBatchEvents > 0) fPolicy.AddSample(now - tBatchStart, tBatchEvents);
+	return now;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SchedulingRunManager::PlanBatch()
+{
+	// The base class hands out eventModulo events, numberOfEventsPerTask with
+	// the task manager, or the rest of the run
+	G4long batch = fPolicy.NextBatch(numberOfEventToBeProcessed - numberOfEventProcessed);
+	if (batch > 0) {
+		eventModulo = (G4int) batch;
+		#if G4VERSION_NUMBER >= 1100
+		numberOfEventsPerTask = (G4int) batch;
+		#endif
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SchedulingRunManager::StartBatch(G4double now, G4int events)
+{
+	tBatchStart = now;
+	tBatchEvents = events;
+	tBatchRun = fRunCount;
+	if (events > 0) ++fBatches;
+
+	// The workers ask for their next batch with SetUpAnEvent while
+	// eventModulo is 1, so it follows the policy after every batch
+	if (fAdaptive) PlanBatch();
+
+	// The row writer of the thread learns of the batch before any later one
+	// is handed out (see RowMerger)
+	Run* run = dynamic_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+	if (run && run->GetRowWriter()) run->GetRowWriter()->BeginBatch(events);
+}
+#endif
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SchedulingRunManager::DefineCommands()
+{
+	// Define /AdEPTCubeSat/scheduler/ command directory using generic messenger class
+	fMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/scheduler/", "Event scheduling of the worker threads");
+
+	G4GenericMessenger::Command& adaptiveCmd = fMessenger->DeclareProperty("adaptive", fAdaptive,
+		"Size every event batch from the cost measured in the run (default true).\n"
+		"If false, /run/eventModulo and the default number of tasks apply.");
+	adaptiveCmd.SetParameterName("adaptive", true);
+	adaptiveCmd.SetDefaultValue("true");
+
+	G4GenericMessenger::Command& batchTimeCmd = fMessenger->DeclareProperty("batchTime", fTargetBatchTime,
+		"Wall time in seconds a batch of events should take on one thread.\n"
+		"Batches are smaller towards the end of a run.");
+	batchTimeCmd.SetParameterName("batchTime", false);
+	batchTimeCmd.SetRange("batchTime>0");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
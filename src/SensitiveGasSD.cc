@@ -0,0 +1,88 @@
+#include "SensitiveGasSD.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+
+SensitiveGasSD::SensitiveGasSD(const G4String& name)
+ : G4VSensitiveDetector(name), fCurrentTrackID(-1), fCurrentTrackLength(0.)
+{
+	// Resolve the scored species once so that each step only compares pointers
+	G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
+	for (G4int i = 0; i < GasScoring::kNumSpecies; ++i) {
+		fSpecies[i] = particleTable->FindParticle(GasScoring::kSpeciesTable[i].particleName);
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SensitiveGasSD::~SensitiveGasSD()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SensitiveGasSD::Initialize(G4HCofThisEvent*)
+{
+	fBranches.Reset();
+
+	fCurrentTrackID = -1;
+	fCurrentTrackLength = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int SensitiveGasSD::FindSpecies(const G4ParticleDefinition* particle) const
+{
+	for (G4int i = 0; i < GasScoring::kNumSpecies; ++i) {
+		if (fSpecies[i] == particle) return i;
+	}
+	return -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool SensitiveGasSD::ProcessHits(G4Step* aStep, G4TouchableHistory*)
+{
+	G4double edep = aStep->GetTotalEnergyDeposit();
+	G4double stepLength = aStep->GetStepLength();
+
+	// Same early-out as G4MultiFunctionalDetector
+	if (stepLength == 0. && edep == 0.) return false;
+
+	G4Track* track = aStep->GetTrack();
+	G4StepPoint* preStepPoint = aStep->GetPreStepPoint();
+	G4int species = FindSpecies(track->GetDefinition());
+	// A weight change in this step, e.g. a forced interaction, applies to its deposits
+	GasEventRecord& record = fBranches.GetTotals(fBranches.Follow(aStep));
+	record.touched = true;
+
+	// Energy deposit, unweighted; the weight is that of the branch
+	if (edep > 0.) {
+		record.eDep += edep;
+		if (species >= 0 && GasScoring::kSpeciesTable[species].scoreEDep) {
+			record.eDepSpecies[species] += edep;
+		}
+	}
+
+	// Track length of tracks that enter and leave the volume (unweighted, as G4PSPassageTrackLength)
+	G4bool isEnter = (preStepPoint->GetStepStatus() == fGeomBoundary);
+	G4bool isExit = (aStep->GetPostStepPoint()->GetStepStatus() == fGeomBoundary);
+	G4int trackID = track->GetTrackID();
+	if (isEnter && isExit) {
+		record.trackLengthPassage += stepLength;
+	} else if (isEnter) {
+		fCurrentTrackID = trackID;
+		fCurrentTrackLength = stepLength;
+	} else if (fCurrentTrackID == trackID) {
+		fCurrentTrackLength += stepLength;
+		if (isExit) record.trackLengthPassage += fCurrentTrackLength;
+	}
+
+	// Secondaries created in the volume (unweighted multiplicity)
+	if (species >= 0 && GasScoring::kSpeciesTable[species].scoreSecondaries
+		&& track->GetCurrentStepNumber() == 1 && track->GetParentID() != 0) {
+		record.nSecondaries[species] += 1.;
+	}
+
+	return true;
+}
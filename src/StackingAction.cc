@@ -0,0 +1,134 @@
+#include "StackingAction.hh"
+#include "DetectorConstruction.hh"
+#include "Run.hh"
+#include "G4Track.hh"
+#include "G4Electron.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4Region.hh"
+#include "G4MaterialCutsCouple.hh"
+#include "G4LossTableManager.hh"
+#include "G4Navigator.hh"
+#include "G4TransportationManager.hh"
+#include "G4RunManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StackingAction::StackingAction(DetectorConstruction* det)
+ : G4UserStackingAction(), detector(det), fMessenger(0), fKillWallSecondaries(false),
+   fMaxEnergy(1.*MeV), fMargin(0.1*mm), fNavigator(new G4Navigator()), fRun(0), fHaveSensitiveFrame(false)
+{
+	DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StackingAction::~StackingAction()
+{
+	delete fMessenger;
+	delete fNavigator;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingAction::PrepareNewEvent()
+{
+	fRun = dynamic_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+	if (!fKillWallSecondaries) return;
+	
+	// The geometry may have been modified or rebuilt between runs
+	G4VPhysicalVolume* world =
+		G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume();
+	if (world != fNavigator->GetWorldVolume()) fNavigator->SetWorldVolume(world);
+	fHaveSensitiveFrame = world && FindSensitiveFrame(world->GetLogicalVolume(), G4RotationMatrix(), G4ThreeVector());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StackingAction::FindSensitiveFrame(const G4LogicalVolume* mother, const G4RotationMatrix& rotation,
+										  const G4ThreeVector& translation)
+{
+	for (G4int i = 0; i < (G4int) mother->GetNoDaughters(); ++i) {
+		const G4VPhysicalVolume* daughter = mother->GetDaughter(i);
+		
+		// local = R^-1 (mother - t) for the object rotation R and translation t
+		G4RotationMatrix inverse = daughter->GetObjectRotationValue().inverse();
+		G4RotationMatrix localRotation = inverse*rotation;
+		G4ThreeVector localTranslation = inverse*(translation - daughter->GetObjectTranslation());
+		
+		if (daughter->GetLogicalVolume() == detector->GetSensitiveGasLogical()) {
+			fSensitiveRotation = localRotation;
+			fSensitiveTranslation = localTranslation;
+			return true;
+		}
+		if (FindSensitiveFrame(daughter->GetLogicalVolume(), localRotation, localTranslation)) return true;
+	}
+	return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+	if (!fKillWallSecondaries || track->GetParentID() == 0) return fUrgent;
+	
+	const G4ParticleDefinition* electron = G4Electron::Electron();
+	const G4double energy = track->GetKineticEnergy();
+	if (track->GetDefinition() != electron || energy > fMaxEnergy) return fUrgent;
+	
+	const G4ThreeVector position = track->GetPosition();
+	const G4VPhysicalVolume* volume = fNavigator->LocateGlobalPointAndSetup(position, 0, false, true);
+	if (!volume) return fUrgent;
+	
+	const G4LogicalVolume* logical = volume->GetLogicalVolume();
+	const G4LogicalVolume* sensitive = detector->GetSensitiveGasLogical();
+	if (logical == sensitive) return fUrgent;
+	
+	// Cannot leave the volume it is born in
+	G4LossTableManager* lossTables = G4LossTableManager::Instance();
+	G4bool kill = false;
+	if (logical->GetMaterialCutsCouple()) {
+		G4double range = lossTables->GetRange(electron, energy, logical->GetMaterialCutsCouple());
+		kill = range < fNavigator->ComputeSafety(position) - fMargin;
+	}
+	
+	// Cannot reach the sensitive volume through the gas, the least dense
+	// material of the region; the path leaves the region only into the vessel
+	const G4LogicalVolume* gas = detector->GetGasLogical();
+	if (!kill && fHaveSensitiveFrame && logical->GetRegion() == gas->GetRegion() && gas->GetMaterialCutsCouple()) {
+		G4double range = lossTables->GetRange(electron, energy, gas->GetMaterialCutsCouple());
+		G4ThreeVector local = fSensitiveRotation*position + fSensitiveTranslation;
+		kill = range < sensitive->GetSolid()->DistanceToIn(local) - fMargin;
+	}
+	
+	if (!kill) return fUrgent;
+	if (fRun) fRun->AddKilledSecondary(energy);
+	return fKill;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingAction::DefineCommands()
+{
+	fMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/stacking/", "Secondary track control");
+	
+	G4GenericMessenger::Command& killCmd = fMessenger->DeclareProperty("killWallSecondaries", fKillWallSecondaries,
+		"Kill secondary electrons at birth whose range cannot take them out of\n"
+		"their volume or, in the gas region, into the Sensitive Gas Volume.");
+	killCmd.SetParameterName("kill", true);
+	killCmd.SetDefaultValue("true");
+	
+	G4GenericMessenger::Command& energyCmd = fMessenger->DeclarePropertyWithUnit("maxEnergy", "MeV", fMaxEnergy,
+		"Only electrons up to this energy are killed, which bounds the energy of\n"
+		"the bremsstrahlung photons that are not produced.");
+	energyCmd.SetParameterName("energy", false);
+	energyCmd.SetRange("energy>0.");
+	
+	G4GenericMessenger::Command& marginCmd = fMessenger->DeclarePropertyWithUnit("margin", "mm", fMargin,
+		"Subtracted from the safety and the distance to the sensitive volume.");
+	marginCmd.SetParameterName("margin", false);
+	marginCmd.SetRange("margin>=0.");
+}
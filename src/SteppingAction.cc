@@ -0,0 +1,170 @@
+#include "SteppingAction.hh"
+#include "Run.hh"
+#include "SensitiveGasSD.hh"
+#include "PhysicsList.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4Neutron.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4SteppingManager.hh"
+#include "G4RunManager.hh"
+#include "G4SDManager.hh"
+#include "G4GenericMessenger.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SteppingAction::SteppingAction()
+ : G4UserSteppingAction(), fMessenger(0), fRun(0), fBranches(0), fCountSteps(false), fFollowBranches(false), fWeightWindows(false), fWindowLower(0.25), fWindowRatio(4.), fMaxSplit(16)
+{
+	// Importance rises towards the Sensitive Gas Volume
+	fImportance["SensitiveGas"] = 4.;
+	fImportance["PressureVesselGas"] = 2.;
+	
+	DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SteppingAction::~SteppingAction()
+{
+	delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double SteppingAction::GetImportance(const G4String& volumeName) const
+{
+	std::map<G4String, G4double>::const_iterator it = fImportance.find(volumeName);
+	return it != fImportance.end() ? it->second : 1.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::BeginOfRun(G4bool countSteps)
+{
+	G4RunManager* runManager = G4RunManager::GetRunManager();
+	fRun = dynamic_cast<Run*>(runManager->GetNonConstCurrentRun());
+	SensitiveGasSD* gasSD = dynamic_cast<SensitiveGasSD*>(
+		G4SDManager::GetSDMpointer()->FindSensitiveDetector("PVSensitiveGas", false));
+	fBranches = gasSD ? gasSD->GetBranches() : 0;
+	
+	// Without biasing every track keeps weight 1 and the event one branch
+	const PhysicsList* physicsList = dynamic_cast<const PhysicsList*>(runManager->GetUserPhysicsList());
+	G4bool biased = fWeightWindows || (physicsList && (physicsList->IsGammaBiased() || physicsList->IsNeutronBiased()));
+	fFollowBranches = biased && fBranches != 0;
+	fCountSteps = countSteps && fRun != 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::UserSteppingAction(const G4Step* step)
+{
+	if (fCountSteps) fRun->AddStep();
+	
+	// Weight changes and secondaries of the step go to the branches of the event
+	if (fFollowBranches) fBranches->Follow(step);
+	
+	if (!fWeightWindows) return;
+	
+	G4Track* track = step->GetTrack();
+	if (track->GetDefinition() != G4Neutron::Neutron() || track->GetTrackStatus() != fAlive) return;
+	
+	const G4StepPoint* postStepPoint = step->GetPostStepPoint();
+	const G4VPhysicalVolume* volume = postStepPoint->GetPhysicalVolume();
+	if (!volume) return;
+	
+	const G4double lower = fWindowLower/GetImportance(volume->GetLogicalVolume()->GetName());
+	const G4double upper = fWindowRatio*lower;
+	const G4double weight = track->GetWeight();
+	if (weight >= lower && weight <= upper) return;
+	
+	if (weight < lower) {
+		// Russian roulette, survivors continue with the survival weight
+		const G4double survival = std::sqrt(fWindowRatio)*lower;
+		if (G4UniformRand()*survival < weight) {
+			track->SetWeight(survival);
+			if (fBranches) fBranches->Reweight(track);
+		} else {
+			track->SetTrackStatus(fStopAndKill);
+			if (fRun) fRun->AddNeutronRouletteKill();
+		}
+		return;
+	}
+	
+	// Split into copies inside the window, which continue from the same point
+	// as alternative branches of the event
+	const G4int copies = std::min((G4int) std::ceil(weight/upper), fMaxSplit);
+	const G4double share = weight/copies;
+	track->SetWeight(share);
+	G4TrackVector* secondaries = fpSteppingManager->GetfSecondary();
+	fCopies.clear();
+	for (G4int i = 1; i < copies; ++i) {
+		G4Track* copy = new G4Track(new G4DynamicParticle(*track->GetDynamicParticle()),
+									track->GetGlobalTime(), track->GetPosition());
+		copy->SetWeight(share);
+		copy->SetTouchableHandle(postStepPoint->GetTouchableHandle());
+		copy->SetParentID(track->GetTrackID());
+		copy->SetCreatorProcess(track->GetCreatorProcess());
+		secondaries->push_back(copy);
+		fCopies.push_back(copy);
+	}
+	if (fBranches) fBranches->Split(track, fCopies);
+	if (fRun) fRun->AddNeutronSplits(copies - 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::SetImportance(const G4String& value)
+{
+	std::istringstream input(value);
+	G4String name;
+	G4double importance = 0.;
+	if (!(input >> name >> importance) || importance <= 0.) {
+		G4ExceptionDescription msg;
+		msg << "Expected \"<logical volume> <importance>\" with a positive importance, got \""
+			<< value << "\". Importances unchanged.";
+		G4Exception("SteppingAction::SetImportance()","Code011", JustWarning, msg);
+		return;
+	}
+	fImportance[name] = importance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::DefineCommands()
+{
+	fMessenger = new G4GenericMessenger(this, "/AdEPTCubeSat/neutronBias/", "Neutron weight windows");
+	
+	G4GenericMessenger::Command& windowsCmd = fMessenger->DeclareProperty("windows", fWeightWindows,
+		"Split neutrons above and play Russian roulette with neutrons below the\n"
+		"weight window of their volume. Meant for /AdEPTCubeSat/physics/biasNeutron.");
+	windowsCmd.SetParameterName("windows", true);
+	windowsCmd.SetDefaultValue("true");
+	
+	G4GenericMessenger::Command& importanceCmd = fMessenger->DeclareMethod("importance", &SteppingAction::SetImportance,
+		"Importance of a logical volume, e.g. \"SensitiveGas 4\". The window of a\n"
+		"volume is [lower/importance, ratio*lower/importance], volumes without\n"
+		"an importance have importance 1.");
+	importanceCmd.SetParameterName("volumeImportance", false);
+	
+	G4GenericMessenger::Command& lowerCmd = fMessenger->DeclareProperty("windowLower", fWindowLower,
+		"Lower weight bound at importance 1.");
+	lowerCmd.SetParameterName("lower", false);
+	lowerCmd.SetRange("lower>0.");
+	
+	G4GenericMessenger::Command& ratioCmd = fMessenger->DeclareProperty("windowRatio", fWindowRatio,
+		"Ratio of the upper to the lower weight bound.");
+	ratioCmd.SetParameterName("ratio", false);
+	ratioCmd.SetRange("ratio>1.");
+	
+	G4GenericMessenger::Command& splitCmd = fMessenger->DeclareProperty("maxSplit", fMaxSplit,
+		"Maximum number of copies a neutron is split into at once.");
+	splitCmd.SetParameterName("copies", false);
+	splitCmd.SetRange("copies>=2");
+}
@@ -0,0 +1,190 @@
+// ********************************************************************
+// SimulationHarness.hh
+//
+// Description: Shared by the tools that run the simulation executable
+//				given on their command line (rangeoutbench, hpbench,
+//				physbench, physab, cutscan): writing the macro of a run,
+//				running it with its output in <name>.log, reading the
+//				"<key>: <value>" lines of the info file or the log and
+//				the histograms of <name>_hist.csv, and the distances
+//				between two spectra.
+//
+// ********************************************************************
+
+#ifndef SimulationHarness_h
+#define SimulationHarness_h 1
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace SimulationHarness
+{
+	// Bin of a histogram of <name>_hist.csv; bin 0 is the underflow and
+	// the last bin the overflow
+	struct Bin
+	{
+		double low;
+		double high;
+		double sumw;
+		double sumw2;
+	};
+
+	typedef std::map<std::string, std::vector<Bin> > Histograms;
+
+	// Values of "<key>: <value>" lines by key, without leading blanks
+	typedef std::map<std::string, std::string> KeyValues;
+
+	// Timing and memory of the initialization report
+	struct StartUp
+	{
+		double initialize;		// s of /run/initialize
+		double tables;			// s of the physics tables
+		double resident;		// MB
+		double peak;			// MB
+	};
+
+	// The same events for every run of a comparison
+	const char* const kSeededSample = "/AdEPTCubeSat/random/seed 12345\n/AdEPTCubeSat/random/firstEvent 0\n";
+
+	//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+	// /gps commands of primaries of one energy from the centre of the
+	// sensitive gas
+	inline std::string PointSource(const std::string& particle, double energy, const std::string& unit, bool isotropic)
+	{
+		std::ostringstream commands;
+		commands << "/gps/particle " << particle << "\n/gps/pos/type Point\n/gps/pos/centre 0. 0. 0. mm\n";
+		if (isotropic) commands << "/gps/ang/type iso\n";
+		commands << "/gps/ene/type Mono\n/gps/ene/mono " << energy << " " << unit << "\n";
+		return commands.str();
+	}
+
+	// Writes <name>.mac without ntuple output: the commands before and after
+	// /run/initialize, then the events
+	inline std::string WriteMacro(const std::string& name, const std::string& preInit, const std::string& postInit, long events)
+	{
+		std::string macro = name + ".mac";
+		std::ofstream out(macro.c_str());
+		out << "/control/verbose 0\n/run/verbose 0\n/tracking/verbose 0\n"
+			<< preInit
+			<< "/AdEPTCubeSat/output/ntuple false\n"
+			<< "/analysis/setFileName " << name << "\n"
+			<< "/run/initialize\n"
+			<< postInit
+			<< "/run/beamOn " << events << "\n";
+		return macro;
+	}
+
+	// Command running a macro with its output in <name>.log
+	inline std::string SimulationCommand(const std::string& executable, const std::string& name, const std::string& macro)
+	{
+		return executable + " " + macro + " > " + name + ".log 2>&1";
+	}
+
+	inline bool RunSimulation(const std::string& executable, const std::string& name, const std::string& macro)
+	{
+		return std::system(SimulationCommand(executable, name, macro).c_str()) == 0;
+	}
+
+	//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+	// Later lines of the same key replace earlier ones
+	inline bool ReadKeyValues(const std::string& fileName, KeyValues& values)
+	{
+		values.clear();
+		std::ifstream in(fileName.c_str());
+		if (!in) return false;
+		std::string line;
+		while (std::getline(in, line)) {
+			std::string::size_type colon = line.find(':');
+			if (colon == std::string::npos) continue;
+			std::string::size_type value = line.find_first_not_of(" \t", colon + 1);
+			values[line.substr(0, colon)] = value == std::string::npos ? "" : line.substr(value);
+		}
+		return true;
+	}
+
+	// Leading number of a value, zero if the key is missing
+	inline double Number(const KeyValues& values, const std::string& key)
+	{
+		KeyValues::const_iterator it = values.find(key);
+		return it != values.end() ? std::atof(it->second.c_str()) : 0.;
+	}
+
+	// False without the time of the physics tables, i.e. when the
+	// initialization did not finish
+	inline bool ReadStartUp(const KeyValues& values, StartUp& startUp)
+	{
+		startUp.initialize = Number(values, "/run/initialize");
+		startUp.tables = Number(values, "Physics tables");
+		startUp.resident = Number(values, "Resident memory");
+		startUp.peak = 0.;
+		KeyValues::const_iterator memory = values.find("Resident memory");
+		if (memory != values.end()) {
+			std::string::size_type peak = memory->second.find("(peak");
+			if (peak != std::string::npos) startUp.peak = std::atof(memory->second.c_str() + peak + 5);
+		}
+		return values.count("Physics tables") > 0;
+	}
+
+	inline bool ReadHistograms(const std::string& fileName, Histograms& histograms)
+	{
+		histograms.clear();
+		std::ifstream hist(fileName.c_str());
+		std::string line;
+		if (!std::getline(hist, line)) return false;
+		while (std::getline(hist, line)) {
+			std::istringstream fields(line);
+			std::string histogram, field;
+			std::vector<double> values;
+			std::getline(fields, histogram, ',');
+			while (std::getline(fields, field, ',')) values.push_back(std::atof(field.c_str()));
+			if (values.size() != 5) continue;
+			Bin bin = { values[1], values[2], values[3], values[4] };
+			histograms[histogram].push_back(bin);
+		}
+		return !histograms.empty();
+	}
+
+	//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+	// Chi-square per bin of two spectra of the same number of events
+	inline double ChiSquarePerBin(const std::vector<Bin>& a, const std::vector<Bin>& b)
+	{
+		double chi2 = 0.;
+		int bins = 0;
+		for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+			double variance = a[i].sumw2 + b[i].sumw2;
+			if (variance <= 0.) continue;
+			chi2 += (a[i].sumw - b[i].sumw)*(a[i].sumw - b[i].sumw)/variance;
+			++bins;
+		}
+		return bins > 0 ? chi2/bins : 0.;
+	}
+
+	// Largest difference of the normalised cumulative spectra
+	inline double KolmogorovDistance(const std::vector<Bin>& a, const std::vector<Bin>& b)
+	{
+		double totalA = 0., totalB = 0.;
+		for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+			totalA += a[i].sumw;
+			totalB += b[i].sumw;
+		}
+		if (totalA <= 0. || totalB <= 0.) return 1.;
+		double cumulativeA = 0., cumulativeB = 0., distance = 0.;
+		for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+			cumulativeA += a[i].sumw/totalA;
+			cumulativeB += b[i].sumw/totalB;
+			distance = std::max(distance, std::fabs(cumulativeA - cumulativeB));
+		}
+		return distance;
+	}
+}
+
+#endif
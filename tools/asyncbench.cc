@@ -0,0 +1,103 @@
+// ********************************************************************
+// asyncbench.cc
+//
+// Description: Measures how the event rate of one producing thread depends
+//				on the latency of the output device. Synthetic events are
+//				written through a throttled ColumnarWriter, once directly
+//				and once through an AsyncRowWriter.
+//
+// Usage:		asyncbench [events] [work per event, us] [delay per row, us] [output.aecol]
+//
+// ********************************************************************
+
+#include "AsyncRowWriter.hh"
+#include "ColumnarFile.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+	const size_t kNumColumns = 12;
+
+	// Busy loop standing in for the tracking of one event
+	double Work(double microseconds, double seed)
+	{
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now()
+			+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::micro>(microseconds));
+		double x = seed;
+		while (std::chrono::steady_clock::now() < end) {
+			for (int i = 0; i < 100; ++i) x = x*1.0000001 + 1e-9;
+		}
+		return x;
+	}
+
+	RowWriter* MakeDevice(double delayPerRow)
+	{
+		ColumnarWriter* columnarWriter = new ColumnarWriter();
+		for (size_t i = 0; i < kNumColumns; ++i) {
+			columnarWriter->AddColumn("c" + std::to_string(i), i + 1 == kNumColumns ? Columnar::kInt : Columnar::kDouble);
+		}
+		return new ThrottledRowWriter(columnarWriter, delayPerRow);
+	}
+
+	// Events per second of the producing thread, including the final flush
+	double Measure(RowWriter* writer, const std::string& fileName, long events, double work, double& blocked)
+	{
+		if (!writer->Open(fileName)) {
+			std::cerr << "Cannot write " << fileName << std::endl;
+			std::exit(1);
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double row[kNumColumns];
+		for (long event = 0; event < events; ++event) {
+			double value = Work(work, event);
+			for (size_t i = 0; i < kNumColumns; ++i) row[i] = value + i;
+			row[kNumColumns - 1] = event;
+			writer->Fill(row);
+			writer->EventDone(event);
+		}
+		writer->Close();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		blocked = writer->GetBlockedTime();
+		return seconds > 0. ? events/seconds : 0.;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc > 5) {
+		std::cerr << "Usage: " << argv[0] << " [events] [work per event, us] [delay per row, us] [output.aecol]" << std::endl;
+		return 1;
+	}
+	long events = argc > 1 ? std::atol(argv[1]) : 20000;
+	double work = argc > 2 ? std::atof(argv[2]) : 50.;
+	double delay = argc > 3 ? std::atof(argv[3]) : 40.;
+	std::string fileName = argc > 4 ? argv[4] : "asyncbench.aecol";
+
+	std::cout << "Events: " << events << "  work/event: " << work << " us  delay/row: " << delay << " us" << std::endl;
+
+	const double delays[] = { 0., delay };
+	for (size_t i = 0; i < 2; ++i) {
+		double blocked = 0.;
+
+		RowWriter* syncWriter = MakeDevice(delays[i]*1e-6);
+		double syncRate = Measure(syncWriter, fileName, events, work, blocked);
+		delete syncWriter;
+		std::printf("  delay %8.1f us  sync   %10.0f events/s  blocked %7.3f s\n", delays[i], syncRate, blocked);
+
+		RowWriter* asyncWriter = new AsyncRowWriter(MakeDevice(delays[i]*1e-6), kNumColumns);
+		double asyncRate = Measure(asyncWriter, fileName, events, work, blocked);
+		delete asyncWriter;
+		std::printf("  delay %8.1f us  async  %10.0f events/s  blocked %7.3f s\n", delays[i], asyncRate, blocked);
+	}
+	std::remove(fileName.c_str());
+	return 0;
+}
@@ -0,0 +1,90 @@
+// ********************************************************************
+// columnar2csv.cc
+//
+// Description: Converts a binary columnar output file (.aecol) written by
+//				AdEPTCubeSat back to CSV, or prints its schema and chunk index
+//
+// Usage:		columnar2csv <input.aecol> [output.csv]
+//				columnar2csv --info <input.aecol>
+//
+// ********************************************************************
+
+#include "ColumnarFile.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc < 2 || argc > 3) {
+		std::cerr << "Usage: " << argv[0] << " <input.aecol> [output.csv]" << std::endl;
+		std::cerr << "       " << argv[0] << " --info <input.aecol>" << std::endl;
+		return 1;
+	}
+
+	bool infoOnly = (std::strcmp(argv[1], "--info") == 0);
+	if (infoOnly && argc != 3) {
+		std::cerr << "Usage: " << argv[0] << " --info <input.aecol>" << std::endl;
+		return 1;
+	}
+	std::string inputName = infoOnly ? argv[2] : argv[1];
+
+	ColumnarReader reader;
+	if (!reader.Open(inputName)) {
+		std::cerr << "Cannot read columnar file " << inputName << std::endl;
+		return 1;
+	}
+	const std::vector<Columnar::Column>& columns = reader.GetColumns();
+
+	// Print the schema and the chunk index
+	if (infoOnly) {
+		static const char* typeNames[] = { "float", "double", "int" };
+		std::cout << "Rows: " << reader.GetNumberOfRows() << "  Chunks: " << reader.GetChunks().size() << std::endl;
+		for (size_t i = 0; i < columns.size(); ++i) {
+			std::cout << "  " << i << "  " << typeNames[columns[i].type] << "  " << columns[i].name << std::endl;
+		}
+		for (size_t i = 0; i < reader.GetChunks().size(); ++i) {
+			const Columnar::ChunkInfo& chunk = reader.GetChunks()[i];
+			std::cout << "  chunk " << i << "  offset " << chunk.offset << "  rows " << chunk.rows
+					  << "  bytes " << chunk.bytes << std::endl;
+		}
+		return 0;
+	}
+
+	FILE* out = (argc == 3) ? std::fopen(argv[2], "w") : stdout;
+	if (!out) {
+		std::cerr << "Cannot write " << argv[2] << std::endl;
+		return 1;
+	}
+
+	// Same header comments as the g4csv ntuple output
+	std::fprintf(out, "#class tools::wcsv::ntuple\n");
+	for (size_t i = 0; i < columns.size(); ++i) {
+		std::fprintf(out, "#column %s %s\n", columns[i].type == Columnar::kInt ? "int" : "double", columns[i].name.c_str());
+	}
+
+	std::vector< std::vector<double> > values;
+	for (size_t chunk = 0; chunk < reader.GetChunks().size(); ++chunk) {
+		if (!reader.ReadChunk(chunk, values)) {
+			std::cerr << "Corrupt chunk " << chunk << " in " << inputName << std::endl;
+			return 1;
+		}
+		size_t rows = values.empty() ? 0 : values[0].size();
+		for (size_t row = 0; row < rows; ++row) {
+			for (size_t i = 0; i < columns.size(); ++i) {
+				if (i > 0) std::fputc(',', out);
+				if (columns[i].type == Columnar::kInt) std::fprintf(out, "%d", (int) values[i][row]);
+				else std::fprintf(out, "%.17g", values[i][row]);
+			}
+			std::fputc('\n', out);
+		}
+	}
+
+	if (out != stdout) std::fclose(out);
+	return 0;
+}
@@ -0,0 +1,219 @@
+// ********************************************************************
+// cutscan.cc
+//
+// Description: Production cut scan. Runs the same seeded event sample
+//				with the smallest cut of every region (the reference),
+//				then with each larger cut of one region at a time, and
+//				last with the largest accepted cut of every region. Prints
+//				the CPU time per event against the Kolmogorov-Smirnov
+//				distance of the gas deposit spectrum and the largest
+//				relative shift of the mean secondary counts, and recommends
+//				the fastest cuts within both tolerances.
+//
+// Usage:		cutscan <AdEPTCubeSat> <source macro> <events> <KS tolerance> <secondaries tolerance>
+//						<region>=<cut mm>[,<cut mm>...] [...]
+//				e.g. cutscan ./AdEPTCubeSat source.mac 20000 0.01 0.05 default=0.05,0.205,0.5
+//						Region_Sensitive_Gas=1,5,10 Region_PV_Gas=1,10,50
+//
+//				"default" is /run/setCut, other names are regions of
+//				/AdEPTCubeSat/physics/regionCut. The source macro holds the
+//				/gps commands of the sample.
+//
+// ********************************************************************
+
+#include "SimulationHarness.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace SimulationHarness;
+
+namespace
+{
+	struct Result
+	{
+		double cpuPerEvent;		// ms
+		Histograms histograms;
+	};
+
+	struct Region
+	{
+		std::string name;
+		std::vector<double> cuts;		// mm, ascending
+	};
+
+	std::string Describe(const std::vector<Region>& regions, const std::vector<double>& cuts)
+	{
+		std::ostringstream description;
+		for (size_t i = 0; i < regions.size(); ++i) description << (i ? " " : "") << regions[i].name << "=" << cuts[i];
+		return description.str();
+	}
+
+	std::string WriteCutMacro(const std::string& name, const std::string& source, long events,
+							  const std::vector<Region>& regions, const std::vector<double>& cuts)
+	{
+		std::ostringstream postInit;
+		postInit << "/control/execute " << source << "\n";
+		// After the source macro, which may set cuts of its own
+		for (size_t i = 0; i < regions.size(); ++i) {
+			if (regions[i].name == "default") postInit << "/run/setCut " << cuts[i] << " mm\n";
+			else postInit << "/AdEPTCubeSat/physics/regionCut " << regions[i].name << " " << cuts[i] << " mm\n";
+		}
+		return WriteMacro(name, kSeededSample, postInit.str(), events);
+	}
+
+	bool ReadResult(const std::string& name, Result& result)
+	{
+		KeyValues info;
+		ReadKeyValues(name + ".info", info);
+		result.cpuPerEvent = Number(info, "CPU per Event");
+		return ReadHistograms(name + "_hist.csv", result.histograms)
+			   && result.cpuPerEvent > 0. && result.histograms.count("eDep_PVSensitiveGas");
+	}
+
+	// Mean count of a multiplicity histogram, bin i >= 1 holds i-1 secondaries
+	double MeanCount(const std::vector<Bin>& bins)
+	{
+		double sum = 0., sumw = 0.;
+		for (size_t i = 1; i < bins.size(); ++i) {
+			sum += (i - 1)*bins[i].sumw;
+			sumw += bins[i].sumw;
+		}
+		return sumw > 0. ? sum/sumw : 0.;
+	}
+
+	// Largest relative shift of the mean secondary counts
+	double SecondariesShift(const Result& reference, const Result& result)
+	{
+		double shift = 0.;
+		Histograms::const_iterator it;
+		for (it = reference.histograms.begin(); it != reference.histograms.end(); ++it) {
+			if (it->first.compare(0, 12, "secondaries_") != 0) continue;
+			double mean = MeanCount(it->second);
+			Histograms::const_iterator other = result.histograms.find(it->first);
+			if (mean <= 0. || other == result.histograms.end()) continue;
+			shift = std::max(shift, std::fabs(MeanCount(other->second) - mean)/mean);
+		}
+		return shift;
+	}
+
+	struct Point
+	{
+		std::string description;
+		std::vector<double> cuts;
+		double cpuPerEvent;
+		double distance;
+		double shift;
+		bool accepted;
+	};
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc < 7) {
+		std::cerr << "Usage: " << argv[0] << " <AdEPTCubeSat> <source macro> <events> <KS tolerance> "
+				  << "<secondaries tolerance> <region>=<cut mm>[,<cut mm>...] [...]" << std::endl;
+		return 1;
+	}
+	const char* executable = argv[1];
+	std::string source = argv[2];
+	long events = std::atol(argv[3]);
+	double distanceTolerance = std::atof(argv[4]);
+	double shiftTolerance = std::atof(argv[5]);
+
+	std::vector<Region> regions;
+	for (int i = 6; i < argc; ++i) {
+		std::string argument = argv[i];
+		std::string::size_type equals = argument.find('=');
+		if (equals == std::string::npos || equals == 0) {
+			std::cerr << "Expected <region>=<cut mm>[,<cut mm>...], got " << argument << std::endl;
+			return 1;
+		}
+		Region region;
+		region.name = argument.substr(0, equals);
+		std::istringstream values(argument.substr(equals + 1));
+		std::string value;
+		while (std::getline(values, value, ',')) {
+			if (std::atof(value.c_str()) > 0.) region.cuts.push_back(std::atof(value.c_str()));
+		}
+		if (region.cuts.empty()) {
+			std::cerr << "No positive cuts for " << region.name << std::endl;
+			return 1;
+		}
+		std::sort(region.cuts.begin(), region.cuts.end());
+		regions.push_back(region);
+	}
+
+	// Reference with the smallest cuts, then one region at a time
+	std::vector< std::vector<double> > scan;
+	std::vector<double> smallest;
+	for (size_t r = 0; r < regions.size(); ++r) smallest.push_back(regions[r].cuts.front());
+	scan.push_back(smallest);
+	for (size_t r = 0; r < regions.size(); ++r) {
+		for (size_t c = 1; c < regions[r].cuts.size(); ++c) {
+			std::vector<double> cuts = smallest;
+			cuts[r] = regions[r].cuts[c];
+			scan.push_back(cuts);
+		}
+	}
+
+	Result reference;
+	std::vector<Point> points;
+	for (size_t s = 0; s <= scan.size(); ++s) {
+		std::vector<double> cuts;
+		if (s < scan.size()) {
+			cuts = scan[s];
+		} else {
+			// Largest accepted cut of every region together
+			cuts = smallest;
+			for (size_t p = 1; p < points.size(); ++p) {
+				if (!points[p].accepted) continue;
+				for (size_t r = 0; r < regions.size(); ++r) cuts[r] = std::max(cuts[r], points[p].cuts[r]);
+			}
+			bool single = false;
+			for (size_t p = 0; p < points.size(); ++p) single = single || points[p].cuts == cuts;
+			if (single) break;
+		}
+
+		std::ostringstream name;
+		name << "cutscan_" << s;
+		std::string macro = WriteCutMacro(name.str(), source, events, regions, cuts);
+		Result result;
+		if (!RunSimulation(executable, name.str(), macro) || !ReadResult(name.str(), result)) {
+			std::cerr << "Cannot run " << Describe(regions, cuts) << ", see " << name.str() << ".log" << std::endl;
+			return 1;
+		}
+		if (s == 0) reference = result;
+
+		Point point;
+		point.description = Describe(regions, cuts);
+		point.cuts = cuts;
+		point.cpuPerEvent = result.cpuPerEvent;
+		point.distance = KolmogorovDistance(reference.histograms["eDep_PVSensitiveGas"], result.histograms["eDep_PVSensitiveGas"]);
+		point.shift = SecondariesShift(reference, result);
+		point.accepted = point.distance <= distanceTolerance && point.shift <= shiftTolerance;
+		points.push_back(point);
+	}
+
+	std::printf("Events: %ld from %s, same seeds for every point; tolerances KS %g, secondaries %g\n",
+				events, source.c_str(), distanceTolerance, shiftTolerance);
+	std::printf("%-60s %12s %10s %10s %12s %9s\n", "cuts (mm)", "CPU ms/ev", "speed-up", "KS", "secondaries", "accepted");
+	size_t best = 0;
+	for (size_t p = 0; p < points.size(); ++p) {
+		std::printf("%-60s %12.3f %10.2f %10.4f %11.1f%% %9s\n", points[p].description.c_str(), points[p].cpuPerEvent,
+					points[0].cpuPerEvent/points[p].cpuPerEvent, points[p].distance, 100.*points[p].shift,
+					points[p].accepted ? "yes" : "no");
+		if (points[p].accepted && points[p].cpuPerEvent < points[best].cpuPerEvent) best = p;
+	}
+	std::printf("Recommended: %s (%.3f ms/event, %.2fx the reference)\n", points[best].description.c_str(),
+				points[best].cpuPerEvent, points[0].cpuPerEvent/points[best].cpuPerEvent);
+	return 0;
+}
@@ -0,0 +1,141 @@
+// ********************************************************************
+// hpbench.cc
+//
+// Description: Start-up cost of the NeutronHP data with and without
+//				/AdEPTCubeSat/physics/hpImage. Initializes the simulation
+//				and runs one neutron, reading G4NDL directly, installing the
+//				image (cold), with the installed image (warm) and with
+//				several processes at once on the installed image, and
+//				prints the initialization times and resident memory
+//				reported by each process.
+//
+// Usage:		hpbench <AdEPTCubeSat> <image> [processes] [install directory]
+//
+// ********************************************************************
+
+#include "SimulationHarness.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace SimulationHarness;
+
+namespace
+{
+	// The physics tables load the HP data
+	struct Result
+	{
+		StartUp startUp;
+		double image;			// s to install or check the image
+	};
+
+	std::string WriteImageMacro(const std::string& name, const std::string& image, const std::string& directory)
+	{
+		std::string preInit;
+		if (!image.empty()) {
+			preInit = "/AdEPTCubeSat/physics/hpImageDir " + directory + "\n"
+					  + "/AdEPTCubeSat/physics/hpImage " + image + "\n";
+		}
+		return WriteMacro(name, preInit, PointSource("neutron", 1., "MeV", false), 1);
+	}
+
+	// Lines "<key>:   <value> ..." of the initialization report
+	bool ReadResult(const std::string& name, Result& result)
+	{
+		KeyValues log;
+		ReadKeyValues(name + ".log", log);
+		result.image = Number(log, "HP data image");
+		return ReadStartUp(log, result.startUp);
+	}
+
+	// Starts the processes at once and waits for all of them
+	bool RunSimulations(const char* executable, const std::vector<std::string>& names, const std::string& image,
+						const std::string& directory, std::vector<Result>& results)
+	{
+		std::vector<FILE*> pipes;
+		for (size_t i = 0; i < names.size(); ++i) {
+			std::string macro = WriteImageMacro(names[i], image, directory);
+			pipes.push_back(popen(SimulationCommand(executable, names[i], macro).c_str(), "r"));
+		}
+		bool ok = true;
+		results.resize(names.size());
+		for (size_t i = 0; i < names.size(); ++i) {
+			if (!pipes[i] || pclose(pipes[i]) != 0) ok = false;
+			if (ok && !ReadResult(names[i], results[i])) ok = false;
+		}
+		return ok;
+	}
+
+	void Print(const char* mode, const std::vector<Result>& results)
+	{
+		Result mean = { { 0., 0., 0., 0. }, 0. };
+		for (size_t i = 0; i < results.size(); ++i) {
+			mean.startUp.initialize += results[i].startUp.initialize/results.size();
+			mean.startUp.tables += results[i].startUp.tables/results.size();
+			mean.startUp.resident += results[i].startUp.resident/results.size();
+			mean.startUp.peak += results[i].startUp.peak/results.size();
+			mean.image += results[i].image/results.size();
+		}
+		std::printf("%-16s %10lu %10.3f %10.3f %10.3f %12.1f %12.1f\n", mode, (unsigned long) results.size(),
+					mean.image, mean.startUp.initialize, mean.startUp.tables, mean.startUp.resident, mean.startUp.peak);
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc < 3 || argc > 5) {
+		std::cerr << "Usage: " << argv[0] << " <AdEPTCubeSat> <image> [processes] [install directory]" << std::endl;
+		return 1;
+	}
+	int processes = argc > 3 ? std::atoi(argv[3]) : 4;
+	std::ostringstream defaultDirectory;
+	defaultDirectory << "/dev/shm/hpbench" << getpid();
+	std::string directory = argc > 4 ? argv[4] : defaultDirectory.str();
+
+	// A fresh install directory makes the first image run cold
+	std::string command = "rm -rf " + directory + " && mkdir -p " + directory;
+	if (std::system(command.c_str()) != 0) {
+		std::cerr << "Cannot create " << directory << std::endl;
+		return 1;
+	}
+
+	std::vector<Result> direct, cold, warm, shared;
+	std::vector<std::string> names(1, "hpbench_direct");
+	bool ok = RunSimulations(argv[1], names, "", directory, direct);
+	names[0] = "hpbench_cold";
+	ok = ok && RunSimulations(argv[1], names, argv[2], directory, cold);
+	names[0] = "hpbench_warm";
+	ok = ok && RunSimulations(argv[1], names, argv[2], directory, warm);
+	names.clear();
+	for (int i = 0; i < processes; ++i) {
+		std::ostringstream name;
+		name << "hpbench_shared" << i;
+		names.push_back(name.str());
+	}
+	ok = ok && RunSimulations(argv[1], names, argv[2], directory, shared);
+
+	command = "rm -rf " + directory;
+	if (std::system(command.c_str()) != 0) std::cerr << "Cannot remove " << directory << std::endl;
+	if (!ok) {
+		std::cerr << "Cannot run " << argv[1] << ", see the hpbench_*.log files" << std::endl;
+		return 1;
+	}
+
+	// Times of the first run include reading G4NDL into the page cache
+	// unless it was read before
+	std::printf("%-16s %10s %10s %10s %10s %12s %12s\n", "HP data", "processes", "image s",
+				"init s", "tables s", "resident MB", "peak MB");
+	Print("G4NDL", direct);
+	Print("image, cold", cold);
+	Print("image, warm", warm);
+	Print("image, shared", shared);
+	return 0;
+}
@@ -0,0 +1,64 @@
+// ********************************************************************
+// hppack.cc
+//
+// Description: Packs the NeutronHP data (G4NDL) of a set of elements into
+//				a single image for /AdEPTCubeSat/physics/hpImage, without
+//				Geant4. /AdEPTCubeSat/physics/hpPack does the same for the
+//				elements of the materials of the simulation.
+//
+// Usage:		hppack <G4NDL directory> <image> <Z> [Z ...]
+//				hppack --info <image>
+//
+// ********************************************************************
+
+#include "HPDataImage.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc == 3 && std::strcmp(argv[1], "--info") == 0) {
+		HPDataImage image;
+		if (!image.Open(argv[2])) {
+			std::cerr << image.GetError() << std::endl;
+			return 1;
+		}
+		std::printf("%s: %lu files, %.1f MB\n", argv[2], (unsigned long) image.GetNumberOfFiles(),
+					image.GetDataSize()/1048576.);
+		return 0;
+	}
+	if (argc < 4) {
+		std::cerr << "Usage: " << argv[0] << " <G4NDL directory> <image> <Z> [Z ...]" << std::endl;
+		std::cerr << "       " << argv[0] << " --info <image>" << std::endl;
+		return 1;
+	}
+
+	std::set<int> elements;
+	for (int i = 3; i < argc; ++i) {
+		int Z = std::atoi(argv[i]);
+		if (Z < 1) {
+			std::cerr << "Invalid Z: " << argv[i] << std::endl;
+			return 1;
+		}
+		elements.insert(Z);
+	}
+
+	std::string error;
+	if (!HPDataImage::Pack(argv[1], elements, argv[2], error)) {
+		std::cerr << "Cannot pack " << argv[2] << ": " << error << std::endl;
+		return 1;
+	}
+	HPDataImage image;
+	if (image.Open(argv[2])) {
+		std::printf("%s: %lu files, %.1f MB\n", argv[2], (unsigned long) image.GetNumberOfFiles(),
+					image.GetDataSize()/1048576.);
+	}
+	return 0;
+}
@@ -0,0 +1,232 @@
+// ********************************************************************
+// mergetest.cc
+//
+// Description: Ordered merge of the worker rows (RowMerger) under a task
+//				pool with more threads than tasks, as with the Geant4 11
+//				task run manager. Batches of events are handed out in
+//				increasing order under one lock and announced to the row
+//				writer of the thread, as SchedulingRunManager does; pool
+//				threads without a task only close their writer once all
+//				tasks are done, as in their end of run action. Each case
+//				must finish within the time limit with every row written
+//				once and ordered by event ID. Exits with 1 on a failure.
+//
+// Usage:		mergetest [threads] [tasks] [events]
+//
+// ********************************************************************
+
+#include "RowMerger.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const int kNumColumns = 3;		// eventID, row of the event, value
+	const int kBlockSize = 4;
+	const double kTimeLimit = 60.;	// s
+
+	// A few events leave no row, others several
+	int RowsOfEvent(long eventID)
+	{
+		return (int) ((eventID*7919) % 4);
+	}
+
+	// Output of the merge, filled under the lock of the merger
+	class CollectingWriter : public RowWriter
+	{
+		public:
+			virtual bool Open(const std::string&) { return true; }
+			virtual void Fill(const double* row) { rows.insert(rows.end(), row, row + kNumColumns); }
+			virtual void Close() {}
+
+			std::vector<double> rows;
+	};
+
+	// Master side: batches of random size in increasing event order
+	class Scheduler
+	{
+		public:
+			Scheduler(long events, long maxBatch) : fNext(0), fEvents(events), fEngine(12345), fBatch(1, maxBatch) {}
+
+			long NextBatch(MergedRowWriter& writer, long& first)
+			{
+				std::lock_guard<std::mutex> lock(fMutex);
+				long events = std::min(fBatch(fEngine), fEvents - fNext);
+				first = fNext;
+				fNext += events;
+				writer.BeginBatch(events);
+				return events;
+			}
+
+		private:
+			std::mutex fMutex;
+			long fNext;
+			long fEvents;
+			std::mt19937 fEngine;
+			std::uniform_int_distribution<long> fBatch;
+	};
+
+	struct Case
+	{
+		const char* name;
+		long maxBatch;
+		bool singleBatchTasks;	// A task takes one batch, else it takes batches until none are left
+		bool stop;				// The first thread with a task stops in its second batch
+	};
+
+	struct Result
+	{
+		bool passed;
+		long rows;
+	};
+
+	Result RunCase(const Case& test, int threads, int tasks, long events)
+	{
+		CollectingWriter output;
+		RowMerger merger(&output, kNumColumns, 0, true, 8*kBlockSize);
+		merger.BeginRun(1, true);
+		Scheduler scheduler(events, test.maxBatch);
+
+		std::atomic<int> tasksLeft(tasks);
+		std::atomic<long> expectedRows(0);
+		std::atomic<bool> stopped(false);
+		std::mutex poolMutex;
+		std::condition_variable poolDone;
+		int tasksDone = 0;
+
+		std::vector<std::thread> pool;
+		for (int t = 0; t < threads; ++t) {
+			pool.push_back(std::thread([&, t]() {
+				MergedRowWriter writer(&merger, t, kNumColumns, kBlockSize);
+				std::mt19937 engine(t);
+				std::uniform_int_distribution<int> work(0, 200);
+				bool stopping = false;
+				int batches = 0;
+				while (!stopping && tasksLeft.fetch_sub(1) > 0) {
+					// One task
+					long first = 0;
+					long batch = 0;
+					while (!stopping && (batch = scheduler.NextBatch(writer, first)) > 0) {
+						++batches;
+						for (long eventID = first; eventID < first + batch; ++eventID) {
+							if (test.stop && batches == 2 && eventID > first && !stopped.exchange(true)) {
+								writer.Stop();
+								stopping = true;
+								break;
+							}
+							const int spins = work(engine);
+							for (int i = 0; i < spins; ++i) std::this_thread::yield();
+							for (int row = 0; row < RowsOfEvent(eventID); ++row) {
+								double values[kNumColumns] = { (double) eventID, (double) row, 0.5*eventID };
+								writer.Fill(values);
+							}
+							expectedRows += RowsOfEvent(eventID);
+							writer.EventDone(eventID);
+						}
+						if (test.singleBatchTasks) break;
+					}
+					std::lock_guard<std::mutex> lock(poolMutex);
+					++tasksDone;
+					poolDone.notify_all();
+				}
+
+				// End of run action of the thread, after all tasks
+				{
+					std::unique_lock<std::mutex> lock(poolMutex);
+					poolDone.wait(lock, [&]() { return tasksDone == tasks; });
+				}
+				writer.Close();
+			}));
+		}
+		for (size_t t = 0; t < pool.size(); ++t) pool[t].join();
+		merger.EndRun();
+
+		// Every row once, ordered by event ID
+		Result result;
+		result.rows = output.rows.size()/kNumColumns;
+		result.passed = result.rows == expectedRows.load() && result.rows == merger.GetNumberOfRows();
+		long eventID = -1;
+		int row = 0;
+		for (long i = 0; i < result.rows && result.passed; ++i) {
+			const double* values = &output.rows[i*kNumColumns];
+			if ((long) values[0] != eventID) {
+				result.passed = (long) values[0] > eventID && (eventID < 0 || row == RowsOfEvent(eventID));
+				eventID = (long) values[0];
+				row = 0;
+			}
+			result.passed = result.passed && (int) values[1] == row++;
+		}
+		result.passed = result.passed && (eventID < 0 || row == RowsOfEvent(eventID));
+		return result;
+	}
+
+	// Runs a case on another thread so that a deadlock fails the test
+	bool RunWithTimeLimit(const Case& test, int threads, int tasks, long events)
+	{
+		std::mutex mutex;
+		std::condition_variable finished;
+		bool done = false;
+		Result result;
+		std::thread runner([&]() {
+			Result caseResult = RunCase(test, threads, tasks, events);
+			std::lock_guard<std::mutex> lock(mutex);
+			result = caseResult;
+			done = true;
+			finished.notify_all();
+		});
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!finished.wait_for(lock, std::chrono::duration<double>(kTimeLimit), [&]() { return done; })) {
+			std::printf("  %-34s FAILED, no progress after %.0f s\n", test.name, kTimeLimit);
+			std::fflush(stdout);
+			std::_Exit(1);
+		}
+		lock.unlock();
+		runner.join();
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("  %-34s %s, %ld rows in %.2f s\n", test.name, result.passed ? "passed" : "FAILED", result.rows, seconds);
+		return result.passed;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc > 4) {
+		std::cerr << "Usage: " << argv[0] << " [threads] [tasks] [events]" << std::endl;
+		return 1;
+	}
+	int threads = argc > 1 ? std::atoi(argv[1]) : 8;
+	int tasks = argc > 2 ? std::atoi(argv[2]) : 2;
+	long events = argc > 3 ? std::atol(argv[3]) : 20000;
+	if (threads < 1 || tasks < 1 || events < 1) {
+		std::cerr << "Threads, tasks and events must be positive" << std::endl;
+		return 1;
+	}
+
+	const Case cases[] = {
+		{ "tasks take batches until the end",	50,			false,	false },
+		{ "one batch per task",					events,		true,	false },
+		{ "stop request in a batch",			50,			false,	true }
+	};
+
+	std::printf("Ordered merge with %d pool threads, %d tasks and %ld events\n", threads, tasks, events);
+	bool passed = true;
+	for (size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); ++i) {
+		passed = RunWithTimeLimit(cases[i], threads, tasks, events) && passed;
+	}
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+// ********************************************************************
+// navbench.cc
+//
+// Description: Navigation cost of the pressure vessel representations
+//				selectable with /AdEPTCubeSat/vessel. Rays from the faces
+//				of the World towards the vessel are tracked with a
+//				G4Navigator through the full detector geometry; the time
+//				per geometry step, the track length in every material and
+//				the mass of the vessel with its contents are reported.
+//				Equal track lengths show that both representations hold
+//				the same material in the same places.
+//
+// Usage:		navbench compare [rays]		both models, one process each
+//				navbench <boolean|boxes> [rays]
+//
+// ********************************************************************
+
+#include "DetectorConstruction.hh"
+
+#include "G4GeometryManager.hh"
+#include "G4Navigator.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4Material.hh"
+#include "G4Box.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+
+namespace
+{
+	struct Result
+	{
+		long steps;
+		double seconds;
+		double mass;
+		std::map<std::string, double> lengths;
+	};
+
+	// Tracks the rays through the geometry of the given vessel model
+	Result Measure(const std::string& model, long rays)
+	{
+		DetectorConstruction* detector = new DetectorConstruction();
+		detector->SetVesselModel(model);
+		G4VPhysicalVolume* world = detector->Construct();
+		G4GeometryManager::GetInstance()->CloseGeometry(true);
+
+		G4Navigator* navigator = new G4Navigator();
+		navigator->SetWorldVolume(world);
+
+		G4ThreeVector lower, upper;
+		detector->GetEnvelope(lower, upper);
+		const G4Box* worldBox = static_cast<const G4Box*>(world->GetLogicalVolume()->GetSolid());
+		G4double half[3] = { worldBox->GetXHalfLength() - 1*um, worldBox->GetYHalfLength() - 1*um, worldBox->GetZHalfLength() - 1*um };
+		G4double area[3] = { half[1]*half[2], half[0]*half[2], half[0]*half[1] };
+
+		// Same rays for every model
+		std::mt19937_64 engine(12345);
+		std::uniform_real_distribution<double> uniform(0., 1.);
+
+		Result result;
+		result.steps = 0;
+		result.seconds = 0.;
+		result.mass = detector->GetPressureVesselLogical()->GetMass()/kg;
+
+		for (long ray = 0; ray < rays; ++ray) {
+			// Start on a face of the World, aim at a point in the envelope
+			G4double face = uniform(engine)*(area[0] + area[1] + area[2]);
+			G4int axis = face < area[0] ? 0 : (face < area[0] + area[1] ? 1 : 2);
+			G4double start[3];
+			for (G4int i = 0; i < 3; ++i) start[i] = (2*uniform(engine) - 1)*half[i];
+			start[axis] = uniform(engine) < 0.5 ? -half[axis] : half[axis];
+			G4ThreeVector position(start[0], start[1], start[2]);
+			G4ThreeVector target(lower.x() + uniform(engine)*(upper.x() - lower.x()),
+								 lower.y() + uniform(engine)*(upper.y() - lower.y()),
+								 lower.z() + uniform(engine)*(upper.z() - lower.z()));
+			G4ThreeVector direction = (target - position).unit();
+
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			G4VPhysicalVolume* volume = navigator->LocateGlobalPointAndSetup(position, &direction, false, false);
+			while (volume) {
+				G4double safety = 0.;
+				G4double step = navigator->ComputeStep(position, direction, kInfinity, safety);
+				if (step == kInfinity) break;
+				result.lengths[volume->GetLogicalVolume()->GetMaterial()->GetName()] += step;
+				position += step*direction;
+				++result.steps;
+				navigator->SetGeometricallyLimitedStep();
+				volume = navigator->LocateGlobalPointAndSetup(position, &direction, true);
+			}
+			result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		}
+
+		G4GeometryManager::GetInstance()->OpenGeometry();
+		delete navigator;
+		delete detector;
+		return result;
+	}
+
+	// Runs one model in a child process; the geometry stores allow one
+	// detector construction per process
+	bool RunChild(const char* self, const std::string& model, long rays, Result& result)
+	{
+		std::string command = std::string(self) + " " + model + " " + std::to_string(rays);
+		FILE* pipe = popen(command.c_str(), "r");
+		if (!pipe) return false;
+
+		result.steps = 0;
+		char line[1024], name[512];
+		double value = 0.;
+		while (std::fgets(line, sizeof(line), pipe)) {
+			if (std::sscanf(line, "steps %lf", &value) == 1) result.steps = (long) value;
+			else if (std::sscanf(line, "seconds %lf", &value) == 1) result.seconds = value;
+			else if (std::sscanf(line, "mass %lf", &value) == 1) result.mass = value;
+			else if (std::sscanf(line, "length %511s %lf", name, &value) == 2) result.lengths[name] = value;
+		}
+		return pclose(pipe) == 0 && result.steps > 0;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc < 2 || argc > 3) {
+		std::cerr << "Usage: " << argv[0] << " compare|boolean|boxes [rays]" << std::endl;
+		return 1;
+	}
+	std::string mode = argv[1];
+	long rays = argc > 2 ? std::atol(argv[2]) : 100000;
+
+	if (mode == "boolean" || mode == "boxes") {
+		Result result = Measure(mode, rays);
+		std::printf("steps %ld\nseconds %.9g\nmass %.9g\n", result.steps, result.seconds, result.mass);
+		for (std::map<std::string, double>::const_iterator it = result.lengths.begin(); it != result.lengths.end(); ++it) {
+			std::printf("length %s %.12g\n", it->first.c_str(), it->second);
+		}
+		return 0;
+	}
+	if (mode != "compare") {
+		std::cerr << "Unknown mode " << mode << ", expected compare, boolean or boxes" << std::endl;
+		return 1;
+	}
+
+	Result before, after;
+	if (!RunChild(argv[0], "boolean", rays, before) || !RunChild(argv[0], "boxes", rays, after)) {
+		std::cerr << "Cannot run " << argv[0] << " for both models" << std::endl;
+		return 1;
+	}
+
+	std::printf("Rays: %ld\n", rays);
+	std::printf("%-10s %12s %12s %14s\n", "model", "steps", "ns/step", "vessel kg");
+	std::printf("%-10s %12ld %12.1f %14.6f\n", "boolean", before.steps, 1e9*before.seconds/before.steps, before.mass);
+	std::printf("%-10s %12ld %12.1f %14.6f\n", "boxes", after.steps, 1e9*after.seconds/after.steps, after.mass);
+
+	// Boolean and multi-union volumes are estimated by sampling, the track
+	// lengths are exact
+	std::printf("%-24s %16s %16s %12s\n", "material", "boolean mm", "boxes mm", "rel. diff");
+	double worst = 0.;
+	std::map<std::string, double> materials = before.lengths;
+	materials.insert(after.lengths.begin(), after.lengths.end());
+	for (std::map<std::string, double>::const_iterator it = materials.begin(); it != materials.end(); ++it) {
+		double a = before.lengths[it->first], b = after.lengths[it->first];
+		double diff = std::fabs(a - b)/std::max(std::max(a, b), 1e-300);
+		worst = std::max(worst, diff);
+		std::printf("%-24s %16.6f %16.6f %12.3g\n", it->first.c_str(), a, b, diff);
+	}
+	std::printf("Largest relative track length difference: %.3g\n", worst);
+	return worst < 1e-6 ? 0 : 2;
+}
@@ -0,0 +1,111 @@
+// ********************************************************************
+// physab.cc
+//
+// Description: A/B comparison of physics configurations. Runs the same
+//				seeded event sample once per configuration, each a comma-
+//				separated list of /AdEPTCubeSat/physics/addPhysics names,
+//				and prints events per second, steps per event and the
+//				distance of the gas energy deposit spectrum to that of the
+//				first (reference) configuration: chi-square per bin and
+//				the Kolmogorov-Smirnov distance of the normalised spectra.
+//				Items of a configuration that start with '/' are written
+//				to the macro as commands, e.g. to check a biased run
+//				against the analog reference; its weighted spectrum must
+//				agree within the errors, i.e. a chi-square per bin near 1.
+//
+// Usage:		physab <AdEPTCubeSat> <source macro> <events> <reference> [configuration ...]
+//				e.g. physab ./AdEPTCubeSat source.mac 100000 emstandard_opt4,pai emstandard,pai emstandard,nopai
+//				or   physab ./AdEPTCubeSat source.mac 100000 emstandard_opt4,pai "emstandard_opt4,pai,/AdEPTCubeSat/physics/biasGamma true"
+//
+//				The source macro holds the /gps commands of the sample.
+//
+// ********************************************************************
+
+#include "SimulationHarness.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace SimulationHarness;
+
+namespace
+{
+	const char* kSpectrum = "eDep_PVSensitiveGas";
+
+	struct Result
+	{
+		double eventsPerSecond;
+		double stepsPerEvent;
+		std::vector<Bin> spectrum;
+	};
+
+	std::string WriteConfigurationMacro(const std::string& name, const std::string& configuration,
+										const std::string& source, long events)
+	{
+		std::ostringstream preInit;
+		std::istringstream names(configuration);
+		std::string physics;
+		while (std::getline(names, physics, ',')) {
+			if (physics.empty()) continue;
+			if (physics[0] == '/') preInit << physics << "\n";
+			else preInit << "/AdEPTCubeSat/physics/addPhysics " << physics << "\n";
+		}
+		preInit << "/AdEPTCubeSat/output/countSteps true\n" << kSeededSample;
+		return WriteMacro(name, preInit.str(), "/control/execute " + source + "\n", events);
+	}
+
+	bool ReadResult(const std::string& name, Result& result)
+	{
+		KeyValues info;
+		ReadKeyValues(name + ".info", info);
+		result.eventsPerSecond = Number(info, "Events per Second");
+		result.stepsPerEvent = Number(info, "Steps per Event");
+
+		Histograms histograms;
+		ReadHistograms(name + "_hist.csv", histograms);
+		result.spectrum = histograms[kSpectrum];
+		return result.eventsPerSecond > 0. && !result.spectrum.empty();
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc < 5) {
+		std::cerr << "Usage: " << argv[0] << " <AdEPTCubeSat> <source macro> <events> <reference> [configuration ...]" << std::endl;
+		return 1;
+	}
+	std::string source = argv[2];
+	long events = std::atol(argv[3]);
+
+	std::vector<std::string> configurations;
+	std::vector<Result> results;
+	for (int i = 4; i < argc; ++i) {
+		std::ostringstream name;
+		name << "physab_" << i - 4;
+		std::string macro = WriteConfigurationMacro(name.str(), argv[i], source, events);
+		Result result;
+		if (!RunSimulation(argv[1], name.str(), macro) || !ReadResult(name.str(), result)) {
+			std::cerr << "Cannot run " << argv[i] << ", see " << name.str() << ".log" << std::endl;
+			return 1;
+		}
+		configurations.push_back(argv[i]);
+		results.push_back(result);
+	}
+
+	std::printf("Events: %ld from %s, same seeds for every configuration\n", events, source.c_str());
+	std::printf("%-36s %12s %10s %10s %10s %10s\n", "configuration", "events/s", "speed-up", "steps/ev",
+				"chi2/bin", "KS");
+	for (size_t i = 0; i < results.size(); ++i) {
+		std::printf("%-36s %12.1f %10.2f %10.1f %10.3f %10.4f%s\n", configurations[i].c_str(),
+					results[i].eventsPerSecond, results[i].eventsPerSecond/results[0].eventsPerSecond,
+					results[i].stepsPerEvent, ChiSquarePerBin(results[0].spectrum, results[i].spectrum),
+					KolmogorovDistance(results[0].spectrum, results[i].spectrum), i == 0 ? "  (reference)" : "");
+	}
+	return 0;
+}
@@ -0,0 +1,82 @@
+// ********************************************************************
+// physbench.cc
+//
+// Description: Start-up time and resident memory of the physics
+//				configurations of /AdEPTCubeSat/physics/hadronic. For each
+//				configuration the simulation is initialized and runs a few
+//				primaries of the given species, and the initialization
+//				report and the warnings about missing processes are read
+//				from its output.
+//
+// Usage:		physbench <AdEPTCubeSat> [particle] [energy MeV] [events]
+//
+// ********************************************************************
+
+#include "SimulationHarness.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace SimulationHarness;
+
+namespace
+{
+	struct Result
+	{
+		StartUp startUp;
+		bool missing;			// Code013 warning about the primary
+		std::string physics;
+	};
+
+	bool ReadResult(const std::string& name, Result& result)
+	{
+		KeyValues log;
+		ReadKeyValues(name + ".log", log);
+		KeyValues::const_iterator physics = log.find("Physics configuration");
+		result.physics = physics != log.end() ? physics->second : "";
+
+		// The warning about the primary, anywhere in the log
+		result.missing = false;
+		std::ifstream in((name + ".log").c_str());
+		std::string line;
+		while (!result.missing && std::getline(in, line)) result.missing = line.find("Code013") != std::string::npos;
+		return ReadStartUp(log, result.startUp);
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc < 2 || argc > 5) {
+		std::cerr << "Usage: " << argv[0] << " <AdEPTCubeSat> [particle] [energy MeV] [events]" << std::endl;
+		return 1;
+	}
+	std::string particle = argc > 2 ? argv[2] : "gamma";
+	double energy = argc > 3 ? std::atof(argv[3]) : 1.;
+	long events = argc > 4 ? std::atol(argv[4]) : 100;
+
+	const char* configurations[] = { "QGSP_BIC_HP", "FTFP_BERT_HP", "auto", "none" };
+	std::printf("Primaries: %ld %s of %g MeV\n", events, particle.c_str(), energy);
+	std::printf("%-14s %10s %10s %12s %12s %8s  %s\n", "hadronic", "init s", "tables s", "resident MB",
+				"peak MB", "missing", "physics");
+	int failed = 0;
+	for (int i = 0; i < 4; ++i) {
+		std::string name = std::string("physbench_") + configurations[i];
+		std::string preInit = std::string("/AdEPTCubeSat/physics/hadronic ") + configurations[i] + "\n"
+							  + "/AdEPTCubeSat/physics/primaries " + particle + "\n";
+		std::string macro = WriteMacro(name, preInit, PointSource(particle, energy, "MeV", true), events);
+		Result result;
+		if (!RunSimulation(argv[1], name, macro) || !ReadResult(name, result)) {
+			std::printf("%-14s failed, see %s.log\n", configurations[i], name.c_str());
+			++failed;
+			continue;
+		}
+		std::printf("%-14s %10.3f %10.3f %12.1f %12.1f %8s  %s\n", configurations[i], result.startUp.initialize,
+					result.startUp.tables, result.startUp.resident, result.startUp.peak, result.missing ? "yes" : "no", result.physics.c_str());
+	}
+	return failed > 0 ? 1 : 0;
+}
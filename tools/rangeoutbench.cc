@@ -0,0 +1,106 @@
+// ********************************************************************
+// rangeoutbench.cc
+//
+// Description: Validation of /AdEPTCubeSat/physics/rangeOut. Runs the
+//				simulation twice with electrons started in the sensitive
+//				gas, with full PAI tracking and with the range-out model,
+//				and compares the deposit and track length spectra of the
+//				_hist.csv files and the event rates of the info files.
+//
+// Usage:		rangeoutbench <AdEPTCubeSat> [events] [energy keV] [voxel mm]
+//
+// ********************************************************************
+
+#include "SimulationHarness.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace SimulationHarness;
+
+namespace
+{
+	struct Result
+	{
+		double eventsPerSecond;
+		double runTime;
+		long rangedOut;
+		Histograms histograms;
+	};
+
+	bool ReadResult(const std::string& name, Result& result)
+	{
+		KeyValues info;
+		ReadKeyValues(name + ".info", info);
+		result.eventsPerSecond = Number(info, "Events per Second");
+		result.runTime = Number(info, "Run Time");
+		result.rangedOut = (long) Number(info, "Ranged Out Electrons");
+		return ReadHistograms(name + "_hist.csv", result.histograms) && result.runTime > 0.;
+	}
+
+	bool RunRangeOut(const char* executable, const std::string& name, bool rangeOut, long events, double energy, double voxel, Result& result)
+	{
+		std::ostringstream preInit;
+		preInit << "/AdEPTCubeSat/physics/rangeOut " << (rangeOut ? "true" : "false") << "\n"
+				<< "/AdEPTCubeSat/physics/rangeOutVoxel " << voxel << " mm\n";
+		std::string macro = WriteMacro(name, preInit.str(), PointSource("e-", energy, "keV", true), events);
+		return RunSimulation(executable, name, macro) && ReadResult(name, result);
+	}
+
+	// Mean from the bin centres, under- and overflow excluded
+	double Mean(const std::vector<Bin>& bins)
+	{
+		double sum = 0., sumw = 0.;
+		for (size_t i = 1; i + 1 < bins.size(); ++i) {
+			sum += 0.5*(bins[i].low + bins[i].high)*bins[i].sumw;
+			sumw += bins[i].sumw;
+		}
+		return sumw > 0. ? sum/sumw : 0.;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc < 2 || argc > 5) {
+		std::cerr << "Usage: " << argv[0] << " <AdEPTCubeSat> [events] [energy keV] [voxel mm]" << std::endl;
+		return 1;
+	}
+	long events = argc > 2 ? std::atol(argv[2]) : 100000;
+	double energy = argc > 3 ? std::atof(argv[3]) : 50.;
+	double voxel = argc > 4 ? std::atof(argv[4]) : 1.;
+
+	Result full, fast;
+	if (!RunRangeOut(argv[1], "rangeout_full", false, events, energy, voxel, full)
+		|| !RunRangeOut(argv[1], "rangeout_fast", true, events, energy, voxel, fast)) {
+		std::cerr << "Cannot run " << argv[1] << ", see rangeout_full.log and rangeout_fast.log" << std::endl;
+		return 1;
+	}
+
+	std::printf("Electrons: %ld of %g keV at the centre of the sensitive gas, voxel %g mm\n", events, energy, voxel);
+	std::printf("%-10s %12s %14s %14s\n", "tracking", "run time s", "events/s", "ranged out");
+	std::printf("%-10s %12.2f %14.1f %14ld\n", "full", full.runTime, full.eventsPerSecond, full.rangedOut);
+	std::printf("%-10s %12.2f %14.1f %14ld\n", "rangeOut", fast.runTime, fast.eventsPerSecond, fast.rangedOut);
+	if (full.eventsPerSecond > 0.) std::printf("Speed-up: %.2f\n", fast.eventsPerSecond/full.eventsPerSecond);
+
+	// Per-species spectra are dominated by the same electrons and add nothing
+	const char* compared[] = { "eDep_PVSensitiveGas", "trackLength_PVSensitiveGas" };
+	double worst = 0.;
+	std::printf("%-28s %14s %14s %12s\n", "histogram", "full mean", "rangeOut mean", "chi2/bin");
+	for (int h = 0; h < 2; ++h) {
+		const std::vector<Bin>& a = full.histograms[compared[h]];
+		const std::vector<Bin>& b = fast.histograms[compared[h]];
+		double chi2 = ChiSquarePerBin(a, b);
+		worst = std::max(worst, chi2);
+		std::printf("%-28s %14.6g %14.6g %12.3f\n", compared[h], Mean(a), Mean(b), chi2);
+	}
+
+	// Statistically compatible spectra give about 1 per bin
+	return worst < 2. ? 0 : 2;
+}
@@ -0,0 +1,217 @@
+// ********************************************************************
+// recordbench.cc
+//
+// Description: Cost per event of the gas totals: the preallocated
+//				GasEventRecord filled by SensitiveGasSD and read in place by
+//				Run, against the former path of eleven G4THitsMap
+//				collections that G4MultiFunctionalDetector created and
+//				filled for every event and Run walked to sum one value per
+//				map. The steps are synthetic and the same for both paths:
+//				a fraction of the events reaches the gas with a number of
+//				steps of random species, the others leave nothing.
+//
+// Usage:		recordbench [events] [fraction reaching the gas] [steps per gas event]
+//
+// ********************************************************************
+
+#include "GasEventRecord.hh"
+#include "G4THitsMap.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Synthetic steps are drawn for this many events and reused
+	const int kSampleEvents = 4096;
+
+	struct Step
+	{
+		int species;		// GasScoring::Species or -1
+		double eDep;
+		double length;
+		bool exits;			// Last step of a passage through the volume
+		bool newSecondary;	// First step of a secondary
+	};
+
+	struct Event
+	{
+		size_t firstStep;
+		size_t numSteps;
+	};
+
+	double Seconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+	// The former scoring: one primitive per quantity, each with its own map
+	enum Primitive { kEDep = 0, kEDepP, kEDepE, kEDepT, kEDepPro, kTrackLength,
+					 kSecE, kSecPh, kSecP, kSecT, kSecPro, kNumPrimitives };
+
+	struct PrimitiveEntry
+	{
+		const char* name;
+		int filter;			// Species accepted, -1 for all
+		bool energy;		// G4PSEnergyDeposit, else G4PSNofSecondary
+	};
+
+	const PrimitiveEntry kPrimitives[kNumPrimitives] = {
+		{ "eDep",				-1,						true },
+		{ "eDepP",				GasScoring::kPositron,	true },
+		{ "eDepE",				GasScoring::kElectron,	true },
+		{ "eDepT",				GasScoring::kTriton,	true },
+		{ "eDepPro",			GasScoring::kProton,	true },
+		{ "trackLengthPassage",	-1,						false },
+		{ "secondaryElectrons",	GasScoring::kElectron,	false },
+		{ "secondaryPhotons",	GasScoring::kPhoton,	false },
+		{ "secondaryPositrons",	GasScoring::kPositron,	false },
+		{ "secondaryTritons",	GasScoring::kTriton,	false },
+		{ "secondaryProtons",	GasScoring::kProton,	false }
+	};
+
+	double MapEvent(const std::vector<Step>& steps, const Event& event)
+	{
+		// The detector makes new maps for every event, in its Initialize
+		G4THitsMap<G4double>* maps[kNumPrimitives];
+		for (int p = 0; p < kNumPrimitives; ++p) {
+			maps[p] = new G4THitsMap<G4double>("PVSensitiveGas", kPrimitives[p].name);
+		}
+
+		// Every step is offered to every primitive and its filter
+		double passage = 0.;
+		for (size_t s = event.firstStep; s < event.firstStep + event.numSteps; ++s) {
+			const Step& step = steps[s];
+			for (int p = 0; p < kNumPrimitives; ++p) {
+				if (kPrimitives[p].filter >= 0 && kPrimitives[p].filter != step.species) continue;
+				G4double value = 0.;
+				if (p == kTrackLength) {
+					passage += step.length;
+					if (!step.exits) continue;
+					value = passage;
+					passage = 0.;
+				} else if (kPrimitives[p].energy) {
+					if (step.eDep == 0.) continue;
+					value = step.eDep;
+				} else {
+					if (!step.newSecondary) continue;
+					value = 1.;
+				}
+				maps[p]->add(0, value);
+			}
+		}
+
+		// Run sums each map, including the events that missed the gas
+		double sum = 0.;
+		for (int p = 0; p < kNumPrimitives; ++p) {
+			std::map<G4int, G4double*>::iterator itr;
+			for (itr = maps[p]->GetMap()->begin(); itr != maps[p]->GetMap()->end(); itr++) {
+				sum += *(itr->second);
+			}
+			delete maps[p];
+		}
+		return sum;
+	}
+
+	//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+	double RecordEvent(const std::vector<Step>& steps, const Event& event, GasEventRecord& record)
+	{
+		// Only events that wrote into the record clear it
+		if (record.touched) record.Reset();
+
+		double passage = 0.;
+		for (size_t s = event.firstStep; s < event.firstStep + event.numSteps; ++s) {
+			const Step& step = steps[s];
+			record.touched = true;
+			if (step.eDep > 0.) {
+				record.eDep += step.eDep;
+				if (step.species >= 0 && GasScoring::kSpeciesTable[step.species].scoreEDep) {
+					record.eDepSpecies[step.species] += step.eDep;
+				}
+			}
+			passage += step.length;
+			if (step.exits) {
+				record.trackLengthPassage += passage;
+				passage = 0.;
+			}
+			if (step.newSecondary && step.species >= 0 && GasScoring::kSpeciesTable[step.species].scoreSecondaries) {
+				record.nSecondaries[step.species] += 1.;
+			}
+		}
+
+		// Run returns at once when nothing reached the gas
+		if (!record.touched) return 0.;
+		double sum = record.eDep + record.trackLengthPassage;
+		for (int i = 0; i < GasScoring::kNumSpecies; ++i) {
+			sum += record.eDepSpecies[i] + record.nSecondaries[i];
+		}
+		return sum;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc > 4) {
+		std::cerr << "Usage: " << argv[0] << " [events] [fraction reaching the gas] [steps per gas event]" << std::endl;
+		return 1;
+	}
+	long events = argc > 1 ? std::atol(argv[1]) : 2000000;
+	double fraction = argc > 2 ? std::atof(argv[2]) : 0.05;
+	int stepsPerEvent = argc > 3 ? std::atoi(argv[3]) : 20;
+
+	// Species as in a gamma run: mostly electrons, few of the others
+	std::mt19937 engine(12345);
+	std::uniform_real_distribution<double> uniform(0., 1.);
+	std::discrete_distribution<int> species({ 0.05, 0.80, 0.05, 0.05, 0.0, 0.05 });
+	std::vector<Step> steps;
+	std::vector<Event> sample(kSampleEvents);
+	for (int e = 0; e < kSampleEvents; ++e) {
+		sample[e].firstStep = steps.size();
+		sample[e].numSteps = uniform(engine) < fraction ? stepsPerEvent : 0;
+		for (size_t s = 0; s < sample[e].numSteps; ++s) {
+			Step step;
+			step.species = species(engine) - 1;
+			step.eDep = uniform(engine) < 0.8 ? uniform(engine) : 0.;
+			step.length = uniform(engine);
+			step.exits = uniform(engine) < 0.2;
+			step.newSecondary = uniform(engine) < 0.1;
+			steps.push_back(step);
+		}
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	double mapSum = 0.;
+	for (long e = 0; e < events; ++e) mapSum += MapEvent(steps, sample[e % kSampleEvents]);
+	double mapTime = Seconds(start);
+
+	GasEventRecord record;
+	record.Reset();
+	start = std::chrono::steady_clock::now();
+	double recordSum = 0.;
+	for (long e = 0; e < events; ++e) recordSum += RecordEvent(steps, sample[e % kSampleEvents], record);
+	double recordTime = Seconds(start);
+
+	std::printf("Events: %ld  reaching the gas: %.3f  steps per gas event: %d\n", events, fraction, stepsPerEvent);
+	std::printf("  hits maps  %12.0f events/s  %8.1f ns/event  (checksum %.6g)\n", events/mapTime, 1e9*mapTime/events, mapSum);
+	std::printf("  record     %12.0f events/s  %8.1f ns/event  (checksum %.6g)\n", events/recordTime, 1e9*recordTime/events, recordSum);
+	std::printf("  speed-up   %12.1f\n", mapTime/recordTime);
+
+	// Both paths must score the same totals
+	if (std::fabs(mapSum - recordSum) > 1e-9*std::max(std::fabs(mapSum), 1.)) {
+		std::printf("Checksums differ by %.6g\n", mapSum - recordSum);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,75 @@
+// ********************************************************************
+// rngbench.cc
+//
+// Description: Cost of the random engines selectable with
+//				/AdEPTCubeSat/random/engine: time per random number and
+//				per reseeding, as done once per event
+//
+// Usage:		rngbench [numbers per event] [events]
+//
+// ********************************************************************
+
+#include "G4Version.hh"
+#include "CLHEP/Random/RanecuEngine.h"
+#include "CLHEP/Random/RanluxEngine.h"
+#if G4VERSION_NUMBER >= 1030
+#include "CLHEP/Random/MixMaxRng.h"
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+	double Seconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void Measure(const char* name, CLHEP::HepRandomEngine* engine, long numbersPerEvent, long events)
+	{
+		long seeds[3] = { 0, 0, 0 };
+		double sum = 0.;
+		double seedTime = 0.;
+		double flatTime = 0.;
+		for (long event = 0; event < events; ++event) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			seeds[0] = 1 + event;
+			seeds[1] = 1 + (event*2654435761L & 0x7fffffffL);
+			engine->setSeeds(seeds, -1);
+			seedTime += Seconds(start);
+
+			start = std::chrono::steady_clock::now();
+			for (long i = 0; i < numbersPerEvent; ++i) sum += engine->flat();
+			flatTime += Seconds(start);
+		}
+		std::printf("  %-8s %8.2f ns/number  %10.1f ns/reseed  (checksum %.3f)\n", name,
+					1e9*flatTime/(numbersPerEvent*events), 1e9*seedTime/events, sum/(numbersPerEvent*events));
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc > 3) {
+		std::cerr << "Usage: " << argv[0] << " [numbers per event] [events]" << std::endl;
+		return 1;
+	}
+	long numbersPerEvent = argc > 1 ? std::atol(argv[1]) : 10000;
+	long events = argc > 2 ? std::atol(argv[2]) : 2000;
+
+	std::cout << "Numbers per event: " << numbersPerEvent << "  events: " << events << std::endl;
+
+	CLHEP::RanecuEngine ranecu;
+	Measure("Ranecu", &ranecu, numbersPerEvent, events);
+#if G4VERSION_NUMBER >= 1030
+	CLHEP::MixMaxRng mixmax;
+	Measure("MixMax", &mixmax, numbersPerEvent, events);
+#endif
+	CLHEP::RanluxEngine ranlux;
+	Measure("Ranlux", &ranlux, numbersPerEvent, events);
+	return 0;
+}
@@ -0,0 +1,135 @@
+// ********************************************************************
+// schedbench.cc
+//
+// Description: Thread utilization of the event scheduling from 1 to 128
+//				threads. The runs are simulated, so that any thread count
+//				can be measured on any machine: events with the cost
+//				spread of a proton run are handed out in batches under a
+//				lock, either with the fixed eventModulo of G4MTRunManager
+//				(sqrt(events/threads)) or with the adaptive BatchPolicy.
+//				Utilization is the event time over threads x wall time.
+//
+// Usage:		schedbench [events] [max threads] [lock time per batch, us]
+//
+// ********************************************************************
+
+#include "BatchPolicy.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Most primaries miss or pass the gas quickly, some start a shower
+	std::vector<double> EventCosts(long events)
+	{
+		std::mt19937_64 engine(12345);
+		std::uniform_real_distribution<double> uniform(0., 1.);
+		std::lognormal_distribution<double> shower(std::log(2e-3), 1.5);
+		std::vector<double> costs(events);
+		for (long i = 0; i < events; ++i) costs[i] = uniform(engine) < 0.9 ? 20e-6*(0.5 + uniform(engine)) : shower(engine);
+		return costs;
+	}
+
+	struct Result
+	{
+		double wallTime;
+		double utilization;
+		long batches;
+	};
+
+	// Event loop of the given number of threads; a fixed modulo of zero
+	// selects the adaptive policy
+	Result Simulate(const std::vector<double>& costs, int threads, long modulo, double lockTime)
+	{
+		BatchPolicy policy;
+		policy.BeginRun(costs.size(), threads);
+
+		typedef std::pair<double, int> Request;
+		std::priority_queue< Request, std::vector<Request>, std::greater<Request> > requests;
+		for (int t = 0; t < threads; ++t) requests.push(Request(0., t));
+
+		// Batch time of each thread, measured when it asks for the next batch
+		std::vector<double> batchWork(threads, 0.);
+		std::vector<long> batchEvents(threads, 0);
+
+		long next = 0;
+		long batches = 0;
+		double lockFree = 0., wallTime = 0., busy = 0.;
+		while (!requests.empty()) {
+			double time = requests.top().first;
+			int thread = requests.top().second;
+			requests.pop();
+
+			policy.AddSample(batchWork[thread], batchEvents[thread]);
+
+			// Batches are handed out one at a time
+			double start = std::max(time, lockFree);
+			lockFree = start + lockTime;
+			long remaining = (long) costs.size() - next;
+			long batch = modulo > 0 ? std::min(modulo, remaining) : policy.NextBatch(remaining);
+			if (batch <= 0) {
+				wallTime = std::max(wallTime, lockFree);
+				continue;
+			}
+
+			double work = 0.;
+			for (long i = next; i < next + batch; ++i) work += costs[i];
+			next += batch;
+			++batches;
+			busy += work;
+			batchWork[thread] = work;
+			batchEvents[thread] = batch;
+			requests.push(Request(lockFree + work, thread));
+		}
+
+		Result result;
+		result.wallTime = wallTime;
+		result.utilization = wallTime > 0. ? busy/(threads*wallTime) : 0.;
+		result.batches = batches;
+		return result;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc > 4) {
+		std::cerr << "Usage: " << argv[0] << " [events] [max threads] [lock time per batch, us]" << std::endl;
+		return 1;
+	}
+	long events = argc > 1 ? std::atol(argv[1]) : 200000;
+	int maxThreads = argc > 2 ? std::atoi(argv[2]) : 128;
+	double lockTime = (argc > 3 ? std::atof(argv[3]) : 2.)*1e-6;
+
+	std::vector<double> costs = EventCosts(events);
+	double total = 0., longest = 0.;
+	for (size_t i = 0; i < costs.size(); ++i) {
+		total += costs[i];
+		longest = std::max(longest, costs[i]);
+	}
+	std::printf("Events: %ld  event time: %.1f s  longest event: %.2f s  lock/batch: %.1f us\n",
+				events, total, longest, lockTime*1e6);
+	std::printf("%8s  %8s  %28s  %28s\n", "", "", "fixed eventModulo", "adaptive");
+	std::printf("%8s  %8s  %8s %8s %10s  %8s %8s %10s\n", "threads", "best s", "wall s", "util %", "batches", "wall s", "util %", "batches");
+
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		long modulo = std::max(1L, (long) std::sqrt((double) events/threads));
+		Result fixed = Simulate(costs, threads, modulo, lockTime);
+		Result adaptive = Simulate(costs, threads, 0, lockTime);
+		// No schedule ends before the longest event or the mean load per thread
+		double best = std::max(longest, total/threads);
+		std::printf("%8d  %8.2f  %8.2f %8.1f %10ld  %8.2f %8.1f %10ld\n", threads, best,
+					fixed.wallTime, 100.*fixed.utilization, fixed.batches,
+					adaptive.wallTime, 100.*adaptive.utilization, adaptive.batches);
+	}
+	return 0;
+}
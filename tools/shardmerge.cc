@@ -0,0 +1,412 @@
+// ********************************************************************
+// shardmerge.cc
+//
+// Description: Combines the output of the shards (or event ranges) of one
+//				segmented run into the result of a single process: the
+//				per-event rows ordered by eventID, the summed run
+//				histograms and the summed run information
+//
+// Usage:		shardmerge rows <output.csv|output.aecol> <input>...
+//				shardmerge hist <output_hist.csv> <input_hist.csv>...
+//				shardmerge info <output.info> <input.info>...
+//
+//				Row inputs are CSV (.csv) or columnar (.aecol) files with
+//				the same columns, e.g. all per-thread files of all shards.
+//
+// ********************************************************************
+
+#include "ColumnarFile.hh"
+#include "RowWriter.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	bool EndsWith(const std::string& text, const std::string& suffix)
+	{
+		return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	std::string Trim(const std::string& text)
+	{
+		size_t begin = text.find_first_not_of(" \t\r\n");
+		if (begin == std::string::npos) return "";
+		size_t end = text.find_last_not_of(" \t\r\n");
+		return text.substr(begin, end - begin + 1);
+	}
+
+	// Local time written by ctime() into the info files, -1 if unreadable
+	std::time_t ParseTime(const std::string& text)
+	{
+		std::tm time;
+		std::memset(&time, 0, sizeof(time));
+		std::istringstream in(text);
+		in >> std::get_time(&time, "%a %b %d %H:%M:%S %Y");
+		if (in.fail()) return (std::time_t) -1;
+		time.tm_isdst = -1;
+		return std::mktime(&time);
+	}
+
+	//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+	// Sequential reader of the rows of one CSV or columnar file
+	class RowSource
+	{
+		public:
+			virtual ~RowSource() {}
+			virtual bool Open(const std::string& fileName) = 0;
+			virtual bool Next(std::vector<double>& row) = 0;
+
+			const std::vector<Columnar::Column>& GetColumns() const { return fColumns; }
+
+		protected:
+			std::vector<Columnar::Column> fColumns;
+	};
+
+	class CsvSource : public RowSource
+	{
+		public:
+			virtual bool Open(const std::string& fileName)
+			{
+				fIn.open(fileName.c_str());
+				if (!fIn) return false;
+
+				// Header comments as written by g4csv and CsvRowWriter
+				while (fIn.peek() == '#') {
+					std::string line;
+					std::getline(fIn, line);
+					std::istringstream header(line);
+					std::string tag, type, name;
+					header >> tag >> type;
+					if (tag != "#column") continue;
+					std::getline(header, name);
+					Columnar::Column column;
+					column.name = Trim(name);
+					column.type = (type == "int") ? Columnar::kInt : Columnar::kDouble;
+					fColumns.push_back(column);
+				}
+				return !fColumns.empty();
+			}
+
+			virtual bool Next(std::vector<double>& row)
+			{
+				std::string line;
+				while (std::getline(fIn, line)) {
+					if (line.empty()) continue;
+					row.assign(fColumns.size(), 0.);
+					const char* text = line.c_str();
+					for (size_t i = 0; i < fColumns.size(); ++i) {
+						char* end = 0;
+						row[i] = std::strtod(text, &end);
+						text = (*end == ',') ? end + 1 : end;
+					}
+					return true;
+				}
+				return false;
+			}
+
+		private:
+			std::ifstream fIn;
+	};
+
+	class ColumnarSource : public RowSource
+	{
+		public:
+			ColumnarSource() : fChunk(0), fRow(0) {}
+
+			virtual bool Open(const std::string& fileName)
+			{
+				if (!fReader.Open(fileName)) return false;
+				fColumns = fReader.GetColumns();
+				return true;
+			}
+
+			virtual bool Next(std::vector<double>& row)
+			{
+				while (fValues.empty() || fRow >= fValues[0].size()) {
+					if (fChunk >= fReader.GetChunks().size() || !fReader.ReadChunk(fChunk++, fValues)) return false;
+					fRow = 0;
+				}
+				row.resize(fColumns.size());
+				for (size_t i = 0; i < fColumns.size(); ++i) row[i] = fValues[i][fRow];
+				++fRow;
+				return true;
+			}
+
+		private:
+			ColumnarReader fReader;
+			std::vector< std::vector<double> > fValues;
+			size_t fChunk;
+			size_t fRow;
+	};
+
+	//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+	// k-way merge of the inputs by eventID. Each input holds the rows of one
+	// thread or one merged run, both ordered by eventID.
+	int MergeRows(const std::string& outputName, const std::vector<std::string>& inputNames)
+	{
+		std::vector<RowSource*> sources;
+		for (size_t i = 0; i < inputNames.size(); ++i) {
+			RowSource* source = EndsWith(inputNames[i], ".aecol") ? (RowSource*) new ColumnarSource() : new CsvSource();
+			if (!source->Open(inputNames[i])) {
+				std::cerr << "Cannot read rows of " << inputNames[i] << std::endl;
+				return 1;
+			}
+			sources.push_back(source);
+		}
+
+		// All inputs must have the columns of the first
+		const std::vector<Columnar::Column>& columns = sources[0]->GetColumns();
+		int eventIDColumn = -1;
+		for (size_t i = 0; i < columns.size(); ++i) {
+			if (columns[i].name == "eventID") eventIDColumn = i;
+		}
+		for (size_t s = 1; s < sources.size(); ++s) {
+			const std::vector<Columnar::Column>& other = sources[s]->GetColumns();
+			bool same = other.size() == columns.size();
+			for (size_t i = 0; same && i < columns.size(); ++i) same = other[i].name == columns[i].name;
+			if (!same) {
+				std::cerr << "Columns of " << inputNames[s] << " differ from " << inputNames[0] << std::endl;
+				return 1;
+			}
+		}
+		if (eventIDColumn < 0) {
+			std::cerr << "No eventID column in " << inputNames[0] << std::endl;
+			return 1;
+		}
+
+		RowWriter* writer = 0;
+		if (EndsWith(outputName, ".aecol")) {
+			ColumnarWriter* columnarWriter = new ColumnarWriter();
+			for (size_t i = 0; i < columns.size(); ++i) columnarWriter->AddColumn(columns[i].name, columns[i].type);
+			writer = columnarWriter;
+		} else {
+			CsvRowWriter* csvWriter = new CsvRowWriter();
+			for (size_t i = 0; i < columns.size(); ++i) csvWriter->AddColumn(columns[i].name, columns[i].type == Columnar::kInt);
+			writer = csvWriter;
+		}
+		if (!writer->Open(outputName)) {
+			std::cerr << "Cannot write " << outputName << std::endl;
+			return 1;
+		}
+
+		// Smallest eventID first
+		typedef std::pair<double, size_t> Entry;
+		std::priority_queue< Entry, std::vector<Entry>, std::greater<Entry> > queue;
+		std::vector< std::vector<double> > heads(sources.size());
+		for (size_t s = 0; s < sources.size(); ++s) {
+			if (sources[s]->Next(heads[s])) queue.push(Entry(heads[s][eventIDColumn], s));
+		}
+
+		long rows = 0;
+		bool ordered = true;
+		while (!queue.empty()) {
+			size_t s = queue.top().second;
+			double eventID = queue.top().first;
+			queue.pop();
+			writer->Fill(&heads[s][0]);
+			++rows;
+			if (sources[s]->Next(heads[s])) {
+				if (heads[s][eventIDColumn] < eventID) ordered = false;
+				queue.push(Entry(heads[s][eventIDColumn], s));
+			}
+		}
+		writer->Close();
+		delete writer;
+		for (size_t s = 0; s < sources.size(); ++s) delete sources[s];
+
+		if (!ordered) std::cerr << "Warning: an input is not ordered by eventID, neither is the output" << std::endl;
+		std::cout << "Merged " << rows << " rows of " << inputNames.size() << " files into " << outputName << std::endl;
+		return 0;
+	}
+
+	//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+	// Sum of the histogram files written by GasHistograms::Write
+	int MergeHistograms(const std::string& outputName, const std::vector<std::string>& inputNames)
+	{
+		struct Bin
+		{
+			std::string low, high;
+			double sumw, sumw2;
+		};
+		// Rows are keyed by histogram and bin. Histograms keep the order of the
+		// single-process file: fixed histograms as they appear, then the
+		// response_<trueBin> blocks by true energy bin
+		std::map<std::string, long> histogramRank;
+		std::map< std::pair<long, long>, std::pair<std::string, Bin> > bins;
+		std::string header;
+
+		for (size_t f = 0; f < inputNames.size(); ++f) {
+			std::ifstream in(inputNames[f].c_str());
+			if (!in || !std::getline(in, header)) {
+				std::cerr << "Cannot read histograms of " << inputNames[f] << std::endl;
+				return 1;
+			}
+			std::string line;
+			while (std::getline(in, line)) {
+				std::vector<std::string> fields;
+				std::istringstream row(line);
+				std::string field;
+				while (std::getline(row, field, ',')) fields.push_back(field);
+				if (fields.size() != 6) continue;
+
+				const std::string& name = fields[0];
+				if (histogramRank.find(name) == histogramRank.end()) {
+					long rank = (long) histogramRank.size();
+					if (name.compare(0, 9, "response_") == 0) rank = 1000000 + std::atol(name.c_str() + 9);
+					histogramRank[name] = rank;
+				}
+				std::pair<long, long> key(histogramRank[name], std::atol(fields[1].c_str()));
+				std::map< std::pair<long, long>, std::pair<std::string, Bin> >::iterator it = bins.find(key);
+				if (it == bins.end()) {
+					Bin bin = { fields[2], fields[3], 0., 0. };
+					it = bins.insert(std::make_pair(key, std::make_pair(name, bin))).first;
+				}
+				it->second.second.sumw += std::strtod(fields[4].c_str(), 0);
+				it->second.second.sumw2 += std::strtod(fields[5].c_str(), 0);
+			}
+		}
+
+		std::ofstream out(outputName.c_str());
+		if (!out) {
+			std::cerr << "Cannot write " << outputName << std::endl;
+			return 1;
+		}
+		out.precision(10);
+		out << header << "\n";
+		for (std::map< std::pair<long, long>, std::pair<std::string, Bin> >::const_iterator it = bins.begin(); it != bins.end(); ++it) {
+			const Bin& bin = it->second.second;
+			out << it->second.first << "," << it->first.second << "," << bin.low << "," << bin.high << ","
+				<< bin.sumw << "," << bin.sumw2 << "\n";
+		}
+		std::cout << "Summed the histograms of " << inputNames.size() << " files into " << outputName << std::endl;
+		return 0;
+	}
+
+	//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+	// Combined run information of info files written by RunAction
+	int MergeInfo(const std::string& outputName, const std::vector<std::string>& inputNames)
+	{
+		double events = 0., sourceRays = 0., mergedRows = 0., runTime = 0., summedRunTime = 0.;
+		bool haveRays = false, haveRows = false;
+		std::string startTime, endTime, engine, seed;
+		std::time_t earliestStart = (std::time_t) -1, latestEnd = (std::time_t) -1;
+		double firstEvent = -1.;
+
+		for (size_t f = 0; f < inputNames.size(); ++f) {
+			std::ifstream in(inputNames[f].c_str());
+			if (!in) {
+				std::cerr << "Cannot read " << inputNames[f] << std::endl;
+				return 1;
+			}
+			std::string line;
+			while (std::getline(in, line)) {
+				size_t colon = line.find(':');
+				if (colon == std::string::npos || line.compare(0, 1, "=") == 0) continue;
+				std::string key = Trim(line.substr(0, colon));
+				std::string value = Trim(line.substr(colon + 1));
+				double number = std::strtod(value.c_str(), 0);
+
+				// The shards may run in any order, in parallel or one after another
+				if (key == "Start Time") {
+					std::time_t time = ParseTime(value);
+					if (startTime.empty() || (time != (std::time_t) -1 && (earliestStart == (std::time_t) -1 || time < earliestStart))) {
+						startTime = value;
+						earliestStart = time;
+					}
+				} else if (key == "End Time") {
+					std::time_t time = ParseTime(value);
+					if (endTime.empty() || (time != (std::time_t) -1 && (latestEnd == (std::time_t) -1 || time > latestEnd))) {
+						endTime = value;
+						latestEnd = time;
+					}
+				}
+				else if (key == "Number of Events") events += number;
+				else if (key == "Source Rays") { sourceRays += number; haveRays = true; }
+				else if (key == "Merged Rows") { mergedRows += number; haveRows = true; }
+				else if (key == "Run Time") {
+					summedRunTime += number;
+					if (number > runTime) runTime = number;
+				}
+				else if (key == "First Event" && (firstEvent < 0. || number < firstEvent)) firstEvent = number;
+				else if (key == "Random Engine" || key == "Master Seed") {
+					std::string& known = (key == "Random Engine") ? engine : seed;
+					if (!known.empty() && known != value) {
+						std::cerr << "Warning: " << inputNames[f] << " has " << key << " " << value
+								  << " instead of " << known << ", the shards are not of one run" << std::endl;
+					}
+					if (known.empty()) known = value;
+				}
+			}
+		}
+
+		std::ofstream out(outputName.c_str());
+		if (!out) {
+			std::cerr << "Cannot write " << outputName << std::endl;
+			return 1;
+		}
+		out.precision(12);
+		out << "============================    Simulation Information    ============================" << "\n";
+		out << "Shards: \t\t\t" << inputNames.size() << "\n";
+		out << "Start Time: \t\t" << startTime << "\n";
+		out << "End Time: \t\t\t" << endTime << "\n";
+		out << "============================    Source Information    ============================" << "\n";
+		out << "Number of Events: \t" << events << "\n";
+		if (haveRays && sourceRays > 0.) {
+			out << "Source Rays: \t\t" << sourceRays << "\n";
+			out << "Acceptance: \t\t" << events/sourceRays << "\n";
+		}
+		if (!engine.empty()) {
+			out << "Random Engine: \t\t" << engine << "\n";
+			out << "Master Seed: \t\t" << seed << "\n";
+			out << "First Event: \t\t" << firstEvent << "\n";
+		}
+		if (haveRows) out << "Merged Rows: \t\t" << mergedRows << "\n";
+		out << "============================    Performance Information    ============================" << "\n";
+		out << "Run Time: \t\t\t" << summedRunTime << " s (sum of the shards)" << "\n";
+		out << "Longest Shard: \t\t" << runTime << " s" << "\n";
+		if (summedRunTime > 0.) {
+			out << "Events per Second: \t" << events/summedRunTime << " (events over the summed run time)" << "\n";
+		}
+		out << "==================================================================================" << "\n";
+		std::cout << "Combined the run information of " << inputNames.size() << " files into " << outputName << std::endl;
+		return 0;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+	if (argc < 4) {
+		std::cerr << "Usage: " << argv[0] << " rows <output.csv|output.aecol> <input>..." << std::endl;
+		std::cerr << "       " << argv[0] << " hist <output_hist.csv> <input_hist.csv>..." << std::endl;
+		std::cerr << "       " << argv[0] << " info <output.info> <input.info>..." << std::endl;
+		return 1;
+	}
+
+	std::string mode = argv[1];
+	std::string outputName = argv[2];
+	std::vector<std::string> inputNames(argv + 3, argv + argc);
+
+	if (mode == "rows") return MergeRows(outputName, inputNames);
+	if (mode == "hist") return MergeHistograms(outputName, inputNames);
+	if (mode == "info") return MergeInfo(outputName, inputNames);
+
+	std::cerr << "Unknown mode " << mode << ", expected rows, hist or info" << std::endl;
+	return 1;
+}